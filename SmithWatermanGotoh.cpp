@@ -1,5 +1,15 @@
 #include "SmithWatermanGotoh.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// the avx kernel is compiled for the avx target and only used if the cpu supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define SW_BAND_AVX
+#include <immintrin.h>
+#endif
+
 const float CSmithWatermanGotoh::FLOAT_NEGATIVE_INFINITY = (float)-1e+30;
 
 const char CSmithWatermanGotoh::Directions_STOP     = 0;
@@ -7,6 +17,53 @@ const char CSmithWatermanGotoh::Directions_LEFT     = 1;
 const char CSmithWatermanGotoh::Directions_DIAGONAL = 2;
 const char CSmithWatermanGotoh::Directions_UP       = 3;
 
+// the number of padding floats after each band row, enough for one full vector of the widest kernel
+#define BAND_ROW_PADDING 8
+
+// fills the diagonal and vertical gap scores of a band row. Cell k of a row lies on the same
+// diagonal as cell k of the previous row and directly below cell k + 1 of the previous row, so
+// neither score depends on the rest of the current row.
+static void FillBandRowScalar(const float* pPreviousBest, const float* pPreviousGap, const float* pSimilarity, float* pDiagonal, float* pGap, const unsigned int bandLength, const float gapOpenPenalty, const float gapExtendPenalty) {
+	for(unsigned int k = 0; k < bandLength; k++) {
+		pDiagonal[k] = pPreviousBest[k] + pSimilarity[k];
+		const float gapExtendScore = pPreviousGap[k + 1] - gapExtendPenalty;
+		const float gapOpenScore   = pPreviousBest[k + 1] - gapOpenPenalty;
+		pGap[k] = (gapExtendScore > gapOpenScore ? gapExtendScore : gapOpenScore);
+	}
+}
+
+#if defined(__SSE2__)
+// fills a band row four cells at a time
+static void FillBandRowSse2(const float* pPreviousBest, const float* pPreviousGap, const float* pSimilarity, float* pDiagonal, float* pGap, const unsigned int bandLength, const float gapOpenPenalty, const float gapExtendPenalty) {
+	const __m128 gapOpen   = _mm_set1_ps(gapOpenPenalty);
+	const __m128 gapExtend = _mm_set1_ps(gapExtendPenalty);
+	for(unsigned int k = 0; k < bandLength; k += 4) {
+		_mm_storeu_ps(pDiagonal + k, _mm_add_ps(_mm_loadu_ps(pPreviousBest + k), _mm_loadu_ps(pSimilarity + k)));
+		const __m128 gapExtendScore = _mm_sub_ps(_mm_loadu_ps(pPreviousGap + k + 1), gapExtend);
+		const __m128 gapOpenScore   = _mm_sub_ps(_mm_loadu_ps(pPreviousBest + k + 1), gapOpen);
+		const __m128 extend         = _mm_cmpgt_ps(gapExtendScore, gapOpenScore);
+		_mm_storeu_ps(pGap + k, _mm_or_ps(_mm_and_ps(extend, gapExtendScore), _mm_andnot_ps(extend, gapOpenScore)));
+	}
+}
+#endif
+
+#if defined(SW_BAND_AVX)
+// fills a band row eight cells at a time
+__attribute__((target("avx")))
+static void FillBandRowAvx(const float* pPreviousBest, const float* pPreviousGap, const float* pSimilarity, float* pDiagonal, float* pGap, const unsigned int bandLength, const float gapOpenPenalty, const float gapExtendPenalty) {
+	const __m256 gapOpen   = _mm256_set1_ps(gapOpenPenalty);
+	const __m256 gapExtend = _mm256_set1_ps(gapExtendPenalty);
+	for(unsigned int k = 0; k < bandLength; k += 8) {
+		_mm256_storeu_ps(pDiagonal + k, _mm256_add_ps(_mm256_loadu_ps(pPreviousBest + k), _mm256_loadu_ps(pSimilarity + k)));
+		const __m256 gapExtendScore = _mm256_sub_ps(_mm256_loadu_ps(pPreviousGap + k + 1), gapExtend);
+		const __m256 gapOpenScore   = _mm256_sub_ps(_mm256_loadu_ps(pPreviousBest + k + 1), gapOpen);
+		const __m256 extend         = _mm256_cmp_ps(gapExtendScore, gapOpenScore, _CMP_GT_OQ);
+		_mm256_storeu_ps(pGap + k, _mm256_blendv_ps(gapOpenScore, gapExtendScore, extend));
+	}
+	_mm256_zeroupper();
+}
+#endif
+
 CSmithWatermanGotoh::CSmithWatermanGotoh(float matchScore, float mismatchScore, float gapOpenPenalty, float gapExtendPenalty) 
 : mCurrentMatrixSize(0)
 , mCurrentAnchorSize(0)
@@ -26,6 +83,16 @@ CSmithWatermanGotoh::CSmithWatermanGotoh(float matchScore, float mismatchScore,
 , mUseHomoPolymerGapOpenPenalty(false)
 {
 	CreateScoringMatrix();
+
+	// use the widest band row kernel that the cpu supports
+	mFillBandRow = FillBandRowScalar;
+#if defined(__SSE2__)
+	mFillBandRow = FillBandRowSse2;
+#endif
+#if defined(SW_BAND_AVX)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx")) mFillBandRow = FillBandRowAvx;
+#endif
 }
 
 CSmithWatermanGotoh::~CSmithWatermanGotoh(void) {
@@ -263,6 +330,15 @@ void CSmithWatermanGotoh::Align(unsigned int& referenceAl, string& refAl, string
 		}
 	}
 
+	// set the reference endpoint
+	referenceAl = ci;
+
+	FinishAlignment(refAl, queryAl, gappedAnchorLen, gappedQueryLen, numMismatches);
+}
+
+// reverses the traced back alignment and fixes the gap order
+void CSmithWatermanGotoh::FinishAlignment(string& refAl, string& queryAl, const int gappedAnchorLen, const int gappedQueryLen, const int numMismatches) {
+
 	// define the reference and query sequences
 	mReversedAnchor[gappedAnchorLen] = 0;
 	mReversedQuery[gappedQueryLen]   = 0;
@@ -277,80 +353,234 @@ void CSmithWatermanGotoh::Align(unsigned int& referenceAl, string& refAl, string
 	reverse(mReversedAnchor, mReversedAnchor + gappedAnchorLen);
 	reverse(mReversedQuery,  mReversedQuery  + gappedQueryLen);
 
-	//alignment.Reference = mReversedAnchor;
-	//alignment.Query     = mReversedQuery;
+	refAl   = mReversedAnchor;
+	queryAl = mReversedQuery;
 
-	// set the reference endpoints
-	//alignment.ReferenceBegin = ci;
-	//alignment.ReferenceEnd   = BestRow - 1;
-	referenceAl = ci;
+	// fix the gap order
+	CorrectHomopolymerGapOrder(gappedAnchorLen, numMismatches);
+}
+
+// aligns the query sequence to the reference, only filling the cells within bandWidth diagonals of the band
+// running from the top left to the bottom right of the matrix. The scores, traceback and tie breaking are
+// those of Align, so any alignment lying within the band is identical to the full alignment.
+void CSmithWatermanGotoh::BandedAlign(unsigned int& referenceAl, string& refAl, string& queryAl, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const unsigned int bandWidth) {
 
-	// set the query endpoints
-	/*  
-	if(alignment.IsReverseComplement) {
-		alignment.QueryBegin = s2Length - BestColumn;
-		alignment.QueryEnd   = s2Length - cj - 1;
-		// alignment.QueryLength= alignment.QueryBegin - alignment.QueryEnd + 1;
-	} else {
-		alignment.QueryBegin = cj;
-		alignment.QueryEnd   = BestColumn - 1;
-		// alignment.QueryLength= alignment.QueryEnd - alignment.QueryBegin + 1;
+	if((s1Length == 0) || (s2Length == 0)) {
+		cout << "ERROR: Found a read with a zero length." << endl;
+		exit(1);
 	}
-	*/
-
-	// set the query length and number of mismatches
-	//alignment.QueryLength = alignment.QueryEnd - alignment.QueryBegin + 1;
-	//alignment.NumMismatches  = numMismatches;
-
-	unsigned int alLength = strlen(mReversedAnchor);
-	unsigned int m = 0, d = 0, i = 0;
-	bool dashRegion = false;
-	ostringstream oCigar (ostringstream::out);
-	
-        // Determine the CIGAR string.
-        refAl = mReversedAnchor;
-        queryAl = mReversedQuery;
-//	if ( cj != 0 )
-//		oCigar << cj << 'S';
-//	
-//	for ( unsigned int j = 0; j < alLength; j++ ) {
-//		if ( ( mReversedAnchor[j] != GAP ) && ( mReversedQuery[j] != GAP ) ) {
-//			if ( dashRegion ) {
-//				if ( d != 0 ) oCigar << d << 'D';
-//				else          oCigar << i << 'I';
-//			}
-//			dashRegion = false;
-//			m++;
-//			d = 0;
-//			i = 0;
-//		} else {
-//			if ( !dashRegion )
-//				oCigar << m << 'M';
-//			dashRegion = true;
-//			m = 0;
-//			if ( mReversedAnchor[j] == GAP ) {
-//				if ( d != 0 ) oCigar << d << 'D';
-//				i++;
-//				d = 0;
-//			}
-//			else {
-//				if ( i != 0 ) oCigar << i << 'I';
-//				d++;
-//				i = 0;
-//			}
-//		}
-//	}
-//	if      ( m != 0 ) oCigar << m << 'M';
-//	else if ( d != 0 ) oCigar << d << 'D';
-//	else if ( i != 0 ) oCigar << i << 'I';
-//
-//	if ( BestColumn != s2Length )
-//		oCigar << s2Length - BestColumn << 'S';
-//
-//	string cigarAl = oCigar.str();
-	
-	// fix the gap order
-	CorrectHomopolymerGapOrder(alLength, numMismatches);
+
+	// the homo-polymer gap open penalty depends on the previous base, so use the full matrix
+	if(mUseHomoPolymerGapOpenPenalty) {
+		Align(referenceAl, refAl, queryAl, s1, s1Length, s2, s2Length);
+		return;
+	}
+
+	// cell k of row i lies on diagonal (query position - reference position) bandStart + k
+	const int lengthDifference      = (int)s2Length - (int)s1Length;
+	const int bandStart             = min(0, lengthDifference) - (int)bandWidth;
+	const int bandEnd               = max(0, lengthDifference) + (int)bandWidth;
+	const unsigned int bandLength   = bandEnd - bandStart + 1;
+	const unsigned int rowLength    = bandLength + BAND_ROW_PADDING + 1;
+	const unsigned int referenceLen = s1Length + 1;
+	const unsigned int sequenceSumLength = s1Length + s2Length;
+
+	// reinitialize our matrices
+	mBandPointers.resize(referenceLen * bandLength);
+	mBandVerticalGaps.resize(referenceLen * bandLength);
+	mBandHorizontalGaps.resize(referenceLen * bandLength);
+
+	// reinitialize our reference+query-dependent arrays
+	if(sequenceSumLength > mCurrentAQSumSize) {
+
+		// calculate the new reference array size
+		mCurrentAQSumSize = sequenceSumLength;
+
+		// delete the old arrays
+		if(mReversedAnchor) delete [] mReversedAnchor;
+		if(mReversedQuery)  delete [] mReversedQuery;
+
+		// initialize the arrays
+		try {
+
+			mReversedAnchor = new char[mCurrentAQSumSize + 1];	// reversed sequence #1
+			mReversedQuery  = new char[mCurrentAQSumSize + 1];	// reversed sequence #2
+
+		} catch(bad_alloc) {
+			cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
+			exit(1);
+		}
+	}
+
+	// build the query profile for each base in the reference. Row i reads the profile from column
+	// i + bandStart, so the profile is padded with zeros for the band cells outside the matrix
+	const int profileStart           = 1 + bandStart;
+	const unsigned int profileLength = s1Length + rowLength;
+	bool hasProfile[MOSAIK_NUM_NUCLEOTIDES];
+	fill(hasProfile, hasProfile + MOSAIK_NUM_NUCLEOTIDES, false);
+	mQueryProfile.resize(MOSAIK_NUM_NUCLEOTIDES * profileLength);
+
+	for(unsigned int i = 0; i < s1Length; i++) {
+		const unsigned int base = s1[i] - 'A';
+		if(hasProfile[base]) continue;
+
+		float* pProfile = &mQueryProfile[base * profileLength];
+		for(unsigned int p = 0; p < profileLength; p++) {
+			const int j = profileStart + (int)p;
+			pProfile[p] = ((j >= 1) && (j <= (int)s2Length)) ? mScoringMatrix[base][s2[j - 1] - 'A'] : 0.0f;
+		}
+		hasProfile[base] = true;
+	}
+
+	// initialize the score rows. Band cells outside the matrix or beyond the end of the band act as
+	// the first row and column of the matrix: a best score of zero and no gap to extend
+	mBandScores.resize(6 * rowLength);
+	float* pPreviousBest = &mBandScores[0];
+	float* pPreviousGap  = pPreviousBest + rowLength;
+	float* pCurrentBest  = pPreviousGap  + rowLength;
+	float* pCurrentGap   = pCurrentBest  + rowLength;
+	float* pDiagonal     = pCurrentGap   + rowLength;
+	float* pGap          = pDiagonal     + rowLength;
+	fill(pPreviousBest, pPreviousBest + rowLength, 0.0f);
+	fill(pPreviousGap,  pPreviousGap  + rowLength, FLOAT_NEGATIVE_INFINITY);
+	fill(pCurrentBest,  pCurrentBest  + rowLength, 0.0f);
+	fill(pCurrentGap,   pCurrentGap   + rowLength, FLOAT_NEGATIVE_INFINITY);
+
+	float totalSimilarityScore, queryGapScore, bestScore, leftBestScore;
+	float referenceGapExtendScore, referenceGapOpenScore, currentAnchorGapScore;
+
+	unsigned int BestColumn = 0;
+	unsigned int BestRow    = 0;
+	float BestScore         = FLOAT_NEGATIVE_INFINITY;
+
+	for(unsigned int i = 1; i < referenceLen; i++) {
+
+		// the diagonal and vertical gap scores only depend on the previous row
+		mFillBandRow(pPreviousBest, pPreviousGap, &mQueryProfile[(s1[i - 1] - 'A') * profileLength + i - 1], pDiagonal, pGap, bandLength, mGapOpenPenalty, mGapExtendPenalty);
+
+		char*  pPointers              = &mBandPointers[i * bandLength];
+		short* pVerticalGaps          = &mBandVerticalGaps[i * bandLength];
+		short* pHorizontalGaps        = &mBandHorizontalGaps[i * bandLength];
+		const short* pPreviousVerticalGaps = pVerticalGaps - bandLength;
+
+		currentAnchorGapScore = FLOAT_NEGATIVE_INFINITY;
+		leftBestScore         = 0.0f;
+
+		for(unsigned int k = 0; k < bandLength; k++) {
+			const int j = (int)i + bandStart + (int)k;
+
+			if((j < 1) || (j > (int)s2Length)) {
+				pCurrentBest[k]       = 0.0f;
+				pCurrentGap[k]        = FLOAT_NEGATIVE_INFINITY;
+				currentAnchorGapScore = FLOAT_NEGATIVE_INFINITY;
+				leftBestScore         = 0.0f;
+				continue;
+			}
+
+			totalSimilarityScore = pDiagonal[k];
+			queryGapScore        = pGap[k];
+
+			if(pPreviousGap[k + 1] - mGapExtendPenalty > pPreviousBest[k + 1] - mGapOpenPenalty)
+				pVerticalGaps[k] = (short)(pPreviousVerticalGaps[k + 1] + 1);
+			else pVerticalGaps[k] = 1;
+
+			referenceGapExtendScore = currentAnchorGapScore - mGapExtendPenalty;
+			referenceGapOpenScore   = leftBestScore - mGapOpenPenalty;
+
+			if(referenceGapExtendScore > referenceGapOpenScore) {
+				currentAnchorGapScore = referenceGapExtendScore;
+				pHorizontalGaps[k] = (short)(pHorizontalGaps[k - 1] + 1);
+			} else {
+				currentAnchorGapScore = referenceGapOpenScore;
+				pHorizontalGaps[k] = 1;
+			}
+
+			bestScore = MaxFloats(totalSimilarityScore, queryGapScore, currentAnchorGapScore);
+
+			// determine the traceback direction
+			if(bestScore == 0)                         pPointers[k] = Directions_STOP;
+			else if(bestScore == totalSimilarityScore) pPointers[k] = Directions_DIAGONAL;
+			else if(bestScore == queryGapScore)        pPointers[k] = Directions_UP;
+			else                                       pPointers[k] = Directions_LEFT;
+
+			// set the traceback start at the current cell i, j and score
+			if(bestScore > BestScore) {
+				BestRow    = i;
+				BestColumn = j;
+				BestScore  = bestScore;
+			}
+
+			pCurrentBest[k] = bestScore;
+			pCurrentGap[k]  = queryGapScore;
+			leftBestScore   = bestScore;
+		}
+
+		swap(pPreviousBest, pCurrentBest);
+		swap(pPreviousGap,  pCurrentGap);
+	}
+
+	//
+	// traceback
+	//
+
+	int gappedAnchorLen  = 0;   // length of sequence #1 after alignment
+	int gappedQueryLen   = 0;   // length of sequence #2 after alignment
+	int numMismatches    = 0;   // the mismatched nucleotide count
+
+	char c1, c2;
+
+	int ci = BestRow;
+	int cj = BestColumn;
+
+	// traceback flag
+	bool keepProcessing = true;
+
+	while(keepProcessing) {
+
+		// the first row and column and any cell outside the band stop the traceback
+		const int k = cj - ci - bandStart;
+		char direction = Directions_STOP;
+		if((ci > 0) && (cj > 0) && (k >= 0) && (k < (int)bandLength)) direction = mBandPointers[ci * bandLength + k];
+
+		switch(direction) {
+
+			case Directions_DIAGONAL:
+				c1 = s1[--ci];
+				c2 = s2[--cj];
+
+				mReversedAnchor[gappedAnchorLen++] = c1;
+				mReversedQuery[gappedQueryLen++]   = c2;
+
+				// increment our mismatch counter
+				if(mScoringMatrix[c1 - 'A'][c2 - 'A'] == mMismatchScore) numMismatches++;
+				break;
+
+			case Directions_STOP:
+				keepProcessing = false;
+				break;
+
+			case Directions_UP:
+				for(unsigned int l = 0, len = mBandVerticalGaps[ci * bandLength + k]; l < len; l++) {
+					mReversedAnchor[gappedAnchorLen++] = s1[--ci];
+					mReversedQuery[gappedQueryLen++]   = GAP;
+					numMismatches++;
+				}
+				break;
+
+			case Directions_LEFT:
+				for(unsigned int l = 0, len = mBandHorizontalGaps[ci * bandLength + k]; l < len; l++) {
+					mReversedAnchor[gappedAnchorLen++] = GAP;
+					mReversedQuery[gappedQueryLen++]   = s2[--cj];
+					numMismatches++;
+				}
+				break;
+		}
+	}
+
+	// set the reference endpoint
+	referenceAl = ci;
+
+	FinishAlignment(refAl, queryAl, gappedAnchorLen, gappedQueryLen, numMismatches);
 }
 
 // creates a simple scoring matrix to align the nucleotides and the ambiguity code N
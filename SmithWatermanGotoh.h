@@ -9,6 +9,7 @@
 #include <string.h>
 #include <sstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -24,6 +25,9 @@ public:
 	// aligns the query sequence to the reference using the Smith Waterman Gotoh algorithm
 	//void Align(unsigned int& referenceAl, string& cigarAl, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length);
 	void Align(unsigned int& referenceAl, string& refAl, string& queryAl, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length);
+	// aligns the query sequence to the reference, only filling the cells within bandWidth diagonals of the band
+	// running from the top left to the bottom right of the matrix
+	void BandedAlign(unsigned int& referenceAl, string& refAl, string& queryAl, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const unsigned int bandWidth);
 	// enables homo-polymer scoring
 	void EnableHomoPolymerGapPenalty(float hpGapOpenPenalty);
 private:
@@ -33,6 +37,11 @@ private:
 	void CorrectHomopolymerGapOrder(const unsigned int numBases, const unsigned int numMismatches);
 	// returns the maximum floating point number
 	static inline float MaxFloats(const float& a, const float& b, const float& c);
+	// reverses the traced back alignment and fixes the gap order
+	void FinishAlignment(string& refAl, string& queryAl, const int gappedAnchorLen, const int gappedQueryLen, const int numMismatches);
+	// fills the diagonal and vertical gap scores of a band row (selected for the cpu at run time)
+	typedef void (*BandRowFunction)(const float* pPreviousBest, const float* pPreviousGap, const float* pSimilarity, float* pDiagonal, float* pGap, const unsigned int bandLength, const float gapOpenPenalty, const float gapExtendPenalty);
+	BandRowFunction mFillBandRow;
 	// our simple scoring matrix
 	float mScoringMatrix[MOSAIK_NUM_NUCLEOTIDES][MOSAIK_NUM_NUCLEOTIDES];
 	// keep track of maximum initialized sizes
@@ -67,6 +76,14 @@ private:
 	char* mReversedQuery;
 	// define static constants
 	static const float FLOAT_NEGATIVE_INFINITY;
+	// the banded alignment matrices: row i holds the cells on diagonals mBandStart...mBandStart + band length - 1
+	vector<char>  mBandPointers;
+	vector<short> mBandVerticalGaps;
+	vector<short> mBandHorizontalGaps;
+	// the best scores, vertical gap scores and their row working space for the banded alignment
+	vector<float> mBandScores;
+	// the similarity score of each reference base against each query position
+	vector<float> mQueryProfile;
 	// toggles the use of the homo-polymer gap open penalty
 	bool mUseHomoPolymerGapOpenPenalty;
 	// specifies the homo-polymer gap open penalty
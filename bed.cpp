@@ -15,18 +15,32 @@ using namespace vcfCTools;
 
 // Constructor.
 bed::bed(void) {
+  compressedInput = NULL;
+  input = NULL;
   numberTargets = 0;
   targetLength = 0;
   targetVariance = 0;
+  bRecord.referenceSequenceID = NO_CONTIG;
 }
 
 // Destructor.
-bed::~bed(void)
-{}
+bed::~bed(void) {
+  if (compressedInput != NULL) {delete compressedInput;}
+}
 
-// Open a bed file.
+// Open a bed file.  Compressed files (BGZF or gzip) are recognised from
+// their contents and read through the decompressing stream buffer.
 bool bed::openBed(string& bedFilename) {
-  if (bedFilename != "-") {
+  if (bedFilename != "-" && bgzfInputBuffer::isCompressed(bedFilename)) {
+    if (!compressedBuffer.open(bedFilename, threadPool::availableCores() - 1)) {
+      cerr << "Failed to open file: " << bedFilename << endl;
+      exit(1);
+    }
+    if (compressedInput == NULL) {compressedInput = new istream(&compressedBuffer);}
+    compressedInput->clear();
+    input = compressedInput;
+  }
+  else if (bedFilename != "-") {
     file.open(bedFilename.c_str(), ifstream::in);
     input = &file;
     if (!file.is_open()) {
@@ -35,11 +49,14 @@ bool bed::openBed(string& bedFilename) {
     }
   }
   else {cerr << "bed file must be provided.  Cannot read from stdin." << endl;}
+
+  return true;
 }
 
 // Close the bed file.
 void bed::closeBed() {
-  if (bedFilename != "-") {
+  if (input != NULL && input == compressedInput) {compressedBuffer.close();}
+  else if (bedFilename != "-") {
     file.close();
     if (file.is_open()) {
       cerr << "Failed to close file: " << bedFilename << endl;
@@ -73,8 +90,12 @@ bool bed::getRecord() {
 
   vector<string> recordFields = split(record, '\t');
 
-// Populate the variant values.
-  bRecord.referenceSequence = recordFields[0];
+// Populate the variant values.  The reference sequence ID is only looked
+// up when the reference sequence changes.
+  if (recordFields[0] != bRecord.referenceSequence || bRecord.referenceSequenceID == NO_CONTIG) {
+    bRecord.referenceSequence   = recordFields[0];
+    bRecord.referenceSequenceID = sharedContigs().getID(bRecord.referenceSequence);
+  }
   bRecord.start = atoi(recordFields[1].c_str()) + 1;
   bRecord.end   = atoi(recordFields[2].c_str());
   if (recordFields.size() > 3) {bRecord.info = recordFields[3];}
@@ -11,6 +11,8 @@
 #ifndef BED_H
 #define BED_H
 
+#include "bgzf.h"
+#include "contig_dictionary.h"
 #include "split.h"
 
 #include <cstdlib>
@@ -27,6 +29,7 @@ namespace vcfCTools {
 
 struct bedRecord {
   string referenceSequence;
+  unsigned int referenceSequenceID;
   int start;
   int end;
   string info;
@@ -47,6 +50,10 @@ class bed {
     ifstream file;
     string bedFilename;
 
+// Compressed (BGZF or gzip) input.
+    bgzfInputBuffer compressedBuffer;
+    istream* compressedInput;
+
 // variant information
     bool success;
     string record;
@@ -15,288 +15,132 @@
 using namespace std;
 using namespace vcfCTools;
 
-//Constructor.
-bedStructure::bedStructure(void) {
-  recordsInMemory = 1000;
-};
+// Subtrees with at most this many levels are scanned linearly rather than
+// searched.
+#define BED_SCAN_LEVEL 3
 
-// Destructor.
-bedStructure::~bedStructure(void) {};
+// Order bed records by start, then end coordinate.
+static bool earlierInterval(const bedRecord& a, const bedRecord& b) {
+  if (a.start != b.start) {return a.start < b.start;}
 
-// Build up a new map containing the bed intervals.  Set the iterator to
-// the first interval and check if it overlaps with the following interval.
-void bedStructure::initialiseBedMap(bed& b, intFlags& flags) {
-  buildBedStructure(b);
+  return a.end < b.end;
+}
 
-  // Set the pointers to the start of each variant map.  For intersection with
-  // a bed file, there is no need to work with the reduced allele structures,
-  // so the original variants structure is used.
-  bmIter = bedMap.begin();
-  bmNext = bedMap.begin();
-  if (bedMap.size() == 1) {lastBedInterval = true;}
-  else {bmNext++;}
+//Constructor.
+bedStructure::bedStructure(void) {};
 
-  // Check if the end position of the current interval is larger than the start
-  // position of the next interval in the structure.  If so, the intervals
-  // overlap and need to be split up.
-  if (!lastBedInterval) {
-    if (bmIter->second.end >= bmNext->first) {
-      resolveOverlaps(flags.annotate);
-      bmIter = bedMap.begin();
-      bmNext = bedMap.begin();
-      bmNext++;
-    }
-  }
-}
+// Destructor.
+bedStructure::~bedStructure(void) {};
 
-// Build up a structure containing bed intervals and annotations.
+// Read all of the intervals in the bed file, sort the intervals for each
+// reference sequence and build the index.
 bool bedStructure::buildBedStructure(bed& b) {
-  unsigned int count = 0;
-
-  string tempReferenceSequence = b.bRecord.referenceSequence;
-  while (b.success && count < recordsInMemory && b.bRecord.referenceSequence == tempReferenceSequence) {
-    addIntervalToStructure(b.bRecord);
+  intervals.clear();
+  b.success = b.getRecord();
+  while (b.success) {
+    if (b.bRecord.referenceSequenceID >= intervals.size()) {intervals.resize(b.bRecord.referenceSequenceID + 1);}
+    intervals[b.bRecord.referenceSequenceID].records.push_back(b.bRecord);
     b.success = b.getRecord();
-    count++;
   }
 
-  return b.success;
-}
-
-// Add the bed record to the structure.
-void bedStructure::addIntervalToStructure(bedRecord& br) {
-
-// If this position already has an entry, determine how to join the intervals.
-  if (bedMap.count(br.start) > 0) {
-    resolveOverlaps(br);
-  } else {
-    bedMap[br.start].referenceSequence = br.referenceSequence;
-    bedMap[br.start].start = br.start;
-    bedMap[br.start].end = br.end;
-    bedMap[br.start].info = br.info;
+  for (vector<bedIntervals>::iterator iter = intervals.begin(); iter != intervals.end(); iter++) {
+    stable_sort(iter->records.begin(), iter->records.end(), earlierInterval);
+    buildIndex(*iter);
   }
-}
-
-// If two bed records overlap, split them into two (or three if one of the
-// records is wholly within another) records.  One of these records
-// is a common interval and the info strings for each record need to be
-// unpacked, compared for common strings and repacked with unique strings.
-// The other record(s) is(are) the non-overlapping section and will retain
-// the info string of its parent.
-//
-// The first of these routines is called when a record to be added has the
-// same start coordinate of an existing record.
-void bedStructure::resolveOverlaps(bedRecord& b1) {
-  bedRecord b2 = bedMap[b1.start];
-
-  // Erase the map element with the duplicated start position.
-  bedMap.erase(b1.start);
-
-  // The first interval is shorter than the second.
-  if (b1.end < b2.end) {
-
-    // The interval start - b1.end is common.  b1.end + 1 - b2.end is unique to b2.
-    // Unique interval.
-    bedMap[b1.end + 1].referenceSequence = b2.referenceSequence;
-    bedMap[b1.end + 1].start = b1.end + 1;
-    bedMap[b1.end + 1].end = b2.end;
-    bedMap[b1.end + 1].info = b2.info;
 
-    // Common interval.
-    generateCommonInterval(b1, b2, b1.start, b1.end);
-
-  // The two intervals are identical.
-  } else if (b1.end == b2.end) {
-    generateCommonInterval(b1, b2, b1.start, b1.end);
-
-  // The second interval is shorter than the first.
-  } else if (b1.end > b2.end) {
-
-    // The interval start - b2.end is common.  b2.end + 1 - b1.end is unique to b1.
-    // Unique interval.
-    bedMap[b2.end + 1].referenceSequence = b1.referenceSequence;
-    bedMap[b2.end + 1].start = b2.end + 1;
-    bedMap[b2.end + 1].end = b1.end;
-    bedMap[b2.end + 1].info = b1.info;
-
-    // Common interval.
-    generateCommonInterval(b1, b2, b1.start, b2.end);
-  }
+  return b.success;
 }
 
-// Resolve overlap between two records already in the structure (e.g. they
-// do not have the same start coordinate).
-void bedStructure::resolveOverlaps(bool annotate) {
-  bool resolvedIntervals = false;
-  map<int, bedRecord>::iterator bmNext = bedMap.begin();
-  map<int, int> startPositions, endPositions;
-  map<int, int>::iterator sIter, eIter;
-  vector<bedRecord> bRecords;
-  vector<bedRecord>::iterator bIter;
-  bmNext++;
-
-  // Store the first bed record in the vector.
-  bRecords.push_back(bmIter->second);
-  startPositions[bmIter->first] = 1;
-  endPositions[bmIter->second.end] = 1;
-
-  // Determine how many consecutive records overlap.
-  while (!resolvedIntervals && bmNext != bedMap.end()) {
-    if (bmIter->second.end >= bmNext->first) {
-
-      // Add the start and end coordinates to the maps.
-      startPositions[bmNext->first] = 1;
-      endPositions[bmNext->second.end] = 1;
-
-      // Store the record in the vector, then delete from the map.  This
-      // reocrd is no longer required in the map as it will be broken up.
-      bRecords.push_back(bmNext->second);
-      bedMap.erase(bmNext);
-
-      // Get the second element of the map to check if this also overlaps
-      // with the first record.
-      bmNext = bedMap.begin();
-      bmNext++;
-    } else {
-      resolvedIntervals = true;
-    }
+// Calculate the largest end coordinate in the subtree of each node.  The
+// leaves (even indices) are set first, then each level in turn.  If the
+// right child of a node is beyond the end of the array, the largest end of
+// the last complete subtree is used instead.
+void bedStructure::buildIndex(bedIntervals& bi) {
+  int n = bi.records.size();
+  bi.maxEnd.resize(n);
+  bi.maxLevel = -1;
+  if (n == 0) {return;}
+
+  int lastIndex = 0;
+  int lastEnd   = 0;
+  for (int i = 0; i < n; i += 2) {
+    lastIndex = i;
+    lastEnd   = bi.maxEnd[i] = bi.records[i].end;
   }
 
-  // Also remove the first element from the map.  This is also to be broken
-  // up.
-  bedMap.erase(bmIter);
-
-  // Now build up the new records.  Proceed by selecting the first (leftmost
-  // coordinate) start position and take this as the start of the first record.
-  // The end coordinate is the smaller of the leftmost end coordinate (of any
-  // of the stored records) or the start coordinate - 1.  Remove these elements
-  // from the vectors.
-  vector<int> reconstructedStarts, reconstructedEnds;
-
-  // Start the reconstructed intervals with the start coordinate of the first
-  // original bed record.
-  sIter = startPositions.begin();
-  reconstructedStarts.push_back(sIter->first);
-  startPositions.erase(sIter);
-  while (startPositions.size() != 0) {
-
-    // Find the end position.
-    sIter = startPositions.begin();
-    eIter = endPositions.begin();
-
-    // lowest (start - 1 ) < lowest( end )
-    if (sIter->first - 1 < eIter->first) {
-      reconstructedEnds.push_back(sIter->first - 1);
-
-      // The start of the next reconstructed interval is this end coordinate + 1.
-      reconstructedStarts.push_back(sIter->first);
-      startPositions.erase(sIter);
-      sIter = startPositions.begin();
-
-    // lowest (start - 1 ) > lowest( end )
-    } else {
-      reconstructedEnds.push_back(eIter->first);
-      
-      // The start of the next reconstructed interval is this end coordinate + 1.
-      reconstructedStarts.push_back(eIter->first + 1);
-      endPositions.erase(eIter);
-      eIter = endPositions.begin();
+  int level = 1;
+  for (; (1 << level) <= n; level++) {
+    int offset = 1 << (level - 1);
+    for (int i = (offset << 1) - 1; i < n; i += offset << 2) {
+      int end = bi.records[i].end;
+      end = max(end, bi.maxEnd[i - offset]);
+      end = max(end, (i + offset < n) ? bi.maxEnd[i + offset] : lastEnd);
+      bi.maxEnd[i] = end;
     }
+    lastIndex = ((lastIndex >> level) & 1) ? lastIndex - offset : lastIndex + offset;
+    if (lastIndex < n && bi.maxEnd[lastIndex] > lastEnd) {lastEnd = bi.maxEnd[lastIndex];}
   }
+  bi.maxLevel = level - 1;
+}
 
-  // There will still be end positions to process.  Finish up the intervals
-  // using these end positions.
-  int end;
-  while (endPositions.size() != 0) {
-    eIter = endPositions.begin();
-    end = eIter->first;
-    reconstructedEnds.push_back(end);
-    endPositions.erase(eIter);
-    if (endPositions.size() != 0) {reconstructedStarts.push_back(end + 1);}
-  }
-
-  // Add these bed intervals back into the bed map.  Annotations will be dealt
-  // with afterwards (if necessary).
-  if (reconstructedStarts.size() != reconstructedEnds.size()) {
-    cerr << "ERROR:  Problem in reconstructing overlapping bed records." << endl;
-    cerr << "First record in region at: " << bRecords[0].referenceSequence << ":" << reconstructedStarts[0] << endl;
-    exit(1);
-  }
-  vector<int>::iterator stIter, enIter;
-  enIter = reconstructedEnds.begin();
-  for (stIter = reconstructedStarts.begin(); stIter != reconstructedStarts.end(); stIter++) {
-    bedMap[*stIter].referenceSequence = bRecords[0].referenceSequence;
-    bedMap[*stIter].start = *stIter;
-    bedMap[*stIter].end = *enIter;
-    enIter++;
-  }
-
-  // Now that the coordinates of the reconstructed bed intervals are known,
-  // determine the annotations that fall within these regions.
-  if (annotate) {
-    vector<string> ann;
-    vector<string>::iterator annIter;
-    map<string, int> annMap;
-    map<string, int>::iterator annMapIter;
-    string constructInfo;
-
-    enIter = reconstructedEnds.begin();
-    for (stIter = reconstructedStarts.begin(); stIter != reconstructedStarts.end(); stIter++) {
-      constructInfo = "";
-      bIter = bRecords.begin();
-      while (bIter != bRecords.end()) {
-
-        // If the end coordinate of the original record is less than the start
-        // coordinate of this reconstructed record, the original record can
-        // be deleted as it no longer contributes to the reconstructed
-        // intervals.
-        if (bIter->end < *stIter) {
-          bIter = bRecords.erase(bIter);
-
-        // This record overlaps the reconstructed interval, so add the annotation
-        // information to the map.
-        } else if (bIter->start <= *enIter) {
-          ann = split(bIter->info, ";");
-          for (annIter = ann.begin(); annIter != ann.end(); annIter++) {
-            annMap[*annIter] = 1;
-          }
-          bIter++;
-        } else {
-          bIter++;
-        }
+// Find all intervals on the reference sequence overlapping the closed
+// interval start - end.  The tree is descended from the root, only visiting
+// subtrees whose largest end coordinate reaches the start and stopping once
+// the interval starts are beyond the end, so the search takes O(log n + k)
+// for k overlapping intervals.  The overlapping intervals are returned in
+// order of their start coordinate.
+unsigned int bedStructure::findOverlaps(unsigned int referenceSequenceID, int start, int end, vector<bedRecord*>& overlaps) {
+  struct node {
+    int index;
+    int level;
+    bool visitedLeft;
+  } stack[64];
+
+  overlaps.clear();
+  if (referenceSequenceID >= intervals.size() || intervals[referenceSequenceID].maxLevel < 0) {return 0;}
+
+  bedIntervals& bi = intervals[referenceSequenceID];
+  int n = bi.records.size();
+  int depth = 0;
+  stack[depth].index       = (1 << bi.maxLevel) - 1;
+  stack[depth].level       = bi.maxLevel;
+  stack[depth].visitedLeft = false;
+  depth++;
+
+  while (depth != 0) {
+    node current = stack[--depth];
+
+    // Scan the intervals in small subtrees.
+    if (current.level <= BED_SCAN_LEVEL) {
+      int first = (current.index >> current.level) << current.level;
+      int last  = first + (1 << (current.level + 1)) - 1;
+      if (last > n) {last = n;}
+      for (int i = first; i < last && bi.records[i].start <= end; i++) {
+        if (bi.records[i].end >= start) {overlaps.push_back(&bi.records[i]);}
       }
 
-      // Add the info string to the bed map and clear the annotation map.
-      for (annMapIter = annMap.begin(); annMapIter != annMap.end(); annMapIter++) {
-        constructInfo = (constructInfo == "") ? annMapIter->first : constructInfo + ";" + annMapIter->first;
-        annMap.erase(annMapIter);
+    // Search the left subtree, coming back to this node afterwards.
+    } else if (!current.visitedLeft) {
+      int left = current.index - (1 << (current.level - 1));
+      stack[depth]             = current;
+      stack[depth].visitedLeft = true;
+      depth++;
+      if (left >= n || bi.maxEnd[left] >= start) {
+        stack[depth].index       = left;
+        stack[depth].level       = current.level - 1;
+        stack[depth].visitedLeft = false;
+        depth++;
       }
-      bedMap[*stIter].info = constructInfo;
 
-      enIter++;
+    // Check this node, then search the right subtree.
+    } else if (current.index < n && bi.records[current.index].start <= end) {
+      if (bi.records[current.index].end >= start) {overlaps.push_back(&bi.records[current.index]);}
+      stack[depth].index       = current.index + (1 << (current.level - 1));
+      stack[depth].level       = current.level - 1;
+      stack[depth].visitedLeft = false;
+      depth++;
     }
   }
-}
-
-// Generate the entry for the common interval.
-void bedStructure::generateCommonInterval(bedRecord& b1, bedRecord& b2, int start, int end) {
-  string info = "";
-  map<string, int> existingInfo;
 
-  // Unpack the info strings from the two intersecting records.
-  vector<string> b1Info = split(b1.info, ";");
-  vector<string> b2Info = split(b2.info, ";");
-
-  // Generate the new interval.
-  bedMap[start].referenceSequence = b1.referenceSequence;
-  bedMap[start].start = start;
-  bedMap[start].end = end;
-  for (vector<string>::iterator i = b1Info.begin(); i != b1Info.end(); i++) {
-    info = (info == "") ? *i : info + ";" + *i;
-    existingInfo[*i] = 0;
-  }
-  for (vector<string>::iterator i = b2Info.begin(); i != b2Info.end(); i++) {
-    if (existingInfo.count(*i) == 0) {info = (info == "") ? *i : info + ";" + *i;}
-  }
-  bedMap[start].info = info;
+  return overlaps.size();
 }
@@ -13,6 +13,7 @@
 #ifndef BEDSTRUCTURE_H
 #define BEDSTRUCTURE_H
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
@@ -29,24 +30,31 @@ using namespace std;
 
 namespace vcfCTools {
 
+// The intervals for a single reference sequence, sorted by start coordinate.
+// The sorted array is treated as an implicit binary tree: the node at index
+// i is at level k, where k is the number of trailing 1 bits of i, and its
+// children are at i - 2^(k-1) and i + 2^(k-1).  Each node stores the largest
+// end coordinate of any interval in its subtree, so the subtrees that cannot
+// contain an overlapping interval are skipped.
+struct bedIntervals {
+  vector<bedRecord> records;
+  vector<int> maxEnd;
+  int maxLevel;
+};
+
 class bedStructure {
   public:
     bedStructure(void);
     ~bedStructure(void);
-    void addIntervalToStructure(bedRecord&);
     bool buildBedStructure(bed&);
-    void generateCommonInterval(bedRecord&, bedRecord&, int, int);
-    void initialiseBedMap(bed&, intFlags&);
-    void resolveOverlaps(bedRecord&);
-    void resolveOverlaps(bool);
+    void buildIndex(bedIntervals&);
+    unsigned int findOverlaps(unsigned int, int, int, vector<bedRecord*>&);
 
   public:
-    bool lastBedInterval;
-    unsigned int lastBedIntervalEnd;
-    unsigned int recordsInMemory;
-    map<int, bedRecord> bedMap;
-    map<int, bedRecord>::iterator bmIter;
-    map<int, bedRecord>::iterator bmNext;
+
+    // The intervals for each reference sequence, indexed by the reference
+    // sequence ID.  Overlapping intervals are kept as they are in the file.
+    vector<bedIntervals> intervals;
 };
 
 } // namespace vcfCTools
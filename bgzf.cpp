@@ -0,0 +1,493 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Stream buffers for reading BGZF and gzip compressed
+// files and writing BGZF files.
+// ******************************************************
+
+#include "bgzf.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Read a little endian integer from a byte array.
+static unsigned int readUint16(const char* bytes) {
+  const unsigned char* b = (const unsigned char*) bytes;
+  return b[0] | (b[1] << 8);
+}
+
+static unsigned int readUint32(const char* bytes) {
+  const unsigned char* b = (const unsigned char*) bytes;
+  return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int) b[3] << 24);
+}
+
+// Write a little endian integer to a byte array.
+static void writeUint16(char* bytes, unsigned int value) {
+  bytes[0] = value & 0xff;
+  bytes[1] = (value >> 8) & 0xff;
+}
+
+static void writeUint32(char* bytes, unsigned int value) {
+  bytes[0] = value & 0xff;
+  bytes[1] = (value >> 8) & 0xff;
+  bytes[2] = (value >> 16) & 0xff;
+  bytes[3] = (value >> 24) & 0xff;
+}
+
+// Constructor.
+bgzfBlock::bgzfBlock(void) {
+  blockLength = 0;
+  dataLength  = 0;
+  dataStart   = 0;
+  error       = false;
+  fileOffset  = 0;
+  loaded      = false;
+}
+
+// Destructor.
+bgzfBlock::~bgzfBlock(void) {}
+
+// Inflate the block.  This is run on a worker thread.
+void bgzfBlock::run() {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  error      = false;
+  dataLength = 0;
+  if (data.size() < BGZF_MAX_BLOCK_SIZE) {data.resize(BGZF_MAX_BLOCK_SIZE);}
+
+  // The deflate data sits between the header (including the extra
+  // field) and the crc/length footer.
+  unsigned int expectedLength = readUint32(&compressed[blockLength - 4]);
+  if (expectedLength > BGZF_MAX_BLOCK_SIZE || inflateInit2(&stream, -15) != Z_OK) {
+    error = true;
+    return;
+  }
+  stream.next_in   = (Bytef*) &compressed[dataStart];
+  stream.avail_in  = blockLength - dataStart - BGZF_FOOTER_LENGTH;
+  stream.next_out  = (Bytef*) &data[0];
+  stream.avail_out = data.size();
+  int status = inflate(&stream, Z_FINISH);
+  dataLength = stream.total_out;
+  inflateEnd(&stream);
+
+  if (status != Z_STREAM_END || dataLength != expectedLength) {error = true;}
+}
+
+// Constructor.
+bgzfInputBuffer::bgzfInputBuffer(void) {
+  currentBlock   = -1;
+  endOfFile      = false;
+  file           = NULL;
+  gzipStreamOpen = false;
+  isBgzf         = false;
+  setg(NULL, NULL, NULL);
+}
+
+// Destructor.
+bgzfInputBuffer::~bgzfInputBuffer(void) {
+  close();
+}
+
+// Determine if a file is gzip compressed (this includes BGZF files)
+// from the magic number.
+bool bgzfInputBuffer::isCompressed(string& filename) {
+  unsigned char magic[2];
+  bool compressed = false;
+
+  FILE* test = fopen(filename.c_str(), "rb");
+  if (test == NULL) {return false;}
+  if (fread(magic, 1, 2, test) == 2 && magic[0] == 0x1f && magic[1] == 0x8b) {compressed = true;}
+  fclose(test);
+
+  return compressed;
+}
+
+// Open the compressed file and start inflating.  If the file is BGZF
+// compressed, the requested number of worker threads is started.
+bool bgzfInputBuffer::open(string& name, unsigned int threads) {
+  char header[BGZF_HEADER_LENGTH + 6];
+
+  close();
+  filename  = name;
+  endOfFile = false;
+  file      = fopen(filename.c_str(), "rb");
+  if (file == NULL) {return false;}
+
+  // A BGZF file starts with a gzip header that has an extra field
+  // containing the 'BC' subfield holding the block size.
+  isBgzf = false;
+  if (fread(header, 1, sizeof(header), file) == sizeof(header)) {
+    isBgzf = (unsigned char) header[0] == 0x1f && (unsigned char) header[1] == 0x8b &&
+             (header[3] & 4) && readUint16(&header[10]) == 6 &&
+             header[12] == 'B' && header[13] == 'C' && readUint16(&header[14]) == 2;
+  }
+  rewind(file);
+
+  // BGZF files.  Keep several blocks per thread in flight so that the
+  // workers are busy while the main thread consumes the data.
+  if (isBgzf) {
+    pool.startThreads(threads);
+    blocks.resize(threads == 0 ? 2 : threads * 4);
+    currentBlock = -1;
+    for (vector<bgzfBlock>::iterator iter = blocks.begin(); iter != blocks.end(); iter++) {
+      if (readBlock(*iter)) {pool.submit(&(*iter));}
+    }
+
+  // Other gzip files.
+  } else {
+    memset(&gzipStream, 0, sizeof(gzipStream));
+    if (inflateInit2(&gzipStream, 16 + MAX_WBITS) != Z_OK) {
+      cerr << "ERROR: Unable to initialise decompression for file: " << filename << endl;
+      exit(1);
+    }
+    gzipStreamOpen = true;
+    gzipInput.resize(BGZF_MAX_BLOCK_SIZE);
+    gzipOutput.resize(BGZF_MAX_BLOCK_SIZE);
+  }
+  setg(NULL, NULL, NULL);
+
+  return true;
+}
+
+// Close the file, waiting for any outstanding blocks.
+void bgzfInputBuffer::close() {
+  pool.waitAll();
+  pool.stopThreads();
+  blocks.clear();
+  if (gzipStreamOpen) {
+    inflateEnd(&gzipStream);
+    gzipStreamOpen = false;
+  }
+  if (file != NULL) {
+    fclose(file);
+    file = NULL;
+  }
+  setg(NULL, NULL, NULL);
+}
+
+// Read the next compressed block from the file.  Returns false if no
+// blocks remain.
+bool bgzfInputBuffer::readBlock(bgzfBlock& block) {
+  char header[BGZF_HEADER_LENGTH];
+
+  block.loaded = false;
+  if (endOfFile) {return false;}
+
+  block.fileOffset = ftello(file);
+  size_t bytesRead = fread(header, 1, BGZF_HEADER_LENGTH, file);
+  if (bytesRead == 0) {
+    endOfFile = true;
+    return false;
+  }
+  if (bytesRead != BGZF_HEADER_LENGTH || (unsigned char) header[0] != 0x1f || (unsigned char) header[1] != 0x8b || !(header[3] & 4)) {
+    cerr << "ERROR: Invalid BGZF block header in file: " << filename << endl;
+    exit(1);
+  }
+
+  // Read the extra field and find the block size.  The sizes are read from
+  // the file, so check that the block fits in the buffer before reading it.
+  unsigned int extraLength = readUint16(&header[10]);
+  if (BGZF_HEADER_LENGTH + extraLength + BGZF_FOOTER_LENGTH > BGZF_MAX_BLOCK_SIZE) {
+    cerr << "ERROR: Invalid BGZF block header in file: " << filename << endl;
+    exit(1);
+  }
+  if (block.compressed.size() < BGZF_MAX_BLOCK_SIZE) {block.compressed.resize(BGZF_MAX_BLOCK_SIZE);}
+  memcpy(&block.compressed[0], header, BGZF_HEADER_LENGTH);
+  if (fread(&block.compressed[BGZF_HEADER_LENGTH], 1, extraLength, file) != extraLength) {
+    cerr << "ERROR: Truncated BGZF block in file: " << filename << endl;
+    exit(1);
+  }
+
+  unsigned int blockLength = 0;
+  const char* extra = &block.compressed[BGZF_HEADER_LENGTH];
+  for (unsigned int i = 0; i + 4 <= extraLength;) {
+    unsigned int subfieldLength = readUint16(&extra[i + 2]);
+    if (extra[i] == 'B' && extra[i + 1] == 'C' && subfieldLength == 2 && i + 6 <= extraLength) {blockLength = readUint16(&extra[i + 4]) + 1;}
+    i += 4 + subfieldLength;
+  }
+  if (blockLength < BGZF_HEADER_LENGTH + extraLength + BGZF_FOOTER_LENGTH || blockLength > BGZF_MAX_BLOCK_SIZE) {
+    cerr << "ERROR: Invalid BGZF block size in file: " << filename << endl;
+    exit(1);
+  }
+
+  // Read the remainder of the block.
+  unsigned int remaining = blockLength - BGZF_HEADER_LENGTH - extraLength;
+  if (fread(&block.compressed[BGZF_HEADER_LENGTH + extraLength], 1, remaining, file) != remaining) {
+    cerr << "ERROR: Truncated BGZF block in file: " << filename << endl;
+    exit(1);
+  }
+  block.blockLength = blockLength;
+  block.dataStart   = BGZF_HEADER_LENGTH + extraLength;
+  block.loaded      = true;
+
+  return true;
+}
+
+// Provide the next block of inflated data.
+int bgzfInputBuffer::underflow() {
+  if (gptr() < egptr()) {return traits_type::to_int_type(*gptr());}
+
+  bool available = isBgzf ? underflowBgzf() : underflowGzip();
+
+  return available ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+// Move on to the next BGZF block.  The block that has just been consumed
+// is refilled with the next block from the file and queued for inflation.
+// Since blocks are consumed and refilled in turn, the ring stays in file
+// order.  Empty blocks (e.g. the end of file marker) are skipped.
+bool bgzfInputBuffer::underflowBgzf() {
+  if (blocks.size() == 0) {return false;}
+
+  while (true) {
+    if (currentBlock >= 0) {
+      bgzfBlock& consumed = blocks[currentBlock];
+      if (readBlock(consumed)) {pool.submit(&consumed);}
+    }
+    currentBlock = (currentBlock + 1) % blocks.size();
+
+    bgzfBlock& block = blocks[currentBlock];
+    if (!block.loaded) {return false;}
+    pool.waitFor(&block);
+    if (block.error) {
+      cerr << "ERROR: Failed to decompress BGZF block in file: " << filename << endl;
+      exit(1);
+    }
+    if (block.dataLength != 0) {
+      setg(&block.data[0], &block.data[0], &block.data[0] + block.dataLength);
+      return true;
+    }
+  }
+}
+
+// Return the virtual offset of the next character to be read.  This is
+// only defined for BGZF files.
+uint64_t bgzfInputBuffer::tell() {
+  if (!isBgzf || currentBlock < 0) {return 0;}
+
+  return (blocks[currentBlock].fileOffset << 16) | (uint64_t) (gptr() - eback());
+}
+
+// Move to the given virtual offset.  If the block is the one currently
+// being read, only the read position changes, otherwise the ring of
+// blocks is refilled from the new position.  Returns false if the file
+// is not BGZF compressed or the offset is invalid.
+bool bgzfInputBuffer::seek(uint64_t offset) {
+  uint64_t fileOffset        = offset >> 16;
+  unsigned int blockPosition = offset & 0xffff;
+
+  if (!isBgzf || blocks.size() == 0) {return false;}
+
+  // If the current block has been consumed and the requested block is
+  // the next one in the ring, just move on to it.
+  if (currentBlock >= 0 && gptr() == egptr() && blocks[currentBlock].fileOffset != fileOffset) {
+    bgzfBlock& next = blocks[(currentBlock + 1) % blocks.size()];
+    if (next.loaded && next.fileOffset == fileOffset) {underflowBgzf();}
+  }
+
+  if (currentBlock < 0 || !blocks[currentBlock].loaded || blocks[currentBlock].fileOffset != fileOffset) {
+    pool.waitAll();
+    if (fseeko(file, fileOffset, SEEK_SET) != 0) {return false;}
+    endOfFile    = false;
+    currentBlock = -1;
+    for (vector<bgzfBlock>::iterator iter = blocks.begin(); iter != blocks.end(); iter++) {
+      if (readBlock(*iter)) {pool.submit(&(*iter));}
+    }
+    setg(NULL, NULL, NULL);
+    if (!underflowBgzf()) {return blockPosition == 0;}
+  }
+
+  bgzfBlock& block = blocks[currentBlock];
+  if (block.fileOffset != fileOffset || blockPosition > block.dataLength) {return false;}
+  setg(&block.data[0], &block.data[0] + blockPosition, &block.data[0] + block.dataLength);
+
+  return true;
+}
+
+// Inflate the next section of a gzip file.  Concatenated gzip members
+// are read in turn.
+bool bgzfInputBuffer::underflowGzip() {
+  if (!gzipStreamOpen) {return false;}
+
+  while (true) {
+    if (gzipStream.avail_in == 0) {
+      size_t bytesRead = fread(&gzipInput[0], 1, gzipInput.size(), file);
+      if (bytesRead == 0) {return false;}
+      gzipStream.next_in  = (Bytef*) &gzipInput[0];
+      gzipStream.avail_in = bytesRead;
+    }
+    gzipStream.next_out  = (Bytef*) &gzipOutput[0];
+    gzipStream.avail_out = gzipOutput.size();
+
+    int status = inflate(&gzipStream, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+      cerr << "ERROR: Failed to decompress file: " << filename << endl;
+      exit(1);
+    }
+    if (status == Z_STREAM_END) {inflateReset(&gzipStream);}
+
+    unsigned int produced = gzipOutput.size() - gzipStream.avail_out;
+    if (produced != 0) {
+      setg(&gzipOutput[0], &gzipOutput[0], &gzipOutput[0] + produced);
+      return true;
+    }
+  }
+}
+
+// Constructor.
+bgzfOutputBlock::bgzfOutputBlock(void) {
+  blockLength      = 0;
+  compressionLevel = Z_DEFAULT_COMPRESSION;
+  dataLength       = 0;
+  error            = false;
+  pending          = false;
+}
+
+// Destructor.
+bgzfOutputBlock::~bgzfOutputBlock(void) {}
+
+// Deflate the block and add the BGZF header and footer.  This is run
+// on a worker thread.
+void bgzfOutputBlock::run() {
+  static const char header[18] = {31, -117, 8, 4, 0, 0, 0, 0, 0, -1, 6, 0, 'B', 'C', 2, 0, 0, 0};
+  const unsigned int headerLength = sizeof(header);
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  error = false;
+  if (compressed.size() < BGZF_MAX_BLOCK_SIZE) {compressed.resize(BGZF_MAX_BLOCK_SIZE);}
+  if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    error = true;
+    return;
+  }
+  stream.next_in   = (Bytef*) (dataLength == 0 ? NULL : &data[0]);
+  stream.avail_in  = dataLength;
+  stream.next_out  = (Bytef*) &compressed[headerLength];
+  stream.avail_out = BGZF_MAX_BLOCK_SIZE - headerLength - BGZF_FOOTER_LENGTH;
+  int status = deflate(&stream, Z_FINISH);
+  unsigned int deflatedLength = stream.total_out;
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    error = true;
+    return;
+  }
+
+  // The block size stored in the header is the total length minus one.
+  blockLength = headerLength + deflatedLength + BGZF_FOOTER_LENGTH;
+  memcpy(&compressed[0], header, headerLength);
+  writeUint16(&compressed[16], blockLength - 1);
+  unsigned long crc = crc32(0L, Z_NULL, 0);
+  if (dataLength != 0) {crc = crc32(crc, (Bytef*) &data[0], dataLength);}
+  writeUint32(&compressed[headerLength + deflatedLength], crc);
+  writeUint32(&compressed[headerLength + deflatedLength + 4], dataLength);
+}
+
+// Constructor.
+bgzfOutputBuffer::bgzfOutputBuffer(void) {
+  currentBlock = 0;
+  file         = NULL;
+  setp(NULL, NULL);
+}
+
+// Destructor.
+bgzfOutputBuffer::~bgzfOutputBuffer(void) {
+  close();
+}
+
+// Open the output file and start the requested number of worker threads.
+bool bgzfOutputBuffer::open(string& name, unsigned int threads) {
+  close();
+  filename = name;
+  file     = fopen(filename.c_str(), "wb");
+  if (file == NULL) {return false;}
+
+  pool.startThreads(threads);
+  blocks.resize(threads == 0 ? 1 : threads * 4);
+  for (vector<bgzfOutputBlock>::iterator iter = blocks.begin(); iter != blocks.end(); iter++) {
+    iter->data.resize(BGZF_BLOCK_DATA_SIZE);
+    iter->pending = false;
+  }
+  currentBlock = 0;
+  setp(&blocks[0].data[0], &blocks[0].data[0] + BGZF_BLOCK_DATA_SIZE);
+
+  return true;
+}
+
+// Write out the remaining data and the end of file marker (an empty
+// block) and close the file.
+void bgzfOutputBuffer::close() {
+  if (file == NULL) {return;}
+
+  // Submit the partially filled block, then write all of the pending
+  // blocks in order, starting with the oldest.
+  if (pptr() != pbase()) {submitBlock();}
+  for (unsigned int i = 0; i < blocks.size(); i++) {
+    bgzfOutputBlock& block = blocks[(currentBlock + i) % blocks.size()];
+    if (block.pending) {writeBlock(block);}
+  }
+
+  bgzfOutputBlock endOfFile;
+  endOfFile.run();
+  writeBlock(endOfFile);
+
+  pool.stopThreads();
+  blocks.clear();
+  if (fclose(file) != 0) {cerr << "ERROR: Failed to close file: " << filename << endl;}
+  file = NULL;
+  setp(NULL, NULL);
+}
+
+// Hand the current block to the worker threads and move on to the next
+// block in the ring.  If that block is still pending, wait for it to be
+// deflated and write it out first; since the blocks are used in turn,
+// they are written in the order they were filled.
+void bgzfOutputBuffer::submitBlock() {
+  bgzfOutputBlock& block = blocks[currentBlock];
+  block.dataLength = pptr() - pbase();
+  block.pending    = true;
+  pool.submit(&block);
+
+  currentBlock = (currentBlock + 1) % blocks.size();
+  bgzfOutputBlock& next = blocks[currentBlock];
+  if (next.pending) {writeBlock(next);}
+  setp(&next.data[0], &next.data[0] + BGZF_BLOCK_DATA_SIZE);
+}
+
+// Write a deflated block to the file.
+void bgzfOutputBuffer::writeBlock(bgzfOutputBlock& block) {
+  pool.waitFor(&block);
+  if (block.error) {
+    cerr << "ERROR: Failed to compress BGZF block for file: " << filename << endl;
+    exit(1);
+  }
+  if (fwrite(&block.compressed[0], 1, block.blockLength, file) != block.blockLength) {
+    cerr << "ERROR: Failed to write to file: " << filename << endl;
+    exit(1);
+  }
+  block.pending = false;
+}
+
+// The current block is full.
+int bgzfOutputBuffer::overflow(int c) {
+  if (file == NULL) {return traits_type::eof();}
+  submitBlock();
+  if (c != traits_type::eof()) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(c);
+}
+
+// Flushing the stream does not end the current block.
+int bgzfOutputBuffer::sync() {
+  return 0;
+}
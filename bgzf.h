@@ -0,0 +1,144 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define stream buffers for reading BGZF and gzip
+// compressed files and for writing BGZF files.
+// ******************************************************
+
+#ifndef BGZF_H
+#define BGZF_H
+
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <zlib.h>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// BGZF block sizes.  Each block is a complete gzip member containing
+// at most 64kb of uncompressed data.
+#define BGZF_MAX_BLOCK_SIZE 65536
+#define BGZF_BLOCK_DATA_SIZE 65280
+#define BGZF_HEADER_LENGTH 12
+#define BGZF_FOOTER_LENGTH 8
+
+// A single block read from a BGZF file.  The compressed block is read
+// by the main thread and inflated on a worker thread.
+class bgzfBlock : public threadJob {
+  public:
+    bgzfBlock(void);
+    ~bgzfBlock(void);
+    void run();
+
+  public:
+    bool error;
+    bool loaded;
+    uint64_t fileOffset;
+    unsigned int blockLength;
+    unsigned int dataStart;
+    unsigned int dataLength;
+    vector<char> compressed;
+    vector<char> data;
+};
+
+// Stream buffer that reads a gzip compressed file.  If the file is
+// BGZF compressed, the independent blocks are inflated in parallel
+// on a pool of worker threads and served in file order.  Any other
+// gzip file is inflated as a single stream.
+class bgzfInputBuffer : public streambuf {
+  public:
+    bgzfInputBuffer(void);
+    ~bgzfInputBuffer(void);
+    bool open(string&, unsigned int);
+    void close();
+    static bool isCompressed(string&);
+    uint64_t tell();
+    bool seek(uint64_t);
+
+  protected:
+    int underflow();
+
+  public:
+    bool readBlock(bgzfBlock&);
+    bool underflowBgzf();
+    bool underflowGzip();
+
+  public:
+    FILE* file;
+    string filename;
+    bool isBgzf;
+    bool endOfFile;
+
+    // BGZF blocks, used as a ring in file order.
+    threadPool pool;
+    vector<bgzfBlock> blocks;
+    int currentBlock;
+
+    // Stream state for gzip files that are not BGZF.
+    z_stream gzipStream;
+    bool gzipStreamOpen;
+    vector<char> gzipInput;
+    vector<char> gzipOutput;
+};
+
+// A single block to be written to a BGZF file.  The uncompressed data
+// is filled by the main thread and deflated on a worker thread.
+class bgzfOutputBlock : public threadJob {
+  public:
+    bgzfOutputBlock(void);
+    ~bgzfOutputBlock(void);
+    void run();
+
+  public:
+    bool error;
+    bool pending;
+    int compressionLevel;
+    unsigned int blockLength;
+    unsigned int dataLength;
+    vector<char> compressed;
+    vector<char> data;
+};
+
+// Stream buffer that writes a BGZF file.  Each full block is deflated
+// on a pool of worker threads and the compressed blocks are written to
+// the file in order.  Flushing the stream does not end the block, so
+// the stream can be flushed after every line without producing small
+// blocks; the final block and the end of file marker are written when
+// the buffer is closed.
+class bgzfOutputBuffer : public streambuf {
+  public:
+    bgzfOutputBuffer(void);
+    ~bgzfOutputBuffer(void);
+    bool open(string&, unsigned int);
+    void close();
+
+  protected:
+    int overflow(int);
+    int sync();
+
+  public:
+    void submitBlock();
+    void writeBlock(bgzfOutputBlock&);
+
+  public:
+    FILE* file;
+    string filename;
+    threadPool pool;
+    vector<bgzfOutputBlock> blocks;
+    unsigned int currentBlock;
+};
+
+} // namespace vcfCTools
+
+#endif // BGZF_H
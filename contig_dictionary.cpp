@@ -0,0 +1,88 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Map reference sequence names to small integer IDs.
+// ******************************************************
+
+#include "contig_dictionary.h"
+
+using namespace std;
+using namespace vcfCTools;
+
+// Constructor.
+contigDictionary::contigDictionary(void) {
+  pthread_mutex_init(&lock, NULL);
+}
+
+// Destructor.
+contigDictionary::~contigDictionary(void) {
+  pthread_mutex_destroy(&lock);
+}
+
+// Add a reference sequence with a known length (or 0 if the length is not
+// known) and return its ID.  If the sequence has already been seen, the
+// length is updated if it was not known.
+unsigned int contigDictionary::addContig(const string& name, int length) {
+  pthread_mutex_lock(&lock);
+  map<string, unsigned int>::iterator iter = ids.find(name);
+  unsigned int id;
+  if (iter == ids.end()) {
+    id        = names.size();
+    ids[name] = id;
+    names.push_back(name);
+    lengths.push_back(length);
+  } else {
+    id = iter->second;
+    if (lengths[id] == 0) {lengths[id] = length;}
+  }
+  pthread_mutex_unlock(&lock);
+
+  return id;
+}
+
+// Get the ID for a reference sequence, adding it if it has not been seen.
+unsigned int contigDictionary::getID(const string& name) {
+  return addContig(name, 0);
+}
+
+// Get the name of a reference sequence.
+string contigDictionary::getName(unsigned int id) {
+  string name;
+
+  pthread_mutex_lock(&lock);
+  if (id < names.size()) {name = names[id];}
+  pthread_mutex_unlock(&lock);
+
+  return name;
+}
+
+// Get the length of a reference sequence (0 if not known).
+int contigDictionary::getLength(unsigned int id) {
+  int length = 0;
+
+  pthread_mutex_lock(&lock);
+  if (id < lengths.size()) {length = lengths[id];}
+  pthread_mutex_unlock(&lock);
+
+  return length;
+}
+
+// Get the number of reference sequences.
+unsigned int contigDictionary::size() {
+  pthread_mutex_lock(&lock);
+  unsigned int number = names.size();
+  pthread_mutex_unlock(&lock);
+
+  return number;
+}
+
+// The dictionary shared by all files.
+contigDictionary& vcfCTools::sharedContigs() {
+  static contigDictionary contigs;
+
+  return contigs;
+}
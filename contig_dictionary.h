@@ -0,0 +1,59 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Map reference sequence names to small integer IDs.
+// ******************************************************
+
+#ifndef CONTIG_DICTIONARY_H
+#define CONTIG_DICTIONARY_H
+
+#include <pthread.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The ID given to records before any reference sequence has been read.
+#define NO_CONTIG 0xffffffff
+
+// The reference sequences seen so far.  Sequences described in ##contig
+// header lines are added first, in header order, and any others are added
+// when they are first seen in a record, so the IDs also give the order of
+// the reference sequences.  Records carry the ID, so checking whether two
+// records are on the same reference sequence is an integer comparison.
+//
+// A single dictionary is shared by all of the files (see sharedContigs),
+// so that IDs from different files can be compared.  Names are only looked
+// up when the reference sequence changes, so a lock is held for lookups
+// to allow files to be read on multiple threads.
+class contigDictionary {
+  public:
+    contigDictionary(void);
+    ~contigDictionary(void);
+    unsigned int addContig(const string&, int);
+    unsigned int getID(const string&);
+    string getName(unsigned int);
+    int getLength(unsigned int);
+    unsigned int size();
+
+  public:
+    pthread_mutex_t lock;
+    map<string, unsigned int> ids;
+    vector<string> names;
+    vector<int> lengths;
+};
+
+// The dictionary shared by all files.
+contigDictionary& sharedContigs();
+
+} // namespace vcfCTools
+
+#endif // CONTIG_DICTIONARY_H
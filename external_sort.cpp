@@ -0,0 +1,286 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Sort the records of a vcf file that may be larger than
+// memory.
+// ******************************************************
+
+#include "external_sort.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Find the reference sequence ID and position of a record.  Records from
+// the same reference sequence usually follow each other, so the dictionary
+// is only searched when the reference sequence changes.
+static void findLocus(const string& line, string& referenceSequence, unsigned int& referenceSequenceID, int& position) {
+  size_t tab = line.find('\t');
+  if (tab == string::npos) {
+    cerr << "ERROR: Malformed record: " << line << endl;
+    exit(1);
+  }
+  if (referenceSequenceID == NO_CONTIG || line.compare(0, tab, referenceSequence) != 0) {
+    referenceSequence.assign(line, 0, tab);
+    referenceSequenceID = sharedContigs().getID(referenceSequence);
+  }
+  position = atoi(line.c_str() + tab + 1);
+}
+
+// Constructor.
+sortRun::sortRun(void) {}
+
+// Destructor.
+sortRun::~sortRun(void) {}
+
+// Set aside the memory for the run.  Most of it holds the lines and the
+// rest the records pointing into them.  The memory is not touched until
+// it is used, so small inputs do not pay for the whole run.
+void sortRun::reserve(size_t memory) {
+  buffer.reserve(memory - memory / 8);
+  records.reserve(memory / 8 / sizeof(sortRecord));
+}
+
+// Add a record to the run.  If the run is full, the record is not added
+// and false is returned.  A record is always added to an empty run, even
+// if it is larger than the run.
+bool sortRun::add(const string& line, unsigned int referenceSequenceID, int position) {
+  if (records.size() != 0) {
+    if (buffer.size() + line.size() > buffer.capacity() || records.size() == records.capacity()) {return false;}
+  }
+
+  sortRecord record;
+  record.referenceSequenceID = referenceSequenceID;
+  record.position            = position;
+  record.offset              = buffer.size();
+  record.length              = line.size();
+  records.push_back(record);
+  buffer.append(line);
+
+  return true;
+}
+
+// Sort the records.  Records at the same locus keep their input order.
+void sortRun::sortRecords() {
+  stable_sort(records.begin(), records.end(), earlierRecord());
+}
+
+// Write out the lines of the run in record order.
+void sortRun::writeRecords(ostream& stream) {
+  for (vector<sortRecord>::iterator iter = records.begin(); iter != records.end(); iter++) {
+    stream.write(buffer.data() + iter->offset, iter->length);
+    stream.put('\n');
+  }
+}
+
+// Sort the run, write it to its temporary file and release the memory.
+void sortRun::run() {
+  sortRecords();
+
+  vector<char> fileBuffer(SORT_FILE_BUFFER);
+  ofstream file;
+  file.rdbuf()->pubsetbuf(&fileBuffer[0], fileBuffer.size());
+  file.open(filename.c_str());
+  writeRecords(file);
+  file.close();
+  if (file.fail()) {
+    cerr << "ERROR: Unable to write temporary file: " << filename << endl;
+    exit(1);
+  }
+
+  string().swap(buffer);
+  vector<sortRecord>().swap(records);
+}
+
+// Constructor.
+runReader::runReader(void) {
+  index               = 0;
+  position            = 0;
+  referenceSequenceID = NO_CONTIG;
+}
+
+// Destructor.
+runReader::~runReader(void) {}
+
+// Open a run written by a sortRun.
+void runReader::open(const string& filename, unsigned int runIndex) {
+  index = runIndex;
+  fileBuffer.resize(SORT_FILE_BUFFER);
+  file.rdbuf()->pubsetbuf(&fileBuffer[0], fileBuffer.size());
+  file.open(filename.c_str());
+  if (!file.is_open()) {
+    cerr << "ERROR: Unable to open temporary file: " << filename << endl;
+    exit(1);
+  }
+}
+
+// Read the next record of the run.  Returns false once the run is
+// exhausted.
+bool runReader::next() {
+  if (!getline(file, line)) {return false;}
+  findLocus(line, referenceSequence, referenceSequenceID, position);
+
+  return true;
+}
+
+// Constructor.
+externalSorter::externalSorter(void) {
+  currentRun          = NULL;
+  referenceSequenceID = NO_CONTIG;
+  runMemory           = 0;
+  threads             = 0;
+}
+
+// Destructor.
+externalSorter::~externalSorter(void) {
+  pool.waitAll();
+  for (vector<sortRun*>::iterator iter = pendingRuns.begin(); iter != pendingRuns.end(); iter++) {delete *iter;}
+  delete currentRun;
+}
+
+// Set the memory budget (in bytes), the directory for the temporary files
+// and the number of threads sorting runs.  While a full run is sorted, the
+// next run is filled, so the memory is divided between the run being
+// filled and one run for each thread.
+void externalSorter::start(size_t memory, const string& directory, unsigned int numberThreads) {
+  tempDirectory = directory;
+  threads       = numberThreads;
+  runMemory     = memory / (threads + 1);
+  pool.startThreads(threads);
+}
+
+// Create an empty temporary file and return its name.
+string externalSorter::createTemporaryFile() {
+  string name = tempDirectory + "/vcfCTools_sort.XXXXXX";
+  vector<char> filename(name.begin(), name.end());
+  filename.push_back('\0');
+
+  int descriptor = mkstemp(&filename[0]);
+  if (descriptor == -1) {
+    cerr << "ERROR: Unable to create temporary file in " << tempDirectory << endl;
+    exit(1);
+  }
+  close(descriptor);
+
+  return string(&filename[0]);
+}
+
+// Hand the current run to the thread pool to be sorted and written out.
+// Only one run per thread is held at a time, so if all of the threads are
+// busy, wait for the oldest run to be written.
+void externalSorter::spillRun() {
+  while (pendingRuns.size() != 0 && pendingRuns.size() >= threads) {
+    pool.waitFor(pendingRuns.front());
+    delete pendingRuns.front();
+    pendingRuns.erase(pendingRuns.begin());
+  }
+
+  currentRun->filename = createTemporaryFile();
+  runFiles.push_back(currentRun->filename);
+  pool.submit(currentRun);
+  pendingRuns.push_back(currentRun);
+  currentRun = NULL;
+}
+
+// Add a record.
+void externalSorter::add(const string& line) {
+  int position;
+  findLocus(line, referenceSequence, referenceSequenceID, position);
+
+  if (currentRun == NULL) {
+    currentRun = new sortRun();
+    currentRun->reserve(runMemory);
+  }
+  if (!currentRun->add(line, referenceSequenceID, position)) {
+    spillRun();
+    currentRun = new sortRun();
+    currentRun->reserve(runMemory);
+    currentRun->add(line, referenceSequenceID, position);
+  }
+}
+
+// Merge sorted runs with a heap of run readers, writing the records to
+// either the output or a stream.  The runs are deleted once merged.
+void externalSorter::mergeRuns(vector<string>& files, output* ofile, ostream* stream) {
+  vector<runReader*> heap;
+  for (unsigned int i = 0; i < files.size(); i++) {
+    runReader* reader = new runReader();
+    reader->open(files[i], i);
+    if (reader->next()) {heap.push_back(reader);}
+    else {delete reader;}
+  }
+  make_heap(heap.begin(), heap.end(), laterRun());
+
+  while (heap.size() != 0) {
+    pop_heap(heap.begin(), heap.end(), laterRun());
+    runReader* reader = heap.back();
+    if (ofile != NULL) {ofile->writeRecord(reader->line);}
+    else {*stream << reader->line << '\n';}
+
+    if (reader->next()) {push_heap(heap.begin(), heap.end(), laterRun());}
+    else {
+      delete reader;
+      heap.pop_back();
+    }
+  }
+
+  for (vector<string>::iterator iter = files.begin(); iter != files.end(); iter++) {unlink(iter->c_str());}
+}
+
+// Write out all of the records in order.  If every record fit in a single
+// run, the run is sorted in memory and written directly.  Otherwise, the
+// last run is written out and all runs are merged.  If there are too many
+// runs to merge at once, consecutive groups of runs are merged into longer
+// runs first.  Merging consecutive runs keeps records at the same locus in
+// their input order.
+void externalSorter::finish(output& ofile) {
+  if (runFiles.size() == 0) {
+    if (currentRun == NULL) {return;}
+
+    currentRun->sortRecords();
+    string line;
+    for (vector<sortRecord>::iterator iter = currentRun->records.begin(); iter != currentRun->records.end(); iter++) {
+      line.assign(currentRun->buffer, iter->offset, iter->length);
+      ofile.writeRecord(line);
+    }
+    delete currentRun;
+    currentRun = NULL;
+
+    return;
+  }
+
+  if (currentRun != NULL) {spillRun();}
+  pool.waitAll();
+  for (vector<sortRun*>::iterator iter = pendingRuns.begin(); iter != pendingRuns.end(); iter++) {delete *iter;}
+  pendingRuns.clear();
+
+  while (runFiles.size() > SORT_MERGE_FILES) {
+    vector<string> mergedFiles;
+    for (unsigned int start = 0; start < runFiles.size(); start += SORT_MERGE_FILES) {
+      unsigned int end = min(start + SORT_MERGE_FILES, (unsigned int) runFiles.size());
+      vector<string> group(runFiles.begin() + start, runFiles.begin() + end);
+
+      string filename = createTemporaryFile();
+      vector<char> fileBuffer(SORT_FILE_BUFFER);
+      ofstream file;
+      file.rdbuf()->pubsetbuf(&fileBuffer[0], fileBuffer.size());
+      file.open(filename.c_str());
+      mergeRuns(group, NULL, &file);
+      file.close();
+      if (file.fail()) {
+        cerr << "ERROR: Unable to write temporary file: " << filename << endl;
+        exit(1);
+      }
+      mergedFiles.push_back(filename);
+    }
+    runFiles.swap(mergedFiles);
+  }
+  mergeRuns(runFiles, &ofile, NULL);
+  runFiles.clear();
+}
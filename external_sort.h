@@ -0,0 +1,141 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Sort the records of a vcf file that may be larger than
+// memory.
+// ******************************************************
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "contig_dictionary.h"
+#include "output.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The maximum number of runs merged at once.  If there are more runs,
+// they are first merged in groups into longer runs.
+#define SORT_MERGE_FILES 128
+
+// The size of the file buffer used for each run.
+#define SORT_FILE_BUFFER 262144
+
+// A record held in a run.  The line is kept in the run's buffer and the
+// reference sequence ID and position are found once, when the record is
+// added.
+struct sortRecord {
+  unsigned int referenceSequenceID;
+  int position;
+  size_t offset;
+  unsigned int length;
+};
+
+// Order records by reference sequence ID and then position.
+struct earlierRecord {
+  bool operator()(const sortRecord& a, const sortRecord& b) const {
+    if (a.referenceSequenceID != b.referenceSequenceID) {return a.referenceSequenceID < b.referenceSequenceID;}
+
+    return a.position < b.position;
+  }
+};
+
+// A run of records that fits in the memory given to it.  Once full, the
+// run is sorted and written to a temporary file on one of the worker
+// threads, and its memory is released.
+class sortRun : public threadJob {
+  public:
+    sortRun(void);
+    ~sortRun(void);
+    void reserve(size_t);
+    bool add(const string&, unsigned int, int);
+    void sortRecords();
+    void writeRecords(ostream&);
+    void run();
+
+  public:
+    string buffer;
+    vector<sortRecord> records;
+    string filename;
+};
+
+// Read the records of a sorted run back in.
+class runReader {
+  public:
+    runReader(void);
+    ~runReader(void);
+    void open(const string&, unsigned int);
+    bool next();
+
+  public:
+    ifstream file;
+    vector<char> fileBuffer;
+    unsigned int index;
+    string line;
+    string referenceSequence;
+    unsigned int referenceSequenceID;
+    int position;
+};
+
+// Order the runs on the heap by their current records.  Records at the
+// same locus are taken from the earliest run, so that the sort is stable.
+// The standard heap functions keep the largest element at the front, so
+// the comparison is reversed.
+struct laterRun {
+  bool operator()(runReader* a, runReader* b) const {
+    if (a->referenceSequenceID != b->referenceSequenceID) {return a->referenceSequenceID > b->referenceSequenceID;}
+    if (a->position != b->position) {return a->position > b->position;}
+
+    return a->index > b->index;
+  }
+};
+
+// Sort records with a fixed memory budget.  Records are collected into
+// runs and each full run is sorted (on a pool of threads) and written to
+// a temporary file.  The runs are then merged with a k-way heap.  The
+// records are ordered by the reference sequence IDs in the shared contig
+// dictionary (the order of the ##contig header lines, followed by any other
+// reference sequences in the order they are first seen) and then by
+// position.  Records at the same locus keep their input order.
+class externalSorter {
+  public:
+    externalSorter(void);
+    ~externalSorter(void);
+    void start(size_t, const string&, unsigned int);
+    void add(const string&);
+    void finish(output&);
+    string createTemporaryFile();
+    void mergeRuns(vector<string>&, output*, ostream*);
+    void spillRun();
+
+  public:
+    size_t runMemory;
+    string tempDirectory;
+    unsigned int threads;
+    threadPool pool;
+
+    // The run being filled and the runs being sorted.
+    sortRun* currentRun;
+    vector<sortRun*> pendingRuns;
+    vector<string> runFiles;
+
+    // The reference sequence of the last record added.
+    string referenceSequence;
+    unsigned int referenceSequenceID;
+};
+
+} // namespace vcfCTools
+
+#endif // EXTERNAL_SORT_H
@@ -0,0 +1,414 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Compile a filter expression (e.g. QUAL>30 && INFO/DP>10)
+// into a list of instructions and evaluate it for each
+// record.
+// ******************************************************
+
+#include "filter_expression.h"
+
+#include <cctype>
+#include <limits>
+#include <string.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Check if a value is true.  Missing values (NaN) are false.
+static bool isTrue(double value) {
+  return value == value && value != 0.;
+}
+
+// Compare two values.  The comparison fails if either value is missing.
+static bool compareValues(filterOperation comparison, double a, double b) {
+  if (a != a || b != b) {return false;}
+
+  switch (comparison) {
+    case FILTER_LESS:          return a < b;
+    case FILTER_LESS_EQUAL:    return a <= b;
+    case FILTER_GREATER:       return a > b;
+    case FILTER_GREATER_EQUAL: return a >= b;
+    case FILTER_EQUAL:         return a == b;
+    case FILTER_NOT_EQUAL:     return a != b;
+    default:                   return false;
+  }
+}
+
+// Reverse a comparison, so that 'a op b' becomes 'b op a'.
+static filterOperation mirrorComparison(filterOperation comparison) {
+  switch (comparison) {
+    case FILTER_LESS:          return FILTER_GREATER;
+    case FILTER_LESS_EQUAL:    return FILTER_GREATER_EQUAL;
+    case FILTER_GREATER:       return FILTER_LESS;
+    case FILTER_GREATER_EQUAL: return FILTER_LESS_EQUAL;
+    default:                   return comparison;
+  }
+}
+
+// Constructor.
+filterExpression::filterExpression(void) {
+  header     = NULL;
+  nextToken  = 0;
+  usesInfo   = false;
+  usesFormat = false;
+}
+
+// Destructor.
+filterExpression::~filterExpression(void) {}
+
+// Compile the expression.  Any error in the expression terminates the
+// program.
+void filterExpression::compile(const string& expression, vcfHeader& vcfHeader) {
+  text   = expression;
+  header = &vcfHeader;
+  instructions.clear();
+  usesInfo   = false;
+  usesFormat = false;
+
+  tokenise(expression);
+  if (tokens.size() == 0) {syntaxError("the expression is empty");}
+  nextToken = 0;
+  parseOr();
+  if (nextToken != tokens.size()) {syntaxError("unexpected '" + tokens[nextToken] + "'");}
+  tokens.clear();
+}
+
+// Split the expression into numbers, names, operators and brackets.
+void filterExpression::tokenise(const string& expression) {
+  tokens.clear();
+  size_t i = 0;
+  while (i < expression.size()) {
+    char c = expression[i];
+    if (isspace(c)) {
+      i++;
+      continue;
+    }
+
+    // Two character operators.
+    string pair = expression.substr(i, 2);
+    if (pair == "&&" || pair == "||" || pair == "<=" || pair == ">=" || pair == "==" || pair == "!=") {
+      tokens.push_back(pair);
+      i += 2;
+
+    // Single character operators.
+    } else if (strchr("<>=!()", c) != NULL) {
+      tokens.push_back(string(1, c));
+      i++;
+
+    // Numbers.  A minus sign belongs to the number unless it follows a
+    // value.
+    } else if (isdigit(c) || c == '.' || (c == '-' && (tokens.size() == 0 || strchr("<>=!(&|", tokens.back()[0]) != NULL))) {
+      char* stop;
+      strtod(expression.c_str() + i, &stop);
+      size_t length = stop - (expression.c_str() + i);
+      if (length == 0) {syntaxError("malformed number at '" + expression.substr(i) + "'");}
+      tokens.push_back(expression.substr(i, length));
+      i += length;
+
+    // Names (e.g. QUAL, INFO/DP or INFO/AF[1]).
+    } else if (isalpha(c) || c == '_') {
+      size_t start = i;
+      while (i < expression.size() && (isalnum(expression[i]) || strchr("_./[]", expression[i]) != NULL)) {i++;}
+      tokens.push_back(expression.substr(start, i - start));
+    } else {
+      syntaxError("unexpected character '" + string(1, c) + "'");
+    }
+  }
+}
+
+// expression := and ('||' and)*
+void filterExpression::parseOr() {
+  parseAnd();
+  while (nextToken < tokens.size() && tokens[nextToken] == "||") {
+    nextToken++;
+    unsigned int jump = instructions.size();
+    addInstruction(FILTER_JUMP_IF_TRUE);
+    parseAnd();
+    instructions[jump].target = instructions.size();
+  }
+}
+
+// and := not ('&&' not)*
+void filterExpression::parseAnd() {
+  parseNot();
+  while (nextToken < tokens.size() && tokens[nextToken] == "&&") {
+    nextToken++;
+    unsigned int jump = instructions.size();
+    addInstruction(FILTER_JUMP_IF_FALSE);
+    parseNot();
+    instructions[jump].target = instructions.size();
+  }
+}
+
+// not := '!' not | comparison
+void filterExpression::parseNot() {
+  if (nextToken < tokens.size() && tokens[nextToken] == "!") {
+    nextToken++;
+    parseNot();
+    addInstruction(FILTER_NOT);
+  } else {
+    parseComparison();
+  }
+}
+
+// comparison := '(' expression ')' | operand (operator operand)?
+//
+// An info field that is not compared is true if the record has the
+// field, so flags can be used on their own.
+void filterExpression::parseComparison() {
+  if (nextToken < tokens.size() && tokens[nextToken] == "(") {
+    nextToken++;
+    parseOr();
+    if (nextToken >= tokens.size() || tokens[nextToken] != ")") {syntaxError("missing ')'");}
+    nextToken++;
+    return;
+  }
+
+  filterInstruction left;
+  bool leftIsFormat = parseOperand(left);
+  filterOperation comparison;
+  if (!parseComparisonOperator(comparison)) {
+    if (leftIsFormat) {syntaxError("format field " + left.key + " must be compared with a number");}
+    if (left.operation == FILTER_PUSH_INFO) {left.operation = FILTER_INFO_PRESENT;}
+    instructions.push_back(left);
+    return;
+  }
+
+  filterInstruction right;
+  bool rightIsFormat = parseOperand(right);
+
+  // Format fields are compared with a constant for every sample, so the
+  // comparison is a single instruction.
+  if (leftIsFormat || rightIsFormat) {
+    filterInstruction& field    = leftIsFormat ? left : right;
+    filterInstruction& constant = leftIsFormat ? right : left;
+    if (constant.operation != FILTER_PUSH_CONSTANT) {syntaxError("format field " + field.key + " must be compared with a number");}
+    field.operation  = FILTER_FORMAT_COMPARE;
+    field.comparison = leftIsFormat ? comparison : mirrorComparison(comparison);
+    field.value      = constant.value;
+    instructions.push_back(field);
+    return;
+  }
+
+  // Only numeric info fields can be compared.
+  filterInstruction* operands[2] = {&left, &right};
+  for (unsigned int i = 0; i < 2; i++) {
+    if (operands[i]->operation != FILTER_PUSH_INFO) {continue;}
+    infoType type = header->infoTags.tags[operands[i]->tag].type;
+    if (type != INFO_TYPE_INTEGER && type != INFO_TYPE_FLOAT) {
+      syntaxError("info field " + header->infoTags.tags[operands[i]->tag].name + " is not numeric");
+    }
+  }
+  instructions.push_back(left);
+  instructions.push_back(right);
+  addInstruction(comparison);
+}
+
+// Parse a number, QUAL, POS, an info field (INFO/TAG or TAG) or a format
+// field (FORMAT/TAG).  A field can be followed by the index of the value
+// in brackets (e.g. INFO/AF[1]); the first value is used otherwise.
+// Returns true if the operand is a format field.
+bool filterExpression::parseOperand(filterInstruction& operand) {
+  if (nextToken >= tokens.size()) {syntaxError("the expression ends early");}
+  string token = tokens[nextToken++];
+
+  operand.tag        = NO_INFO_TAG;
+  operand.index      = 0;
+  operand.target     = 0;
+  operand.comparison = FILTER_EQUAL;
+  operand.value      = 0.;
+  operand.key        = "";
+
+  if (isdigit(token[0]) || token[0] == '.' || token[0] == '-') {
+    operand.operation = FILTER_PUSH_CONSTANT;
+    operand.value     = atof(token.c_str());
+    return false;
+  } else if (token == "QUAL") {
+    operand.operation = FILTER_PUSH_QUALITY;
+    return false;
+  } else if (token == "POS") {
+    operand.operation = FILTER_PUSH_POSITION;
+    return false;
+  } else if (!isalpha(token[0]) && token[0] != '_') {
+    syntaxError("expected a value at '" + token + "'");
+  }
+
+  // Split off the index.
+  size_t bracket = token.find('[');
+  if (bracket != string::npos) {
+    if (token[token.size() - 1] != ']' || bracket + 2 >= token.size()) {syntaxError("malformed index in '" + token + "'");}
+    string index = token.substr(bracket + 1, token.size() - bracket - 2);
+    for (size_t i = 0; i < index.size(); i++) {
+      if (!isdigit(index[i])) {syntaxError("malformed index in '" + token + "'");}
+    }
+    operand.index = atoi(index.c_str());
+    token         = token.substr(0, bracket);
+  }
+
+  if (token.compare(0, 7, "FORMAT/") == 0 || token.compare(0, 4, "FMT/") == 0) {
+    operand.operation = FILTER_FORMAT_COMPARE;
+    operand.key       = token.substr(token.find('/') + 1);
+    if (header->formatFields.count(operand.key) == 0) {
+      cerr << "ERROR: No header description for format tag in the filter expression: " << operand.key << endl;
+      exit(1);
+    }
+    usesFormat = true;
+    return true;
+  }
+
+  if (token.compare(0, 5, "INFO/") == 0) {token = token.substr(5);}
+  operand.operation = FILTER_PUSH_INFO;
+  operand.key       = token;
+  operand.tag       = header->infoTags.getID(token);
+  if (operand.tag == NO_INFO_TAG) {
+    cerr << "ERROR: No header description for info tag in the filter expression: " << token << endl;
+    exit(1);
+  }
+  recordInfo.selectTag(operand.tag);
+  usesInfo = true;
+
+  return false;
+}
+
+// Parse a comparison operator if there is one.
+bool filterExpression::parseComparisonOperator(filterOperation& comparison) {
+  if (nextToken >= tokens.size()) {return false;}
+
+  string& token = tokens[nextToken];
+  if (token == "<") {comparison = FILTER_LESS;}
+  else if (token == "<=") {comparison = FILTER_LESS_EQUAL;}
+  else if (token == ">") {comparison = FILTER_GREATER;}
+  else if (token == ">=") {comparison = FILTER_GREATER_EQUAL;}
+  else if (token == "==" || token == "=") {comparison = FILTER_EQUAL;}
+  else if (token == "!=") {comparison = FILTER_NOT_EQUAL;}
+  else {return false;}
+  nextToken++;
+
+  return true;
+}
+
+// Add an instruction that has no operands.
+void filterExpression::addInstruction(filterOperation operation) {
+  filterInstruction instruction;
+  instruction.operation  = operation;
+  instruction.tag        = NO_INFO_TAG;
+  instruction.index      = 0;
+  instruction.target     = 0;
+  instruction.comparison = operation;
+  instruction.value      = 0.;
+  instructions.push_back(instruction);
+}
+
+// Report an error in the expression and terminate.
+void filterExpression::syntaxError(const string& message) {
+  cerr << "ERROR: Malformed filter expression (" << message << "): " << text << endl;
+  exit(1);
+}
+
+// Evaluate the expression for a record.
+bool filterExpression::evaluate(originalVariants& ov) {
+  bool infoDecoded      = false;
+  bool genotypesChecked = false;
+
+  stack.clear();
+  unsigned int next = 0;
+  while (next < instructions.size()) {
+    filterInstruction& instruction = instructions[next++];
+    switch (instruction.operation) {
+      case FILTER_PUSH_CONSTANT:
+        stack.push_back(instruction.value);
+        break;
+
+      case FILTER_PUSH_QUALITY:
+        stack.push_back(ov.quality);
+        break;
+
+      case FILTER_PUSH_POSITION:
+        stack.push_back(ov.position);
+        break;
+
+      // The info string is decoded the first time it is needed.
+      case FILTER_PUSH_INFO:
+      case FILTER_INFO_PRESENT:
+        if (!infoDecoded) {
+          recordInfo.decode(header->infoTags, ov.info, ov.numberAlts);
+          infoDecoded = true;
+        }
+        if (instruction.operation == FILTER_INFO_PRESENT) {
+          stack.push_back(recordInfo.hasTag(instruction.tag) ? 1. : 0.);
+        } else {
+          double value;
+          if (!recordInfo.getFloat(instruction.tag, instruction.index, value)) {value = numeric_limits<double>::quiet_NaN();}
+          stack.push_back(value);
+        }
+        break;
+
+      // The genotypes are only read when a format comparison is reached.
+      case FILTER_FORMAT_COMPARE:
+        if (!genotypesChecked) {
+          genotypeView.setRecord(ov.genotypeFormat, ov.genotypes);
+          genotypesChecked = true;
+        }
+        stack.push_back(compareFormat(instruction) ? 1. : 0.);
+        break;
+
+      case FILTER_NOT:
+        stack.back() = isTrue(stack.back()) ? 0. : 1.;
+        break;
+
+      // The value deciding an '&&' or '||' is left as the result.
+      case FILTER_JUMP_IF_FALSE:
+        if (!isTrue(stack.back())) {next = instruction.target;}
+        else {stack.pop_back();}
+        break;
+
+      case FILTER_JUMP_IF_TRUE:
+        if (isTrue(stack.back())) {next = instruction.target;}
+        else {stack.pop_back();}
+        break;
+
+      // Comparisons.
+      default: {
+        double b = stack.back();
+        stack.pop_back();
+        stack.back() = compareValues(instruction.operation, stack.back(), b) ? 1. : 0.;
+        break;
+      }
+    }
+  }
+
+  return isTrue(stack.back());
+}
+
+// Check if any sample has a value of the format field satisfying the
+// comparison.  Samples without the field, or with a missing value, do not.
+bool filterExpression::compareFormat(filterInstruction& instruction) {
+  int field = genotypeView.formatIndex(instruction.key);
+  if (field == -1) {return false;}
+
+  stringSpan span;
+  for (unsigned int sample = 0; genotypeView.findSample(sample); sample++) {
+    if (!genotypeView.getField(sample, field, span)) {continue;}
+
+    // Find the requested value in the comma separated list.
+    const char* start = genotypeView.genotypes->c_str() + span.start;
+    const char* end   = start + span.length;
+    for (unsigned int i = 0; i < instruction.index && start != NULL; i++) {
+      start = (const char*) memchr(start, ',', end - start);
+      if (start != NULL) {start++;}
+    }
+    if (start == NULL || start == end) {continue;}
+
+    char* stop;
+    double value = strtod(start, &stop);
+    if (stop == start || (stop != end && *stop != ',')) {continue;}
+    if (compareValues(instruction.comparison, value, instruction.value)) {return true;}
+  }
+
+  return false;
+}
@@ -0,0 +1,111 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Compile a filter expression (e.g. QUAL>30 && INFO/DP>10)
+// into a list of instructions and evaluate it for each
+// record.
+// ******************************************************
+
+#ifndef FILTER_EXPRESSION_H
+#define FILTER_EXPRESSION_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "genotype_columns.h"
+#include "header.h"
+#include "info_dictionary.h"
+#include "variant.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The operations of the compiled expression.  Values are pushed on to a
+// stack and comparisons replace the top two values with 1 (true) or 0
+// (false).  The logical operators are compiled into jumps, so the second
+// operand is not evaluated if the first decides the result.
+enum filterOperation {
+  FILTER_PUSH_CONSTANT,
+  FILTER_PUSH_QUALITY,
+  FILTER_PUSH_POSITION,
+  FILTER_PUSH_INFO,
+  FILTER_INFO_PRESENT,
+  FILTER_FORMAT_COMPARE,
+  FILTER_LESS,
+  FILTER_LESS_EQUAL,
+  FILTER_GREATER,
+  FILTER_GREATER_EQUAL,
+  FILTER_EQUAL,
+  FILTER_NOT_EQUAL,
+  FILTER_NOT,
+  FILTER_JUMP_IF_FALSE,
+  FILTER_JUMP_IF_TRUE
+};
+
+// A single instruction.  The tag and index give the info field and value
+// to push, and the target is the instruction jumped to.  A format
+// comparison holds the format key, the comparison and the constant it is
+// compared with.
+struct filterInstruction {
+  filterOperation operation;
+  unsigned int tag;
+  unsigned int index;
+  unsigned int target;
+  filterOperation comparison;
+  double value;
+  string key;
+};
+
+// The expression is compiled once, with info tags resolved to their IDs
+// in the header dictionary.  When a record is evaluated, the info string
+// is only decoded if an info field is reached, and the genotypes are only
+// read if a format comparison is reached.  A missing value fails every
+// comparison.  A format comparison is true if any sample satisfies it.
+class filterExpression {
+  public:
+    filterExpression(void);
+    ~filterExpression(void);
+    void compile(const string&, vcfHeader&);
+    bool evaluate(originalVariants&);
+
+  private:
+    void tokenise(const string&);
+    void parseOr();
+    void parseAnd();
+    void parseNot();
+    void parseComparison();
+    bool parseOperand(filterInstruction&);
+    bool parseComparisonOperator(filterOperation&);
+    void addInstruction(filterOperation);
+    void syntaxError(const string&);
+    bool compareFormat(filterInstruction&);
+
+  public:
+    string text;
+    vcfHeader* header;
+    vector<filterInstruction> instructions;
+    bool usesInfo;
+    bool usesFormat;
+
+  private:
+
+    // Compilation.
+    vector<string> tokens;
+    unsigned int nextToken;
+
+    // Evaluation.
+    vector<double> stack;
+    infoValues recordInfo;
+    genotypeColumns genotypeView;
+};
+
+} // namespace vcfCTools
+
+#endif // FILTER_EXPRESSION_H
@@ -0,0 +1,200 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// A view of the sample genotype columns of a record that
+// is only decoded as far as it is used.
+// ******************************************************
+
+#include "genotype_columns.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Constructor.
+genotypeColumns::genotypeColumns(void) {
+  genotypes       = NULL;
+  nextSample      = 0;
+  allSamplesFound = true;
+}
+
+// Destructor.
+genotypeColumns::~genotypeColumns(void) {}
+
+// Point the view at the genotype format and genotype string of a new
+// record.  Consecutive records usually share the same format, so the
+// format is only split when it changes.  The genotype string must not be
+// modified while the view is in use.
+void genotypeColumns::setRecord(string& genotypeFormat, string& genotypeString) {
+  if (genotypeFormat != format || formats.size() == 0) {
+    format = genotypeFormat;
+    formats.clear();
+    split(format, ':', formats);
+  }
+  genotypes       = &genotypeString;
+  nextSample      = 0;
+  allSamplesFound = genotypeString.empty();
+  samples.clear();
+}
+
+// Check that all of the entries in the format have a header description.
+void genotypeColumns::checkFormats(vcfHeader& header) {
+  for (vector<string>::iterator iter = formats.begin(); iter != formats.end(); iter++) {
+    if (header.formatFields.count(*iter) == 0) {
+      cerr << "ERROR: No header description for format tag: " << *iter << endl;
+      exit(1);
+    }
+  }
+}
+
+// Find the position of a key in the format, or -1 if the key is absent.
+int genotypeColumns::formatIndex(const string& key) {
+  for (unsigned int i = 0; i < formats.size(); i++) {
+    if (formats[i] == key) {return (int) i;}
+  }
+
+  return -1;
+}
+
+// Find the boundaries of all samples up to and including the requested
+// sample.  Returns false if the record has fewer samples.
+bool genotypeColumns::findSample(unsigned int sample) {
+  const char* begin = genotypes->data();
+  const char* end   = begin + genotypes->size();
+
+  while (samples.size() <= sample) {
+    if (allSamplesFound) {return false;}
+
+    const char* start = begin + nextSample;
+    const char* tab   = (const char*) memchr(start, '\t', end - start);
+    stringSpan span;
+    span.start = nextSample;
+    if (tab == NULL) {
+      span.length     = end - start;
+      allSamplesFound = true;
+    } else {
+      span.length = tab - start;
+      nextSample  = tab - begin + 1;
+    }
+    samples.push_back(span);
+  }
+
+  return true;
+}
+
+// Count the samples.  This finds the boundaries of every sample.
+unsigned int genotypeColumns::numberSamples() {
+  while (findSample(samples.size())) {}
+
+  return samples.size();
+}
+
+// If the genotypes for a sample could not be determined, the entry is
+// simply '.'.
+bool genotypeColumns::isMissing(unsigned int sample) {
+  if (!findSample(sample)) {return true;}
+
+  return samples[sample].length == 1 && (*genotypes)[samples[sample].start] == '.';
+}
+
+// Count the fields for a sample without recording their positions.
+unsigned int genotypeColumns::numberFields(unsigned int sample) {
+  if (!findSample(sample)) {return 0;}
+
+  const char* start = genotypes->data() + samples[sample].start;
+  const char* end   = start + samples[sample].length;
+  unsigned int count = 1;
+  while ((start = (const char*) memchr(start, ':', end - start)) != NULL) {
+    start++;
+    count++;
+  }
+
+  return count;
+}
+
+// Find all of the fields for a sample.  The number of fields is returned.
+unsigned int genotypeColumns::getFields(unsigned int sample, vector<stringSpan>& fields) {
+  fields.clear();
+  if (!findSample(sample)) {return 0;}
+
+  const char* begin = genotypes->data();
+  const char* start = begin + samples[sample].start;
+  const char* end   = start + samples[sample].length;
+  while (true) {
+    const char* colon = (const char*) memchr(start, ':', end - start);
+    stringSpan span;
+    span.start  = start - begin;
+    span.length = ((colon == NULL) ? end : colon) - start;
+    fields.push_back(span);
+    if (colon == NULL) {break;}
+    start = colon + 1;
+  }
+
+  return fields.size();
+}
+
+// Find a single field (given by its position in the format) for a
+// sample, only scanning the sample as far as that field.  Returns false
+// if the sample does not include the field.
+bool genotypeColumns::getField(unsigned int sample, int field, stringSpan& span) {
+  if (field < 0 || !findSample(sample)) {return false;}
+
+  const char* begin = genotypes->data();
+  const char* start = begin + samples[sample].start;
+  const char* end   = start + samples[sample].length;
+  for (int i = 0; i < field; i++) {
+    const char* colon = (const char*) memchr(start, ':', end - start);
+    if (colon == NULL) {return false;}
+    start = colon + 1;
+  }
+  const char* colon = (const char*) memchr(start, ':', end - start);
+  span.start  = start - begin;
+  span.length = ((colon == NULL) ? end : colon) - start;
+
+  return true;
+}
+
+// Get a field as a floating point value.  Missing fields have the value
+// zero.
+double genotypeColumns::getDouble(unsigned int sample, int field) {
+  stringSpan span;
+  if (!getField(sample, field, span)) {return 0.;}
+
+  return strtod(genotypes->c_str() + span.start, NULL);
+}
+
+// Get the allele IDs from a GT field.  Alleles that are unknown ('.')
+// are given the ID -1.  The flags record whether phased ('|') and
+// unphased ('/') separators are present.  The number of alleles is
+// returned.
+unsigned int genotypeColumns::getAlleles(stringSpan& span, vector<int>& alleles, bool& phased, bool& unphased) {
+  const char* start = genotypes->data() + span.start;
+  const char* end   = start + span.length;
+
+  alleles.clear();
+  phased   = false;
+  unphased = false;
+  int allele   = 0;
+  bool unknown = false;
+  for (const char* c = start; c <= end; c++) {
+    if (c == end || *c == '/' || *c == '|') {
+      alleles.push_back(unknown ? -1 : allele);
+      allele  = 0;
+      unknown = false;
+      if (c == end) {break;}
+      if (*c == '/') {unphased = true;}
+      else {phased = true;}
+    } else if (*c == '.') {
+      unknown = true;
+    } else if (*c >= '0' && *c <= '9') {
+      allele = 10 * allele + (*c - '0');
+    }
+  }
+
+  return alleles.size();
+}
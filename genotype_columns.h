@@ -0,0 +1,61 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// A view of the sample genotype columns of a record that
+// is only decoded as far as it is used.
+// ******************************************************
+
+#ifndef GENOTYPE_COLUMNS_H
+#define GENOTYPE_COLUMNS_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "header.h"
+#include "split.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The view holds a pointer to the genotype string of the record rather
+// than a copy.  The sample boundaries are found on demand, in a single
+// pass along the string, so asking for the first few samples does not
+// scan the rest of the record.  Fields are returned as spans of the
+// genotype string, so no strings are created for the samples.  The
+// view is reused from record to record, so once the vectors have grown
+// to size no further allocation is made.
+class genotypeColumns {
+  public:
+    genotypeColumns(void);
+    ~genotypeColumns(void);
+    void setRecord(string&, string&);
+    void checkFormats(vcfHeader&);
+    int formatIndex(const string&);
+    unsigned int numberSamples();
+    bool findSample(unsigned int);
+    bool isMissing(unsigned int);
+    unsigned int numberFields(unsigned int);
+    unsigned int getFields(unsigned int, vector<stringSpan>&);
+    bool getField(unsigned int, int, stringSpan&);
+    double getDouble(unsigned int, int);
+    unsigned int getAlleles(stringSpan&, vector<int>&, bool&, bool&);
+
+  public:
+    string format;
+    const string* genotypes;
+    vector<string> formats;
+    vector<stringSpan> samples;
+    size_t nextSample;
+    bool allSamplesFound;
+};
+
+} // namespace vcfCTools
+
+#endif // GENOTYPE_COLUMNS_H
@@ -15,10 +15,10 @@ using namespace vcfCTools;
 
 // Constructor
 genotypeInfo::genotypeInfo(string format, string gen) {
+  errorStream     = &cerr;
   genotypeFormat  = format;
   genotypeString  = gen;
   genotypeFormats = split(genotypeFormat, ":");
-  genotypes       = split(gen, "\t");
   genotypeFields.clear();
 };
 
@@ -26,120 +26,100 @@ genotypeInfo::genotypeInfo(string format, string gen) {
 genotypeInfo::~genotypeInfo(void) {};
 
 // Modify the genotypes to reflect modifications to the alleles
-// present in this record.
+// present in this record.  The samples are read through a genotype
+// view, so the fields are copied straight from the original string into
+// the modified string.
 void genotypeInfo::modifyGenotypes(vcfHeader& header, vector<int>& alleleIDs) {
-  bool success;
-  int gtInt;
-  string connector;
-  string modifiedGenotype;
+  bool phased, unphased;
   string modifiedGenotypeString;
-  string modifiedGT;
-  string modifiedField;
-  vector<string> originalGenotypes;
-  vector<string> fields;
-  vector<string>::iterator fieldsIter;
-  vector<int>::iterator alleleIter;
-
-  // Split the genotype format and genotype string.
-  genotypeStrings = split(genotypeString, "\t");
-  formats         = split(genotypeFormat, ":");
+  vector<int> alleles;
+  vector<stringSpan> fields;
+  vector<stringSpan> values;
+  vector<string> numbers;
+  genotypeColumns view;
+
+  view.setRecord(genotypeFormat, genotypeString);
+  int gtIndex = view.formatIndex("GT");
+
+  // Determine the number of values of each field in the format.
+  for (vector<string>::iterator fIter = view.formats.begin(); fIter != view.formats.end(); fIter++) {
+    map<string, headerInfo>::iterator iter = header.formatFields.find(*fIter);
+    numbers.push_back((iter == header.formatFields.end()) ? "" : iter->second.number);
+  }
+  modifiedGenotypeString.reserve(genotypeString.size());
 
   // Loop through each sample modifying the genotype as necessary.
-  vector<string>::iterator iter = genotypeStrings.begin();
-  for (; iter != genotypeStrings.end(); iter++) {
-    modifiedGenotype = "";
+  const char* data = genotypeString.data();
+  for (unsigned int sample = 0; view.findSample(sample); sample++) {
+    if (sample != 0) {modifiedGenotypeString += '\t';}
 
     // Check that the number of fields in the genotype string matches
     // the number of fields specified in the format.  If there is
     // only one entry in the genotypes, this indicates that the
     // genotypes couldn't be determined and thus the entry is '.'.  In
     // this case, the genotypes can be left as is.
-    if (*iter == ".") {
-      modifiedGenotype = *iter;
-    } else {
-      originalGenotypes = split(*iter, ":");
-      if (originalGenotypes.size() != formats.size()) {
-        cerr << "ERROR: Number of entries in genotype string does not match the format." << endl;
-        exit(1);
-      } else {
-
-        // Loop through the entries in the genotype format string.  If
-        // the number of entries is an integer, this field does not need
-        // to be modified.  However if the number of entries is A or G,
-        // then these fields will require modification.  The GT (genotype)
-        // field will also require modification.
-        vector<string>::iterator fIter = formats.begin();
-        vector<string>::iterator gIter = originalGenotypes.begin();
-        for (; fIter != formats.end(); fIter++) {
-          if (*fIter == "GT") {
-
-            // Loop over the allele identifiers and replace them with the
-            // contents of the imported array alleleIDs.
-            success = getAlleles();
-            if (!success) {
-              cerr << "ERROR: Genotype includes both phased and unphased alleles." << endl;
-              cerr << "Validate the vcf file for further information." << endl;
-              exit(1);
-            } else {
-              connector = (phased) ? "|" : "/";
-            }
-            vector<string>::iterator gtIter = originalAlleles.begin();
-            modifiedGT = "";
-            for (; gtIter != originalAlleles.end(); gtIter++) {
-              gtInt = atoi((*gtIter).c_str());
-              ostringstream gt;
-              gt << alleleIDs[gtInt];
-              modifiedGT = (alleleIDs[gtInt] == -1) ? (modifiedGT + "." + connector) : (modifiedGT + gt.str() + connector);
-            }
-
-            // Strip off the extra '/' character.
-            modifiedGT = modifiedGT.substr(0, modifiedGT.size() - 1);
-            modifiedGenotype += modifiedGT + ":";
-
-          // Only retain the fields for the retained alleles.
-          } else if (header.formatFields[*fIter].number == "A") {
-            fields = split(*gIter, ",");
-            fieldsIter = fields.begin();
-            modifiedField = "";
-
-            // Loop through the alleleIDs array (skipping the first -
-            // reference - entry) and if the value is 0, this alterate
-            // was skipped and so the value should no be included in the
-            // new genotype string.
-            alleleIter = alleleIDs.begin();
-            alleleIter++;
-            for (; alleleIter != alleleIDs.end(); alleleIter++) {
-              if (*alleleIter != -1) {
-                modifiedField += *fieldsIter + ",";
-              }
-              fieldsIter++;
-            }
-
-            // Strip off the extra '/' character.
-            modifiedField = modifiedField.substr(0, modifiedField.size() - 1);
-            modifiedGenotype += modifiedField + ":";
+    if (view.isMissing(sample)) {
+      modifiedGenotypeString += '.';
+      continue;
+    }
+    if (view.getFields(sample, fields) != view.formats.size()) {
+      cerr << "ERROR: Number of entries in genotype string does not match the format." << endl;
+      exit(1);
+    }
 
-          } else if (header.formatFields[*fIter].number == "G") {
-            modifiedGenotype += ".:";
-          } else if (header.formatFields[*fIter].number == ".") {
-            modifiedGenotype += *gIter + ":";
-          } else {
-            modifiedGenotype += *gIter + ":";
+    // Loop through the entries in the genotype format string.  If
+    // the number of entries is an integer, this field does not need
+    // to be modified.  However if the number of entries is A or G,
+    // then these fields will require modification.  The GT (genotype)
+    // field will also require modification.
+    for (unsigned int field = 0; field < fields.size(); field++) {
+      if (field != 0) {modifiedGenotypeString += ':';}
+      if ((int) field == gtIndex) {
+
+        // Replace the allele identifiers with the contents of the
+        // imported array alleleIDs.
+        view.getAlleles(fields[field], alleles, phased, unphased);
+        if (phased && unphased) {
+          cerr << "ERROR: Genotype includes both phased and unphased alleles." << endl;
+          cerr << "Validate the vcf file for further information." << endl;
+          exit(1);
+        }
+        for (vector<int>::iterator aIter = alleles.begin(); aIter != alleles.end(); aIter++) {
+          if (aIter != alleles.begin()) {modifiedGenotypeString += (phased) ? '|' : '/';}
+          int id = (*aIter >= 0 && (unsigned int) *aIter < alleleIDs.size()) ? alleleIDs[*aIter] : -1;
+          if (id == -1) {modifiedGenotypeString += '.';}
+          else {
+            ostringstream gt;
+            gt << id;
+            modifiedGenotypeString += gt.str();
           }
-          gIter++;
         }
 
-        // Strip off the extra ':' character.
-        modifiedGenotype = modifiedGenotype.substr(0, modifiedGenotype.size() - 1);
+      // Only retain the fields for the retained alleles.  The first
+      // entry in alleleIDs is the reference allele and is skipped.  If
+      // the value of an alternate allele is -1, this alternate was removed.
+      } else if (numbers[field] == "A") {
+        string value(data + fields[field].start, fields[field].length);
+        unsigned int numberValues = splitSpans(value, ',', values, alleleIDs.size() - 1);
+        bool first = true;
+        for (unsigned int i = 1; i < alleleIDs.size() && i <= numberValues; i++) {
+          if (alleleIDs[i] == -1) {continue;}
+          if (!first) {modifiedGenotypeString += ',';}
+          modifiedGenotypeString.append(value, values[i - 1].start, values[i - 1].length);
+          first = false;
+        }
+        if (first) {modifiedGenotypeString += '.';}
+
+      } else if (numbers[field] == "G") {
+        modifiedGenotypeString += '.';
+      } else {
+        modifiedGenotypeString.append(data + fields[field].start, fields[field].length);
       }
     }
-    modifiedGenotypeString += modifiedGenotype + "\t";
   }
-  // Strip off the extra tab character.
-  modifiedGenotypeString = modifiedGenotypeString.substr(0, modifiedGenotypeString.size() - 1);
 
   // Replace the original genotype string with the modified version.
-  genotypeString = modifiedGenotypeString;
+  genotypeString.swap(modifiedGenotypeString);
 }
 
 // Parse all of the sample information and determine whether this person is
@@ -191,8 +171,8 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
       // First check if there are the correct number of entries. There should be as
       // many fields (seperated by a ":") as there are formats.
       if (genotypeFields.size() != genotypes.size()) {
-        cerr << "ERROR: Inconsistent number of fields in the genotype string for sample: " << header.samples[sampleID];
-        cerr << " at " << referenceSequence << ":" << position << "." << endl;
+        *errorStream << "ERROR: Inconsistent number of fields in the genotype string for sample: " << header.samples[sampleID];
+        *errorStream << " at " << referenceSequence << ":" << position << "." << endl;
         error = true;
       }
 
@@ -202,8 +182,8 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
       // present and not both.
       success = getAlleles();
       if (!success) {
-        cerr << "ERROR: Genotype includes both phased and unphased alleles for sample: " << header.samples[sampleID];
-        cerr << " at " << referenceSequence << ":" << position << "." << endl;
+        *errorStream << "ERROR: Genotype includes both phased and unphased alleles for sample: " << header.samples[sampleID];
+        *errorStream << " at " << referenceSequence << ":" << position << "." << endl;
         error = true;
       }
 
@@ -224,8 +204,8 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
             // First check that all the entries in the genotypes are integers or '.'.
             integerValue = atoi( (*aIter).c_str() );
             if (integerValue == 0 && *aIter != "0" && *aIter != ".") {
-              cerr << "ERROR: Invalid entry in genotype for sample: " << header.samples[sampleID] << " at ";
-              cerr << referenceSequence << ":" << position << "." << endl;
+              *errorStream << "ERROR: Invalid entry in genotype for sample: " << header.samples[sampleID] << " at ";
+              *errorStream << referenceSequence << ":" << position << "." << endl;
               error = true;
 
             // Next check that the value is not larger than the number of alternate
@@ -235,9 +215,9 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
             // range [0-3].
             } else {
               if (integerValue > noAlts) {
-                cerr << "ERROR: Genotype entry for sample: " << header.samples[sampleID] << " at ";
-                cerr << referenceSequence << ":" << position << " represents a non-existent allele (max value: ";
-                cerr << noAlts << ")." << endl;
+                *errorStream << "ERROR: Genotype entry for sample: " << header.samples[sampleID] << " at ";
+                *errorStream << referenceSequence << ":" << position << " represents a non-existent allele (max value: ";
+                *errorStream << noAlts << ")." << endl;
                 error = true;
               }
             }
@@ -250,8 +230,8 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
           // with the expected number.
           if (genoIter->second.number == "A") {
             if (values.size() != noAlts) {
-              cerr << "ERROR: Incorrect number of entries for sample " << header.samples[sampleID];
-              cerr << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
+              *errorStream << "ERROR: Incorrect number of entries for sample " << header.samples[sampleID];
+              *errorStream << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
               error = true;
             }
   
@@ -272,8 +252,8 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
             unsigned int denB      = fact(noAlts);
             unsigned int numberInG = num / (denA * denB);
             if (values.size() != numberInG) {
-              cerr << "ERROR: Incorrect number of entries for sample: " << header.samples[sampleID];
-              cerr << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
+              *errorStream << "ERROR: Incorrect number of entries for sample: " << header.samples[sampleID];
+              *errorStream << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
               error = true;
             }
 
@@ -295,15 +275,15 @@ void genotypeInfo::validateGenotypes(vcfHeader& header, string& referenceSequenc
             // First check that the number is an integer.
             integerValue = atoi( genoIter->second.number.c_str() );
             if (integerValue == 0) {
-              cerr << "ERROR: Invalid type in genotype field: " << genoIter->first << " at " << referenceSequence;
-              cerr << ":" << position << "." << endl;
+              *errorStream << "ERROR: Invalid type in genotype field: " << genoIter->first << " at " << referenceSequence;
+              *errorStream << ":" << position << "." << endl;
               error = true;
             }
       
             // Now check that the correct number is observed.
             if (values.size() != integerValue) {
-              cerr << "ERROR: Incorrect number of entries for sample " << header.samples[sampleID];
-              cerr << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
+              *errorStream << "ERROR: Incorrect number of entries for sample " << header.samples[sampleID];
+              *errorStream << " at " << referenceSequence << ":" << position << " in " << genoIter->first << " field" << endl;
               error = true;
             }
       
@@ -364,8 +344,8 @@ void genotypeInfo::checkTypes(string& referenceSequence, int& position, bool& er
     if (genoIter->second.type == "Integer") {
       integerValue = atoi( gIter->c_str() );
       if (integerValue == 0 && *gIter != "0") {
-        cerr << "ERROR: Expected integer in genotype field: " << genoIter->first << " at " << referenceSequence;
-        cerr << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected integer in genotype field: " << genoIter->first << " at " << referenceSequence;
+        *errorStream << ":" << position << "." << endl;
         error = true;
       }
 
@@ -373,16 +353,16 @@ void genotypeInfo::checkTypes(string& referenceSequence, int& position, bool& er
     } else if (genoIter->second.type == "Float") {
       floatValue = atof( gIter->c_str() );
       if (floatValue == 0. && (*gIter != "0" && *gIter != "0." && *gIter != "0.0")) {
-        cerr << "ERROR: Expected floats in genotype field: " << genoIter->first << " at " << referenceSequence;
-        cerr << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected floats in genotype field: " << genoIter->first << " at " << referenceSequence;
+        *errorStream << ":" << position << "." << endl;
         error = true;
       }
     } else if (genoIter->second.type == "Character") {
 
       // Check that the values are of length 1.
       if (gIter->length() != 1) {
-        cerr << "ERROR: Expected a single character for genotype field: " << genoIter->first << "at";
-        cerr << referenceSequence << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected a single character for genotype field: " << genoIter->first << "at";
+        *errorStream << referenceSequence << ":" << position << "." << endl;
         error = true;
       }
     } else if (genoIter->second.type == "String") {
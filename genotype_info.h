@@ -20,6 +20,7 @@
 #include <map>
 #include <vector>
 
+#include "genotype_columns.h"
 #include "header.h"
 #include "split.h"
 #include "tools.h"
@@ -47,6 +48,9 @@ class genotypeInfo {
     void validateGenotypes(vcfHeader&, string&, int&, unsigned int&, bool&);
 
   public:
+
+    // Validation errors are written to this stream (cerr by default).
+    ostream* errorStream;
     bool phased;
     bool unphased;
     unsigned int numberInGeno;
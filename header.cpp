@@ -58,6 +58,28 @@ void vcfHeader::parseHeader(istream* input) {
       exit(1);
     }
   }
+
+  // Compile the info descriptions into the table of info tags.
+  buildInfoDictionary();
+}
+
+// Add all of the info descriptions to the info dictionary and build the
+// table used to find them.
+void vcfHeader::buildInfoDictionary() {
+  infoTags = infoDictionary();
+  for (map<string, headerInfo>::iterator iter = infoFields.begin(); iter != infoFields.end(); iter++) {
+    infoTags.addTag(iter->first, iter->second.number, iter->second.type);
+  }
+  infoTags.buildTable();
+}
+
+// Add an info description that is not in the input file (for example, a
+// tag added by a tool) and rebuild the info dictionary, so that records
+// carrying the tag can be processed.
+void vcfHeader::addInfoLine(const string& infoLine) {
+  line = infoLine;
+  parseInfo(INFO);
+  buildInfoDictionary();
 }
 
 // Parse assembly information if present.
@@ -69,9 +91,23 @@ void vcfHeader::parseAssembly() {
 void vcfHeader::parseFileFormat() {
 }
 
-// Parse contig information.
+// Parse contig information.  The reference sequences are added to the
+// contig dictionary in the order in which they appear in the header.
 void vcfHeader::parseContig() {
   hasContigInfo = true;
+
+  size_t start = line.find_first_of("<");
+  size_t end   = line.find_last_of(">");
+  if (start == string::npos || end == string::npos || end < start) {return;}
+
+  string id;
+  int length = 0;
+  vector<string> fields = split(line.substr(start + 1, end - start - 1), ',');
+  for (vector<string>::iterator iter = fields.begin(); iter != fields.end(); iter++) {
+    if (iter->substr(0, 3) == "ID=") {id = iter->substr(3);}
+    else if (iter->substr(0, 7) == "length=") {length = atoi(iter->substr(7).c_str());}
+  }
+  if (id != "") {sharedContigs().addContig(id, length);}
 }
 
 // Parse information from the info and format descriptors.
@@ -110,10 +146,13 @@ void vcfHeader::parseInfo(unsigned int lineType) {
 
     // The number field can take an integer value if the number of values for this is
     // fixed.  If there is an entry per alternate, this should take the value 'A', one
-    // entry per genotype takes the value 'G' and if the number is unknown or variable
-    // then this should be '.'.
+    // entry per allele (including the reference) takes the value 'R', one entry per
+    // genotype takes the value 'G' and if the number is unknown or variable then this
+    // should be '.'.
     if (number == "A") {
       infoTag.number = "A";
+    } else if (number == "R") {
+      infoTag.number = "R";
     } else if (number == "G") {
       infoTag.number = "G";
     } else if (number == ".") {
@@ -18,8 +18,11 @@
 #include <string>
 #include <stdlib.h>
 #include <map>
+#include <set>
 #include <vector>
 
+#include "contig_dictionary.h"
+#include "info_dictionary.h"
 #include "split.h"
 
 using namespace std;
@@ -39,6 +42,8 @@ class vcfHeader {
   public:
     vcfHeader(void);
     ~vcfHeader(void);
+    void addInfoLine(const string&);
+    void buildInfoDictionary();
     void parseAdditionalInfo();
     void parseAssembly();
     void parseContig();
@@ -66,6 +71,8 @@ class vcfHeader {
     map<string, headerInfo> altFields;
     map<string, string> infoLine;
     map<string, headerInfo> infoFields;
+    infoDictionary infoTags;
+    set<string> unknownInfoTags;
     map<string, string> filterLine;
     map<string, headerInfo> filterFields;
     map<string, string> formatLine;
@@ -15,82 +15,66 @@ using namespace vcfCTools;
 
 // Constructor
 variantInfo::variantInfo(string& info) {
-  infoString = info;
+  errorStream = &cerr;
+  infoString  = info;
 };
 
 // Destructor.
 variantInfo::~variantInfo(void) {};
 
 // If alleles have been removed, modify the info field so that all
-// fields have the correct number of entries.
+// fields have the correct number of entries.  Fields with a value per
+// allele (Number=A or R) keep only the values of the remaining alleles,
+// and all other fields are copied as they are.
 void variantInfo::modifyInfo(vector<int>& alleleIDs, vcfHeader& header) {
-  string modifiedInfo = "";
+  string modifiedInfo;
 
   retrieveFields(header, true);
-
-  // Loop through each of the info fields and check for any fields that should
-  // contain values corresponding to the different alternate alleles.
-  infoIter = infoFields.begin();
-  for (; infoIter != infoFields.end(); infoIter++) {
-    if (infoIter->second.number == "A") {
-      vector<string>::iterator vIter   = infoIter->second.values.begin();
-      vector<int>::iterator alleleIter = alleleIDs.begin();
-
-      // Skip the reference allele in the alleleIDs.
-      alleleIter++;
-
-      modifiedInfo += infoIter->first + "=";
-      for (; alleleIter != alleleIDs.end(); alleleIter++) {
-        if (*alleleIter != -1) {modifiedInfo += *vIter + ",";}
-        vIter++;
+  for (vector<infoEntry>::iterator iter = fields.begin(); iter != fields.end(); iter++) {
+    if (iter != fields.begin()) {modifiedInfo += ';';}
+    modifiedInfo.append(infoString, iter->tag.start, iter->tag.length);
+    if (!iter->hasValue) {continue;}
+    modifiedInfo += '=';
+
+    infoNumber numberType = header.infoTags.tags[iter->id].numberType;
+    if (numberType == INFO_NUMBER_ALLELES || numberType == INFO_NUMBER_REFERENCE_ALLELES) {
+      const char* start = infoString.data() + iter->value.start;
+      const char* end   = start + iter->value.length;
+      bool firstValue   = true;
+
+      // Skip the reference allele in the alleleIDs unless the field has a
+      // value for it.
+      unsigned int firstAllele = (numberType == INFO_NUMBER_ALLELES) ? 1 : 0;
+      for (unsigned int allele = firstAllele; allele < alleleIDs.size() && start <= end; allele++) {
+        const char* comma = (const char*) memchr(start, ',', end - start);
+        if (comma == NULL) {comma = end;}
+        if (alleleIDs[allele] != -1) {
+          if (!firstValue) {modifiedInfo += ',';}
+          modifiedInfo.append(start, comma - start);
+          firstValue = false;
+        }
+        start = comma + 1;
       }
-
-      // Strip the trailing ",".
-      modifiedInfo = modifiedInfo.substr(0, modifiedInfo.size() - 1);
-      modifiedInfo += ";";
-    } else if (infoIter->second.number == "0") {
-      modifiedInfo += infoIter->first + ";";
     } else {
-      modifiedInfo += infoIter->first + "=" + infoIter->second.values[0] + ";";
+      modifiedInfo.append(infoString, iter->value.start, iter->value.length);
     }
   }
 
-  // Strip the trailing ";" and then replace the existing info string
-  // with the modified one.
-  modifiedInfo = modifiedInfo.substr(0, modifiedInfo.size() - 1);
-  infoString   = modifiedInfo;
+  // Replace the existing info string with the modified one.
+  infoString.swap(modifiedInfo);
 }
 
-// Split the info string into its components and populate the arrays
-// to store the information.
+// Split the info string into its fields and find the tag of each in the
+// header.  If a tag has no header description, a warning is given (once for
+// each tag) and the program terminates if requested.
 void variantInfo::retrieveFields(vcfHeader& header, bool terminate) {
-  string tag;
-  vector<string> infoArray = split(infoString, ";");
-  vector<string>::iterator infoIter = infoArray.begin();
-  for (; infoIter != infoArray.end(); infoIter++) {
-
-    // Split the entry on "=" to get the tag.
-    vector<string> fields = split(*infoIter, "=");
-    infoStruct info;
-    tag = fields[0];
-
-    // In order to process the info field, the header information is
-    // required.  If this does not exist, terminate the program.
-    if (header.infoFields.count(tag) == 0) {
-      cerr << "WARNING: No header description for info tag: " << tag << endl;
+  header.infoTags.decode(infoString, fields);
+  for (vector<infoEntry>::iterator iter = fields.begin(); iter != fields.end(); iter++) {
+    if (iter->id == NO_INFO_TAG) {
+      string tag = infoString.substr(iter->tag.start, iter->tag.length);
+      if (header.unknownInfoTags.insert(tag).second) {cerr << "WARNING: No header description for info tag: " << tag << endl;}
       if (terminate) {exit(1);}
     }
-
-    info.number = header.infoFields[tag].number;
-    info.type   = header.infoFields[tag].type;
-    if (fields.size() > 1) {
-      info.values        = split(fields[1], ",");
-      info.numberValues  = info.values.size();
-    } else {
-      info.values.push_back("");
-      info.numberValues = 0;
-    }
-    infoFields[tag] = info;
   }
 }
 
@@ -98,108 +82,120 @@ void variantInfo::retrieveFields(vcfHeader& header, bool terminate) {
 // explanation in the header and that the number and entry types are
 // consistent with this header information.
 void variantInfo::validateInfo(vcfHeader& header, string& referenceSequence, int& position, unsigned int& noAlts, bool& error) {
-  int integerValue;
 
   // Split the info field into its constituent parts.
   retrieveFields(header, false);
-  for (infoIter = infoFields.begin(); infoIter != infoFields.end(); infoIter++) {
+  for (vector<infoEntry>::iterator iter = fields.begin(); iter != fields.end(); iter++) {
+    string tag                = infoString.substr(iter->tag.start, iter->tag.length);
+    unsigned int numberValues = infoDictionary::countValues(*iter, infoString);
+
+    // Tags without a header description have no valid number of entries.
+    if (iter->id == NO_INFO_TAG) {
+      *errorStream << "ERROR: Invalid type in info field: " << tag << " at " << referenceSequence;
+      *errorStream << ":" << position << "." << endl;
+      error = true;
+      if (numberValues != 0) {
+        *errorStream << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
+        *errorStream << position << ", in info field for: " << tag << endl;
+      }
+      continue;
+    }
+    const infoTag& description = header.infoTags.tags[iter->id];
 
     // If the info number = A, there should be as many values as there are
     // alternate alleles.  Check that this is the case.
-    if (infoIter->second.number == "A") {
-      if (infoIter->second.numberValues != noAlts) {
-        cerr << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
-        cerr << position << ", in info field for: " << infoIter->first << endl;
+    if (description.numberType == INFO_NUMBER_ALLELES) {
+      if (numberValues != noAlts) {
+        *errorStream << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
+        *errorStream << position << ", in info field for: " << tag << endl;
         error = true;
       }
 
       // Check the values conform to the expected types.
-      checkTypes(referenceSequence, position, error);
+      checkTypes(*iter, description, referenceSequence, position, error);
 
-    } else if (infoIter->second.number == "G") {
+    // Number = R fields have a value for the reference allele as well.
+    } else if (description.numberType == INFO_NUMBER_REFERENCE_ALLELES) {
+      if (numberValues != noAlts + 1) {
+        *errorStream << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
+        *errorStream << position << ", in info field for: " << tag << endl;
+        error = true;
+      }
+      checkTypes(*iter, description, referenceSequence, position, error);
+
+    } else if (description.numberType == INFO_NUMBER_GENOTYPES) {
 
     // If the info number = '.', any number of entries is acceptable, so do not
     // check the number of values.
-    } else if (infoIter->second.number == ".") {
+    } else if (description.numberType == INFO_NUMBER_VARIABLE) {
 
       // Check the values conform to the expected types.
-      checkTypes(referenceSequence, position, error);
+      checkTypes(*iter, description, referenceSequence, position, error);
 
     // If the info number = 0, then this info field is a flag.  Check that there is
     // only a single entry.
-    } else if (infoIter->second.number == "0") {
-      if (infoIter->second.numberValues != 0 || infoIter->second.type != "Flag") {
-        cerr << "ERROR: Incorrect number of entries or not marked as a flag at " << referenceSequence << ":";
-        cerr << position << ", in info field for: " << infoIter->first << "." << endl;
+    } else if (description.number == 0) {
+      if (numberValues != 0 || description.type != INFO_TYPE_FLAG) {
+        *errorStream << "ERROR: Incorrect number of entries or not marked as a flag at " << referenceSequence << ":";
+        *errorStream << position << ", in info field for: " << tag << "." << endl;
         error = true;
       }
 
       // Check the values conform to the expected types.
-      checkTypes(referenceSequence, position, error);
+      checkTypes(*iter, description, referenceSequence, position, error);
 
     // Finally, if a specified number of entries is given, check that this number
-    // is observed.  Also check that the entry is itself an integer as there are no
-    // other allowed types.
+    // is observed.
     } else {
-
-      // First check that the number is an integer.
-      integerValue = atoi( infoIter->second.number.c_str() );
-      if (integerValue == 0) {
-        cerr << "ERROR: Invalid type in info field: " << infoIter->first << " at " << referenceSequence;
-        cerr << ":" << position << "." << endl;
-        error = true;
-      }
-
-      // Now check that the correct number is observed.
-      if (infoIter->second.numberValues != integerValue) {
-        cerr << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
-        cerr << position << ", in info field for: " << infoIter->first << endl;
+      if (numberValues != description.number) {
+        *errorStream << "ERROR: Incorrect number of entries at " << referenceSequence << ":";
+        *errorStream << position << ", in info field for: " << tag << endl;
         error = true;
       }
 
       // Check the values conform to the expected types.
-      checkTypes(referenceSequence, position, error);
+      checkTypes(*iter, description, referenceSequence, position, error);
     }
   }
 }
 
-// Check that the observed values conform to the expected type.
-void variantInfo::checkTypes(string& referenceSequence, int& position, bool& error) {
-  int integerValue;
-  float floatValue;
-  vector<string>::iterator sIter;
+// Check that the observed values conform to the expected type.  A field
+// without a value (or with an empty value) is checked as a single empty
+// value.
+void variantInfo::checkTypes(infoEntry& field, const infoTag& description, string& referenceSequence, int& position, bool& error) {
+  string tag = infoString.substr(field.tag.start, field.tag.length);
+  vector<string> values;
+  if (field.value.length == 0) {values.push_back("");}
+  else {split(infoString.substr(field.value.start, field.value.length), ',', values);}
 
   // Now check that the values are of the correct type.
-  sIter = infoIter->second.values.begin();
-  for (; sIter != infoIter->second.values.end(); sIter++) {
+  for (vector<string>::iterator sIter = values.begin(); sIter != values.end(); sIter++) {
 
     // Check that integers appear if integers are expected.
-    if (infoIter->second.type == "Integer") {
-      integerValue = atoi( sIter->c_str() );
+    if (description.type == INFO_TYPE_INTEGER) {
+      int integerValue = atoi( sIter->c_str() );
       if (integerValue == 0 && *sIter != "0") {
-        cerr << "ERROR: Expected integer in info field: " << infoIter->first << " at " << referenceSequence;
-        cerr << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected integer in info field: " << tag << " at " << referenceSequence;
+        *errorStream << ":" << position << "." << endl;
         error = true;
       }
 
     // If floating point values are expected, check that this is seen.
-    } else if (infoIter->second.type == "Float") {
-      floatValue = atof( sIter->c_str() );
+    } else if (description.type == INFO_TYPE_FLOAT) {
+      float floatValue = atof( sIter->c_str() );
       if (floatValue == 0. && (*sIter != "0" && *sIter != "0." && *sIter != "0.0")) {
-        cerr << "ERROR: Expected floats in info field: " << infoIter->first << " at " << referenceSequence;
-        cerr << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected floats in info field: " << tag << " at " << referenceSequence;
+        *errorStream << ":" << position << "." << endl;
         error = true;
       }
-    } else if (infoIter->second.type == "Flag") {
-    } else if (infoIter->second.type == "Character") {
+    } else if (description.type == INFO_TYPE_CHARACTER) {
 
       // Check that the values are of length 1.
       if (sIter->length() != 1) {
-        cerr << "ERROR: Expected a single character for info field: " << infoIter->first << "at";
-        cerr << referenceSequence << ":" << position << "." << endl;
+        *errorStream << "ERROR: Expected a single character for info field: " << tag << "at";
+        *errorStream << referenceSequence << ":" << position << "." << endl;
         error = true;
       }
-    } else if (infoIter->second.type == "String") {
     }
   }
 }
@@ -17,10 +17,10 @@
 #include <fstream>
 #include <string>
 #include <stdlib.h>
-#include <map>
 #include <vector>
 
 #include "header.h"
+#include "info_dictionary.h"
 #include "split.h"
 #include "vcf.h"
 
@@ -28,26 +28,24 @@ using namespace std;
 
 namespace vcfCTools {
 
-struct infoStruct {
-  string number;
-  string type;
-  vector<string> values;
-  unsigned int numberValues;
-};
-
 class variantInfo {
   public:
     variantInfo(string&);
     ~variantInfo(void);
-    void checkTypes(string&, int&, bool&);
+    void checkTypes(infoEntry&, const infoTag&, string&, int&, bool&);
     void modifyInfo(vector<int>&, vcfHeader&);
     void retrieveFields(vcfHeader&, bool);
     void validateInfo(vcfHeader&, string&, int&, unsigned int&, bool&);
 
   public:
+
+    // Validation errors are written to this stream (cerr by default).
+    ostream* errorStream;
     string infoString;
-    map<string, infoStruct> infoFields;
-    map<string, infoStruct>::iterator infoIter;
+
+    // The fields of the info string in the order they appear, with the IDs
+    // of their tags in the header info dictionary.
+    vector<infoEntry> fields;
 };
 
 } // namespace vcfCTools
@@ -0,0 +1,285 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Compile the info descriptions in the header into a
+// table of tags with integer IDs.
+// ******************************************************
+
+#include "info_dictionary.h"
+
+#include <cctype>
+#include <limits>
+#include <string.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Constructor.
+infoDictionary::infoDictionary(void) {
+  mask = 0;
+  seed = 0;
+}
+
+// Destructor.
+infoDictionary::~infoDictionary(void) {}
+
+// Add a tag with the number and type strings from its header description,
+// returning the ID of the tag.  The table must be rebuilt before the tag
+// can be found.
+unsigned int infoDictionary::addTag(const string& name, const string& number, const string& type) {
+  infoTag tag;
+  tag.name   = name;
+  tag.number = 0;
+  if (number == "A") {tag.numberType = INFO_NUMBER_ALLELES;}
+  else if (number == "R") {tag.numberType = INFO_NUMBER_REFERENCE_ALLELES;}
+  else if (number == "G") {tag.numberType = INFO_NUMBER_GENOTYPES;}
+  else if (number.size() != 0 && isdigit(number[0])) {
+    tag.numberType = INFO_NUMBER_FIXED;
+    tag.number     = atoi(number.c_str());
+  } else {
+    tag.numberType = INFO_NUMBER_VARIABLE;
+  }
+
+  if (type == "Integer") {tag.type = INFO_TYPE_INTEGER;}
+  else if (type == "Float") {tag.type = INFO_TYPE_FLOAT;}
+  else if (type == "Flag") {tag.type = INFO_TYPE_FLAG;}
+  else if (type == "Character") {tag.type = INFO_TYPE_CHARACTER;}
+  else if (type == "String") {tag.type = INFO_TYPE_STRING;}
+  else {tag.type = INFO_TYPE_UNKNOWN;}
+  tags.push_back(tag);
+
+  return tags.size() - 1;
+}
+
+// Hash a tag (FNV-1a, starting from the seed).
+uint32_t infoDictionary::hash(const char* name, size_t length) const {
+  uint32_t value = 2166136261u ^ (seed * 0x9e3779b9u);
+  for (size_t i = 0; i < length; i++) {
+    value ^= (unsigned char) name[i];
+    value *= 16777619u;
+  }
+  value ^= value >> 15;
+
+  return value & mask;
+}
+
+// Find a seed that puts every tag in a different slot.  The table has at
+// least twice as many slots as there are tags, and is doubled if no seed
+// is found after a few attempts.
+void infoDictionary::buildTable() {
+  size_t size = 8;
+  while (size < 2 * tags.size()) {size *= 2;}
+
+  for (unsigned int attempt = 0; ; attempt++) {
+    if (attempt != 0 && attempt % 32 == 0) {size *= 2;}
+    mask = size - 1;
+    seed = attempt;
+    table.assign(size, NO_INFO_TAG);
+
+    bool collision = false;
+    for (unsigned int id = 0; id < tags.size() && !collision; id++) {
+      uint32_t slot = hash(tags[id].name.data(), tags[id].name.size());
+      if (table[slot] != NO_INFO_TAG) {collision = true;}
+      else {table[slot] = id;}
+    }
+    if (!collision) {break;}
+  }
+}
+
+// Find the ID of a tag, or NO_INFO_TAG if the tag has no description.
+unsigned int infoDictionary::getID(const char* name, size_t length) const {
+  if (table.size() == 0) {return NO_INFO_TAG;}
+
+  unsigned int id = table[hash(name, length)];
+  if (id == NO_INFO_TAG) {return NO_INFO_TAG;}
+  const string& tag = tags[id].name;
+
+  return (tag.size() == length && memcmp(tag.data(), name, length) == 0) ? id : NO_INFO_TAG;
+}
+
+unsigned int infoDictionary::getID(const string& name) const {
+  return getID(name.data(), name.size());
+}
+
+// Split an info string into its fields without copying them.  Each field
+// is given the ID of its tag.  An info string of "." has no fields.  The
+// number of fields is returned.
+unsigned int infoDictionary::decode(const string& info, vector<infoEntry>& entries) const {
+  entries.clear();
+  if (info == ".") {return 0;}
+
+  const char* begin = info.data();
+  const char* end   = begin + info.size();
+  const char* start = begin;
+  while (start < end) {
+    const char* stop = (const char*) memchr(start, ';', end - start);
+    if (stop == NULL) {stop = end;}
+
+    // Empty fields (e.g. from ";;") are skipped.
+    if (stop != start) {
+      const char* equals = (const char*) memchr(start, '=', stop - start);
+      infoEntry entry;
+      entry.tag.start  = start - begin;
+      entry.tag.length = ((equals == NULL) ? stop : equals) - start;
+      entry.hasValue   = (equals != NULL);
+      entry.value.start  = (equals == NULL) ? stop - begin : equals + 1 - begin;
+      entry.value.length = (equals == NULL) ? 0 : stop - equals - 1;
+      entry.id = getID(start, entry.tag.length);
+      entries.push_back(entry);
+    }
+    start = stop + 1;
+  }
+
+  return entries.size();
+}
+
+// Count the comma separated values of a field.  Fields without a value
+// (flags) have no values.
+unsigned int infoDictionary::countValues(const infoEntry& entry, const string& info) {
+  if (entry.value.length == 0) {return 0;}
+
+  const char* start = info.data() + entry.value.start;
+  const char* end   = start + entry.value.length;
+  unsigned int count = 1;
+  while ((start = (const char*) memchr(start, ',', end - start)) != NULL) {
+    start++;
+    count++;
+  }
+
+  return count;
+}
+
+// Constructor.
+infoValues::infoValues(void) {
+  dictionary = NULL;
+  record     = 0;
+}
+
+// Destructor.
+infoValues::~infoValues(void) {}
+
+// Only keep the fields of the selected tags when decoding records.
+void infoValues::selectTag(unsigned int id) {
+  if (selectedTags.size() <= id) {selectedTags.resize(id + 1, false);}
+  selectedTags[id] = true;
+}
+
+// Split the info string of a record into its fields and convert the
+// values of every Integer and Float field.  The expected number of values
+// of each field is resolved for a record with the given number of
+// alternate alleles (genotypes are assumed to be diploid).
+void infoValues::decode(const infoDictionary& tags, const string& info, unsigned int numberAlts) {
+  dictionary = &tags;
+  if (tagValues.size() != tags.tags.size()) {tagValues.assign(tags.tags.size(), infoFieldValues());}
+
+  // Start a new record.  If the record number wraps around, fields from an
+  // old record could appear to belong to this one, so they are cleared.
+  if (++record == 0) {
+    for (vector<infoFieldValues>::iterator iter = tagValues.begin(); iter != tagValues.end(); iter++) {iter->record = 0;}
+    record = 1;
+  }
+  integers.clear();
+  floats.clear();
+
+  tags.decode(info, fields);
+  for (unsigned int entry = 0; entry < fields.size(); entry++) {
+    const infoEntry& field = fields[entry];
+    if (field.id == NO_INFO_TAG) {continue;}
+    if (!selectedTags.empty() && (field.id >= selectedTags.size() || !selectedTags[field.id])) {continue;}
+
+    const infoTag& tag      = tags.tags[field.id];
+    infoFieldValues& values = tagValues[field.id];
+    values.record = record;
+    values.entry  = entry;
+    values.offset = 0;
+    values.count  = infoDictionary::countValues(field, info);
+
+    switch (tag.numberType) {
+      case INFO_NUMBER_ALLELES:
+        values.expected = numberAlts;
+        break;
+      case INFO_NUMBER_REFERENCE_ALLELES:
+        values.expected = numberAlts + 1;
+        break;
+      case INFO_NUMBER_GENOTYPES:
+        values.expected = (numberAlts + 1) * (numberAlts + 2) / 2;
+        break;
+      case INFO_NUMBER_VARIABLE:
+        values.expected = values.count;
+        break;
+      default:
+        values.expected = tag.number;
+        break;
+    }
+
+    if (tag.type != INFO_TYPE_INTEGER && tag.type != INFO_TYPE_FLOAT) {continue;}
+    values.offset = (tag.type == INFO_TYPE_INTEGER) ? integers.size() : floats.size();
+
+    // strtol and strtod stop at the comma (or the ';' following the field),
+    // so the values are converted in place.  A value that does not convert
+    // completely is treated as missing.
+    const char* start = info.c_str() + field.value.start;
+    const char* end   = start + field.value.length;
+    for (unsigned int i = 0; i < values.count; i++) {
+      const char* comma = (const char*) memchr(start, ',', end - start);
+      if (comma == NULL) {comma = end;}
+      char* stop;
+      if (tag.type == INFO_TYPE_INTEGER) {
+        long value = strtol(start, &stop, 10);
+        integers.push_back((stop == comma && stop != start) ? (int) value : MISSING_INFO_INTEGER);
+      } else {
+        double value = strtod(start, &stop);
+        floats.push_back((stop == comma && stop != start) ? value : numeric_limits<double>::quiet_NaN());
+      }
+      start = comma + 1;
+    }
+  }
+}
+
+// Check if the current record has a field for the tag.
+bool infoValues::hasTag(unsigned int id) const {
+  return id < tagValues.size() && tagValues[id].record == record;
+}
+
+// The number of values observed for a tag in the current record.
+unsigned int infoValues::numberValues(unsigned int id) const {
+  return hasTag(id) ? tagValues[id].count : 0;
+}
+
+// The number of values the header describes for a tag in the current
+// record.
+unsigned int infoValues::expectedValues(unsigned int id) const {
+  return hasTag(id) ? tagValues[id].expected : 0;
+}
+
+// Get a value of an Integer field.  Returns false if the record has no
+// such value or the value is missing.
+bool infoValues::getInteger(unsigned int id, unsigned int index, int& value) const {
+  if (!hasTag(id) || index >= tagValues[id].count) {return false;}
+  if (dictionary->tags[id].type != INFO_TYPE_INTEGER) {return false;}
+  value = integers[tagValues[id].offset + index];
+
+  return value != MISSING_INFO_INTEGER;
+}
+
+// Get a value of an Integer or Float field as a floating point value.
+// Returns false if the record has no such value or the value is missing.
+bool infoValues::getFloat(unsigned int id, unsigned int index, double& value) const {
+  if (!hasTag(id) || index >= tagValues[id].count) {return false;}
+
+  const infoFieldValues& values = tagValues[id];
+  if (dictionary->tags[id].type == INFO_TYPE_INTEGER) {
+    int integer = integers[values.offset + index];
+    value = integer;
+    return integer != MISSING_INFO_INTEGER;
+  } else if (dictionary->tags[id].type == INFO_TYPE_FLOAT) {
+    value = floats[values.offset + index];
+    return value == value;
+  }
+
+  return false;
+}
@@ -0,0 +1,140 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Compile the info descriptions in the header into a
+// table of tags with integer IDs.
+// ******************************************************
+
+#ifndef INFO_DICTIONARY_H
+#define INFO_DICTIONARY_H
+
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "split.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The ID of a tag with no header description.
+#define NO_INFO_TAG 0xffffffff
+
+// The value given to missing ('.') or malformed integer values.  Missing
+// floating point values are NaN.
+#define MISSING_INFO_INTEGER INT_MIN
+
+// The number of values expected for an info field: a fixed number (zero
+// for flags), one per alternate allele (A), one per allele including the
+// reference (R), one per genotype (G) or any number (.).
+enum infoNumber {
+  INFO_NUMBER_FIXED,
+  INFO_NUMBER_ALLELES,
+  INFO_NUMBER_REFERENCE_ALLELES,
+  INFO_NUMBER_GENOTYPES,
+  INFO_NUMBER_VARIABLE
+};
+
+// The type of the values of an info field.
+enum infoType {
+  INFO_TYPE_INTEGER,
+  INFO_TYPE_FLOAT,
+  INFO_TYPE_FLAG,
+  INFO_TYPE_CHARACTER,
+  INFO_TYPE_STRING,
+  INFO_TYPE_UNKNOWN
+};
+
+// The header description of an info tag.
+struct infoTag {
+  string name;
+  infoNumber numberType;
+  unsigned int number;
+  infoType type;
+};
+
+// An info field in a record.  The spans refer to the info string of the
+// record.  The value is the text after the '=' (if there is one).
+struct infoEntry {
+  unsigned int id;
+  stringSpan tag;
+  stringSpan value;
+  bool hasValue;
+};
+
+// The info tags described in the header, numbered in alphabetical order of
+// the tag names (the order of the info fields map in the header).  Tags are
+// found with a perfect hash: the seed of the hash is chosen when the table
+// is built so that no two tags share a slot, so a lookup is a single hash
+// and one comparison of the tag.
+class infoDictionary {
+  public:
+    infoDictionary(void);
+    ~infoDictionary(void);
+    unsigned int addTag(const string&, const string&, const string&);
+    void buildTable();
+    unsigned int getID(const char*, size_t) const;
+    unsigned int getID(const string&) const;
+    unsigned int decode(const string&, vector<infoEntry>&) const;
+    static unsigned int countValues(const infoEntry&, const string&);
+
+  public:
+    uint32_t hash(const char*, size_t) const;
+
+  public:
+    vector<infoTag> tags;
+    vector<unsigned int> table;
+    uint32_t mask;
+    uint32_t seed;
+};
+
+// The numeric values of an info field in a record.  The values are held
+// in the integer or float array of the record (depending on the type of
+// the tag) starting at the offset.  The expected number of values is
+// resolved from the header number and the number of alternate alleles.
+struct infoFieldValues {
+  unsigned int record;
+  unsigned int entry;
+  unsigned int offset;
+  unsigned int count;
+  unsigned int expected;
+};
+
+// The info fields of a record with the values of all Integer and Float
+// tags converted to numbers.  The fields are indexed by tag ID, so a
+// value is found without searching the info string or converting text.
+// The arrays are reused for every record; a field belongs to the current
+// record if its record number matches.  If tags have been selected, only
+// the fields of the selected tags are kept.
+class infoValues {
+  public:
+    infoValues(void);
+    ~infoValues(void);
+    void selectTag(unsigned int);
+    void decode(const infoDictionary&, const string&, unsigned int);
+    bool hasTag(unsigned int) const;
+    unsigned int numberValues(unsigned int) const;
+    unsigned int expectedValues(unsigned int) const;
+    bool getInteger(unsigned int, unsigned int, int&) const;
+    bool getFloat(unsigned int, unsigned int, double&) const;
+
+  public:
+    const infoDictionary* dictionary;
+    unsigned int record;
+    vector<infoEntry> fields;
+    vector<infoFieldValues> tagValues;
+    vector<bool> selectedTags;
+    vector<int> integers;
+    vector<double> floats;
+};
+
+} // namespace vcfCTools
+
+#endif // INFO_DICTIONARY_H
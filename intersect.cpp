@@ -15,7 +15,13 @@ using namespace std;
 using namespace vcfCTools;
 
 // Constructor.
-intersect::intersect(void) {}
+intersect::intersect(void) {
+  currentReferenceSequenceID = NO_CONTIG;
+  minimumFiles               = 1;
+  exactMembership            = false;
+  membership                 = 0;
+  addSources                 = false;
+}
 
 // Destructor.
 intersect::~intersect(void) {}
@@ -60,8 +66,9 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
 
     // If the two variant structures are built with the same reference sequence, compare
     // the contents and parse through all varians for this reference sequence.
-    if (var1.vmIter->second.referenceSequence == var2.vmIter->second.referenceSequence) {
-      string currentReferenceSequence = var1.vmIter->second.referenceSequence;
+    if (var1.vmIter->second.referenceSequenceID == var2.vmIter->second.referenceSequenceID) {
+      unsigned int currentReferenceSequenceID = var1.vmIter->second.referenceSequenceID;
+      string currentReferenceSequence         = sharedContigs().getName(currentReferenceSequenceID);
 
       // Since there are records from both vcf files containing this reference
       // sequence, set the reference sequence information variable, usedInComparison
@@ -80,14 +87,14 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
           // Clear the compared variants from the structure and add the next one from 
           // the file into the structure if it is from the same reference sequence.
           var1.variantMap.erase(var1.vmIter);
-          if (v1.variantRecord.referenceSequence == currentReferenceSequence && v1.success) {
+          if (v1.variantRecord.referenceSequenceID == currentReferenceSequenceID && v1.success) {
             var1.addVariantToStructure(v1.position, v1.variantRecord);
             v1.success = v1.getRecord();
           }
           if (var1.variantMap.size() != 0) {var1.vmIter = var1.variantMap.begin();}
 
           var2.variantMap.erase(var2.vmIter);
-          if (v2.variantRecord.referenceSequence == currentReferenceSequence && v2.success) {
+          if (v2.variantRecord.referenceSequenceID == currentReferenceSequenceID && v2.success) {
             var2.addVariantToStructure(v2.position, v2.variantRecord);
             v2.success = v2.getRecord();
           }
@@ -99,7 +106,7 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
         } else if (var1.vmIter->first > var2.vmIter->first) {
           if (flags.findCommon) {var2.filterUnique();}
           var2.variantMap.erase(var2.vmIter);
-          if (v2.variantRecord.referenceSequence == currentReferenceSequence && v2.success) {
+          if (v2.variantRecord.referenceSequenceID == currentReferenceSequenceID && v2.success) {
             var2.addVariantToStructure(v2.position, v2.variantRecord);
             v2.success = v2.getRecord();
           }
@@ -121,7 +128,7 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
 
             // Then clear the remaining variants from the first file.
             if (var1.originalVariantsMap.size() != 0) {
-              var1.clearReferenceSequence(header1, v1, flags, currentReferenceSequence, ofile, flags.writeFromFirst);
+              var1.clearReferenceSequence(header1, v1, flags, currentReferenceSequenceID, ofile, flags.writeFromFirst);
             }
           }
           
@@ -130,7 +137,7 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
         } else if (var1.vmIter->first < var2.vmIter->first) {
           if (flags.findCommon && !flags.annotate) {var1.filterUnique();}
           var1.variantMap.erase(var1.vmIter);
-          if (v1.variantRecord.referenceSequence == currentReferenceSequence && v1.success) {
+          if (v1.variantRecord.referenceSequenceID == currentReferenceSequenceID && v1.success) {
             var1.addVariantToStructure(v1.position, v1.variantRecord);
             v1.success = v1.getRecord();
           }
@@ -152,7 +159,7 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
             // Then clear the remaining variants from the second file.
             if (var2.originalVariantsMap.size() != 0) {
               write = (flags.annotate) ? false : !flags.writeFromFirst;
-              var2.clearReferenceSequence(header2, v2, flags, currentReferenceSequence, ofile, write);
+              var2.clearReferenceSequence(header2, v2, flags, currentReferenceSequenceID, ofile, write);
             }
           }
         }
@@ -194,11 +201,11 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
       // Check that the two variant structures are empty and if not, finish processing the
       // remaining variants for this reference sequence.
       if (var1.originalVariantsMap.size() != 0) {
-        var1.clearReferenceSequence(header1, v1, flags, currentReferenceSequence, ofile, flags.writeFromFirst);
+        var1.clearReferenceSequence(header1, v1, flags, currentReferenceSequenceID, ofile, flags.writeFromFirst);
       }
       if (var2.originalVariantsMap.size() != 0) {
         write = (flags.annotate) ? false : !flags.writeFromFirst;
-        var2.clearReferenceSequence(header2, v2, flags, currentReferenceSequence, ofile, write);
+        var2.clearReferenceSequence(header2, v2, flags, currentReferenceSequenceID, ofile, write);
       }
 
       // Now both variant maps are exhausted, so rebuild the maps with the variants from the
@@ -217,7 +224,7 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
     } else {
       if (var2.variantMap.size() != 0) {
         write = (flags.annotate) ? false : !flags.writeFromFirst;
-        var2.clearReferenceSequence(header2, v2, flags, var2.vmIter->second.referenceSequence, ofile, write);
+        var2.clearReferenceSequence(header2, v2, flags, var2.vmIter->second.referenceSequenceID, ofile, write);
       }
       var2.buildVariantStructure(v2);
       if (var2.variantMap.size() != 0) {var2.vmIter = var2.variantMap.begin();}
@@ -233,49 +240,237 @@ void intersect::intersectVcf(vcfHeader& header1, vcfHeader& header2, vcf& v1, va
   ofile.flushOutputBuffer();
 }
 
-// Intersect a vcf file and a bed file.  It is assumed that the 
-// two files are sorted by genomic coordinates and the reference
-// sequences are in the same order.  Do not group together variants
-// in common reference sequence.
+// Intersect any number of vcf files in a single pass.  All of the files are
+// swept together, one reference sequence at a time.  At each locus, the
+// alleles in all of the files at that locus are compared and the files
+// containing each allele are recorded.  Each kept allele is written out from
+// the first file in which it appears, so alleles shared by many files are
+// only written once.  As for the intersection of two files, the files must
+// be sorted and have the reference sequences in the same order.
+void intersect::intersectVcfFiles(vector<vcfHeader*>& headers, vector<vcf*>& files, vector<variant*>& variants, output& ofile) {
+  unsigned int numberFiles = files.size();
+  vector<unsigned int> filesAtLocus;
+
+  for (unsigned int file = 0; file < numberFiles; file++) {files[file]->success = files[file]->getRecord();}
+
+  while (true) {
+
+    // Build the variant structures for the next reference sequence in any of
+    // the files that have finished the previous one.
+    for (unsigned int file = 0; file < numberFiles; file++) {
+      if (variants[file]->originalVariantsMap.size() == 0 && files[file]->success) {
+        files[file]->success = variants[file]->buildVariantStructure(*files[file]);
+      }
+    }
+
+    // Process the earliest reference sequence among all of the files.  Files
+    // whose structures hold a later reference sequence wait until it is
+    // reached.
+    currentReferenceSequenceID = NO_CONTIG;
+    for (unsigned int file = 0; file < numberFiles; file++) {
+      if (variants[file]->originalVariantsMap.size() != 0) {
+        unsigned int referenceSequenceID = variants[file]->originalVariantsMap.begin()->second.begin()->referenceSequenceID;
+        if (referenceSequenceID < currentReferenceSequenceID) {currentReferenceSequenceID = referenceSequenceID;}
+      }
+    }
+    if (currentReferenceSequenceID == NO_CONTIG) {break;}
+
+    vector<bool> onReferenceSequence(numberFiles, false);
+    for (unsigned int file = 0; file < numberFiles; file++) {
+      variant& var = *variants[file];
+      if (var.originalVariantsMap.size() != 0 && var.originalVariantsMap.begin()->second.begin()->referenceSequenceID == currentReferenceSequenceID) {
+        onReferenceSequence[file] = true;
+        var.referenceSequenceInfo[sharedContigs().getName(currentReferenceSequenceID)].usedInComparison = true;
+      }
+    }
+
+    // Sweep along the reference sequence, comparing the variants at the
+    // smallest position in any of the files.
+    while (true) {
+      bool foundLocus = false;
+      int position    = 0;
+      for (unsigned int file = 0; file < numberFiles; file++) {
+        if (onReferenceSequence[file] && variants[file]->variantMap.size() != 0) {
+          int filePosition = variants[file]->variantMap.begin()->first;
+          if (!foundLocus || filePosition < position) {position = filePosition;}
+          foundLocus = true;
+        }
+      }
+      if (!foundLocus) {break;}
+
+      filesAtLocus.clear();
+      for (unsigned int file = 0; file < numberFiles; file++) {
+        if (onReferenceSequence[file] && variants[file]->variantMap.size() != 0 && variants[file]->variantMap.begin()->first == position) {
+          filesAtLocus.push_back(file);
+        }
+      }
+      compareFilesSameLocus(variants, filesAtLocus);
+
+      // Clear the compared variants from the structures and add the next
+      // record from each file if it is from the same reference sequence.
+      for (vector<unsigned int>::iterator iter = filesAtLocus.begin(); iter != filesAtLocus.end(); iter++) {
+        vcf& v       = *files[*iter];
+        variant& var = *variants[*iter];
+        var.variantMap.erase(var.variantMap.begin());
+        if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
+          var.addVariantToStructure(v.position, v.variantRecord);
+          v.success = v.getRecord();
+        }
+        flushFileRecords(*headers[*iter], var, ofile);
+      }
+    }
+
+    // All of the variants for this reference sequence have been compared.
+    for (unsigned int file = 0; file < numberFiles; file++) {
+      if (onReferenceSequence[file]) {flushFileRecords(*headers[file], *variants[file], ofile);}
+    }
+  }
+
+  // Flush the output buffer.
+  ofile.flushOutputBuffer();
+}
+
+// Compare the variants at the front of the variant maps of the files at the
+// same locus.  Each class of variant is compared separately, using the same
+// allele comparison as the intersection of two files, and each allele is
+// given a mask of the files in which it appears.
+void intersect::compareFilesSameLocus(vector<variant*>& variants, vector<unsigned int>& filesAtLocus) {
+  static recycledVector<reducedVariants> variantsAtLocus::* const classes[] = {
+    &variantsAtLocus::snps,
+    &variantsAtLocus::mnps,
+    &variantsAtLocus::insertions,
+    &variantsAtLocus::deletions,
+    &variantsAtLocus::complexVariants
+  };
+  unsigned int numberFiles = filesAtLocus.size();
+  vector<vector<uint64_t> > masks(numberFiles);
+  vector<int> matches;
+  vector<bool> commonB;
+
+  for (unsigned int variantClass = 0; variantClass < sizeof(classes) / sizeof(classes[0]); variantClass++) {
+    for (unsigned int a = 0; a < numberFiles; a++) {
+      recycledVector<reducedVariants>& alleles = variants[filesAtLocus[a]]->variantMap.begin()->second.*classes[variantClass];
+      masks[a].assign(alleles.size(), (uint64_t) 1 << filesAtLocus[a]);
+    }
+
+    // Compare each pair of files.
+    for (unsigned int a = 0; a < numberFiles; a++) {
+      recycledVector<reducedVariants>& allelesA = variants[filesAtLocus[a]]->variantMap.begin()->second.*classes[variantClass];
+      for (unsigned int b = a + 1; b < numberFiles; b++) {
+        recycledVector<reducedVariants>& allelesB = variants[filesAtLocus[b]]->variantMap.begin()->second.*classes[variantClass];
+        variants[filesAtLocus[a]]->matchAlleles(allelesA, allelesB, flags.sitesOnly, matches, commonB);
+        for (unsigned int allele = 0; allele < matches.size(); allele++) {
+          if (matches[allele] == -1) {continue;}
+          masks[a][allele]          |= (uint64_t) 1 << filesAtLocus[b];
+          masks[b][matches[allele]] |= (uint64_t) 1 << filesAtLocus[a];
+        }
+      }
+    }
+
+    // Keep the alleles satisfying the requested membership, writing each out
+    // only from the first file that contains it.
+    for (unsigned int a = 0; a < numberFiles; a++) {
+      variant& var = *variants[filesAtLocus[a]];
+      recycledVector<reducedVariants>& alleles = var.variantMap.begin()->second.*classes[variantClass];
+      for (unsigned int allele = 0; allele < alleles.size(); allele++) {
+        uint64_t mask    = masks[a][allele];
+        bool firstFile   = (mask & (~mask + 1)) == ((uint64_t) 1 << filesAtLocus[a]);
+        bool keep        = firstFile && keepAllele(mask);
+        originalVariants& ov = var.originalVariantsMap[alleles[allele].originalPosition][alleles[allele].recordNumber - 1];
+        ov.filtered[alleles[allele].altID] = !keep;
+        if (keep) {ov.sources |= mask;}
+      }
+    }
+  }
+
+  // Structural variation and rearrangement events are currently removed from the
+  // output file when performing intersections (regardless of the actual operation).
+  for (unsigned int a = 0; a < numberFiles; a++) {
+    variant& var = *variants[filesAtLocus[a]];
+    recycledVector<reducedVariants>::iterator iter = var.variantMap.begin()->second.svs.begin();
+    for (; iter != var.variantMap.begin()->second.svs.end(); iter++) {
+      var.originalVariantsMap[iter->originalPosition][iter->recordNumber - 1].filtered[iter->altID] = true;
+    }
+    iter = var.variantMap.begin()->second.rearrangements.begin();
+    for (; iter != var.variantMap.begin()->second.rearrangements.end(); iter++) {
+      var.originalVariantsMap[iter->originalPosition][iter->recordNumber - 1].filtered[iter->altID] = true;
+    }
+  }
+}
+
+// Determine if an allele present in the files given by the mask is kept.
+bool intersect::keepAllele(uint64_t mask) {
+  if (exactMembership) {return mask == membership;}
+
+  unsigned int count = 0;
+  for (; mask != 0; mask &= mask - 1) {count++;}
+
+  return count >= minimumFiles;
+}
+
+// Write out the records of a file whose alleles have all been compared.
+// These are the records at loci before the first position remaining in the
+// variant map, or all of the records if the variant map is empty.
+void intersect::flushFileRecords(vcfHeader& header, variant& var, output& ofile) {
+  while (var.originalVariantsMap.size() != 0) {
+    var.ovmIter = var.originalVariantsMap.begin();
+    if (var.variantMap.size() != 0) {
+      int maxPosition = 0;
+      for (var.ovIter = var.ovmIter->second.begin(); var.ovIter != var.ovmIter->second.end(); var.ovIter++) {
+        if (var.ovIter->maxPosition > maxPosition) {maxPosition = var.ovIter->maxPosition;}
+      }
+      if (var.variantMap.begin()->first <= maxPosition) {break;}
+    }
+    if (addSources) {tagSources(var.ovmIter->second);}
+    var.buildOutputRecord(ofile, header);
+    var.originalVariantsMap.erase(var.ovmIter);
+  }
+}
+
+// Add the files containing the kept alleles to the info field of each
+// record.  The files are numbered from one in the order given.
+void intersect::tagSources(recycledVector<originalVariants>& records) {
+  for (recycledVector<originalVariants>::iterator iter = records.begin(); iter != records.end(); iter++) {
+    if (iter->sources == 0) {continue;}
+
+    ostringstream sources;
+    string separator = "";
+    unsigned int file = 1;
+    for (uint64_t mask = iter->sources; mask != 0; mask >>= 1, file++) {
+      if (mask & 1) {
+        sources << separator << file;
+        separator = ",";
+      }
+    }
+    iter->info = (iter->info == "" || iter->info == ".") ? "SOURCES=" + sources.str() : iter->info + ";SOURCES=" + sources.str();
+  }
+}
+
+// Intersect a vcf file and a bed file.  All of the bed intervals are read
+// into an interval index first, so the two files do not need to have the
+// reference sequences in the same order and overlapping intervals are used
+// as they are.  Each allele of each record is then checked against the
+// intervals overlapping it.  When annotating, every record is kept and the
+// records are annotated with the info of the intervals they overlap.
 void intersect::intersectVcfBed(vcfHeader& header, vcf& v, variant& var, bed& b, bedStructure& bs, output& ofile) {
-  bs.lastBedIntervalEnd      = 0;
-  unsigned int distanceToBed = 0;
-  unsigned int leftDistance  = 0;
-  unsigned int rightDistance = 0;
-
-  // Build the variant structure for the vcf file.
-  v.success   = v.getRecord();
-  v.success   = var.buildVariantStructure(v);
-  var.ovmIter = var.originalVariantsMap.begin();
+  vector<bedRecord*> overlaps;
 
-  // Build the bed file structure and check if the first interval overlaps the
-  // next.  If so, the bed intervals need to be broken up into unique
-  // intervals.
-  bs.lastBedInterval = false;
-  b.success          = b.getRecord();
-  bs.initialiseBedMap(b, flags);
+  // Build the bed interval index.
+  bs.buildBedStructure(b);
 
-  // Perform the intersection by looping over all records in the vcf file.  Keep
-  // looping until this file is exhausted.  Within this loop, loop over each
-  // reference sequence individually.
+  // Perform the intersection by looping over all records in the vcf file, one
+  // reference sequence at a time.
+  v.success = v.getRecord();
   while (v.success) {
-
-    // Define the current reference sequence as that from the first entry in the
-    // variant map.
-    currentReferenceSequence = var.ovmIter->second.begin()->referenceSequence;
+    v.success   = var.buildVariantStructure(v);
+    var.ovmIter = var.originalVariantsMap.begin();
+    currentReferenceSequenceID = var.ovmIter->second.begin()->referenceSequenceID;
 
     // Loop over all records for this reference sequence.
-    while (var.ovmIter->second.begin()->referenceSequence == currentReferenceSequence) {
-
-      // Reset the iterateVcf and iterateBed flags.  Having compared all of the
-      // variants appearing at this position, this will determine whether the
-      // vcf file or the bed file should be iterated.
-      iterateBed = false;
-      iterateVcf = false;
+    while (var.originalVariantsMap.size() != 0) {
 
       // Loop over all variants at this locus.
-      var.ovIter = var.ovmIter->second.begin();
-      for (; var.ovIter != var.ovmIter->second.end(); var.ovIter++) {
+      for (var.ovIter = var.ovmIter->second.begin(); var.ovIter != var.ovmIter->second.end(); var.ovIter++) {
 
         // Consider each variant allele in turn and use the filtered vector to
         // indicate if a particular allele should be removed.  The actual removal
@@ -283,11 +478,10 @@ void intersect::intersectVcfBed(vcfHeader& header, vcf& v, variant& var, bed& b,
         // the variants are written to file.
         //
         // Begin by defining the required iterators.
-        vector<int>::iterator posIter          = var.ovIter->reducedPosition.begin();
-        vector<string>::iterator refIter       = var.ovIter->reducedRef.begin();
-        vector<string>::iterator altIter       = var.ovIter->reducedAlts.begin();
-        vector<variantType>::iterator typeIter = var.ovIter->type.begin();
-        vector<bool>::iterator filtIter        = var.ovIter->filtered.begin();
+        vector<int>::iterator posIter    = var.ovIter->reducedPosition.begin();
+        vector<string>::iterator refIter = var.ovIter->reducedRef.begin();
+        vector<string>::iterator altIter = var.ovIter->reducedAlts.begin();
+        vector<bool>::iterator filtIter  = var.ovIter->filtered.begin();
 
         // Loop over the variants.
         for (; posIter != var.ovIter->reducedPosition.end(); posIter++) {
@@ -297,165 +491,41 @@ void intersect::intersectVcfBed(vcfHeader& header, vcf& v, variant& var, bed& b,
           // interval.
           int endPos = max((refIter->size() + *posIter - 1), (altIter->size() + *posIter -1));
 
-          // Define the start and end of the bed interval.
-          int bedStart = bs.bmIter->first;
-          int bedEnd   = bs.bmIter->second.end;
-
-          // Define the variants overlap with the interval.
-          bool beforeStart    = (endPos < bedStart ) ? true : false;
-          bool overlapStart   = (*posIter < bedStart && endPos >= bedStart) ? true : false;
-          bool within         = (*posIter >= bedStart && endPos <= bedEnd) ? true : false;
-          bool overlapEnd     = (*posIter <= bedEnd && endPos > bedEnd) ? true : false;
-          bool afterEnd       = (*posIter > bedEnd) ? true : false;
-
-          // Variant is prior to the bed interval.  This depends on whether the
-          // ref and alt alleles are required to fall wholly within the bed
-          // interval.
-          if (beforeStart || (overlapStart && flags.whollyWithin)) {
-            *filtIter = priorToInterval(flags);
-
-          // Variant is beyond the bed interval.
-          } else if (afterEnd || (overlapEnd && flags.whollyWithin)) {
-            beyondInterval();
-
-          // Variant is within the bed interval
-          } else if (within || ( (overlapStart || overlapEnd) && !flags.whollyWithin)) {
-            *filtIter = withinInterval(flags);
-
-          // If the else statement is reached there is an error in the code.
-          } else {
-            cerr << "ERROR: Problem with intersection algorithm detected." << endl;
-            cerr << "The vcf record at " << var.ovIter->referenceSequence;
-            cerr << ":" << var.ovmIter->first << " does not fall before, within or" << endl;
-            cerr << "after the bed interval.  An algorithmic error must be present." << endl;
-            cerr << "Program terminated." << endl;
-            exit(1);
+          // Find the intervals overlapping the allele.  If the ref and alt
+          // alleles are required to fall wholly within an interval, only
+          // intervals containing the allele are used.
+          bool inInterval = false;
+          bs.findOverlaps(currentReferenceSequenceID, *posIter, endPos, overlaps);
+          for (vector<bedRecord*>::iterator bIter = overlaps.begin(); bIter != overlaps.end(); bIter++) {
+            if (flags.whollyWithin && ((*bIter)->start > *posIter || (*bIter)->end < endPos)) {continue;}
+            inInterval = true;
+            if (flags.annotate) {var.annotateRecordBed(*var.ovIter, **bIter);}
           }
 
+          // Mark the allele to be written out if it falls within the bed
+          // intervals, or outside of them if variants unique to the vcf file
+          // were requested.
+          if (!flags.annotate) {*filtIter = (inInterval == flags.findUnique);}
+
           // Iterate the remaining iterators.
           refIter++;
           altIter++;
-          typeIter++;
           filtIter++;
         }
       }
 
-      // Iterate the either the vcf or the bed file.
-      if (iterateVcf) {
-        iterateVcfFile(header, v, var, ofile);
-
-        // If the variant structure is empty, either the vcf file has been completely
-        // parsed or all records for the particular reference sequence have been
-        // exhausted.  If this is the case, build the new variant structure for the
-        // new reference sequence and parse the bed file until this sequence is found.
-        if (var.originalVariantsMap.size() == 0 && v.success) {nextReferenceSequence(v, var, b, bs);}
-
-      // Iterate the bed file.
-      } else if (iterateBed) {
-        iterateBedFile(b, bs);
-      } else {
-        cerr << "ERROR: Neither the vcf or bed file are to be iterated." << endl;
-        cerr << "This should not occur and indicates that an error exists" << endl;
-        cerr << "in the vcf/bed intersection algorithm." << endl << endl;
-        cerr << "Program terminated." << endl;
-        exit(1);
-      }
-
-      // Check if the bed file is exhausted.  If the vcf file is completely parsed, the
-      // program will naturally terminate, however, if the bed file has been exhausted,
-      // the loops will continue.  Thus, if the bed map is empty and there are no more
-      // intervals to be read in, finish parsing the vcf file without checking for
-      // intersection with bed intervals.  If only records falling within bed intervals
-      // are required, the program can terminate.
-      if (bs.bedMap.size() == 0) {
-
-        // The bed map is empty, but the bed file is not.  This means that all of the
-        // intervals for the current reference sequence have been parsed.  The
-        // remaining variants for this reference sequence can be processed since they
-        // cannot overlap an interval and the next reference sequence can be started.
-        if (b.success) {
-          var.clearReferenceSequenceBed(header, v, flags, currentReferenceSequence, ofile);
-          v.success   = var.buildVariantStructure(v);
-          var.ovmIter = var.originalVariantsMap.begin();
-          currentReferenceSequence = var.ovmIter->second.begin()->referenceSequence;
-          bs.lastBedInterval = false;
-          bs.initialiseBedMap(b, flags);
-
-        // The bed file is completely parsed, so clear out the remaining variants in the
-        // vcf file and terminate.
-        } else {
-          if (flags.findUnique || flags.annotate) {
-            var.clearOriginalVariants(header, flags, ofile, true);
-  
-          // No more intersections will be founda and annotations aren't being performed, 
-          // so no more records in the vcf file will be sent to the output so the loops 
-          // can terminate.
-          } else {
-            v.success = false;
-          }
-        }
-      }
+      // Write out the record and move on to the next one.
+      iterateVcfFile(header, v, var, ofile);
     }
   }
 
-  // If the variant structure is not empty, not all of the records were parsed.
-  if (var.variantMap.size() != 0) {cerr << "WARNING: Not all records were flushed out of the variant structure." << endl;}
-
   // Flush the output buffer.
   ofile.flushOutputBuffer();
 }
 
-// When comparing a vcf with a bed, deal with the variants that fall before a bed
-// interval.
-bool intersect::priorToInterval(intFlags& flags) {
-  // Update statistics on distance to the nearest bed interval.
-  //unsigned int leftDistance  = *posIter - lastBedIntervalEnd;
-  //unsigned int rightDistance = bedStart - *posIter;
-  //if (lastBedIntervalEnd == 0) {distanceToBed = rightDistance;}
-  //else {distanceToBed = (rightDistance > leftDistance) ? -1 * leftDistance : rightDistance;}
-  //distanceDist[currentReferenceSequence][distanceToBed]++;
-
-  // Mark this as a variant to be written out if variants unique to the
-  // vcf file (i.e. outside of the bed intervals) were requested.
-  bool filter  = flags.findUnique ? false : true;
-  iterateVcf = true;
-
-  return filter;
-}
-
-// When comparing a vcf with a bed, deal with the variants that fall after a bed
-// interval.
-void intersect::beyondInterval() {
-
-  // Update statistics on distance to the nearest bed interval.
-  //if (lastBedInterval) {
-  //  distanceToBed = *posIter - bedEnd;
-  //  distanceDist[currentReferenceSequence][distanceToBed]++;
-  //}
-  iterateBed = true;
-}
-
-// When comparing a vcf with a bed, deal with the variants that fall within a bed
-// interval.
-bool intersect::withinInterval(intFlags& flags) {
-
-  // Update statistics on distance to the nearest bed interval.
-  //distanceToBed = 0;
-  //distanceDist[currentReferenceSequence][distanceToBed]++;
-
-  // Mark this as a variant to be written out if variants intersectiong the
-  // vcf file (i.e. within the bed intervals) were requested.
-  bool filter  = flags.findUnique ? true : false;
-  iterateVcf = true;
-
-  return filter;
-}
-
-// After comparing all of the variants at a particular position, either
-// the vcf or the bed file needs to be moved on one more record and
-// relevant map entries can be erased.  Perform these tasks here.
-//
-// Begin with iterating the vcf file.
+// After comparing all of the variants at a particular position with the
+// bed intervals, write out the record, erase it and move the vcf file on
+// one more record.
 void intersect::iterateVcfFile(vcfHeader& header, vcf& v, variant& var, output& ofile) {
 
   // Build the output record, removing unwanted alleles and modifying the
@@ -466,7 +536,7 @@ void intersect::iterateVcfFile(vcfHeader& header, vcf& v, variant& var, output&
   var.originalVariantsMap.erase(var.ovmIter);
 
   // Add the next variant record from the current reference sequence into the structure.
-  if (v.variantRecord.referenceSequence == currentReferenceSequence && v.success) {
+  if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
     var.addVariantToStructure(v.position, v.variantRecord);
     v.success = v.getRecord();
   }
@@ -475,61 +545,6 @@ void intersect::iterateVcfFile(vcfHeader& header, vcf& v, variant& var, output&
   var.ovmIter = var.originalVariantsMap.begin();
 }
 
-// Or iterate the bed file.
-void intersect::iterateBedFile(bed& b, bedStructure& bs) {
-  bs.lastBedIntervalEnd = bs.bmIter->second.end;
-
-  // Erase the last bed interval from the structure.
-  bs.bedMap.erase(bs.bmIter);
-
-  // Add the next bed interval from the current reference sequence into the structure.
-  if (b.bRecord.referenceSequence == currentReferenceSequence && b.success) {
-    bs.addIntervalToStructure(b.bRecord);
-    b.success = b.getRecord();
-  }
-
-  // Set the iterator to the first element in the map.
-  bs.bmIter = bs.bedMap.begin();
-
-  // Set the bsNext iterator to the next element in the map and determine if this is
-  // the last interval in the bed file for this reference sequence.
-  bs.bmNext = bs.bedMap.begin();
-  if (bs.bedMap.size() == 1) {bs.lastBedInterval = true;}
-  else if (bs.bedMap.size() != 0) {bs.bmNext++;}
-
-  // Check if the end position of the current interval is larger than the start
-  // position of the next interval in the structure.  If so, the intervals
-  // overlap and need to be split up.
-  if (!bs.lastBedInterval) {
-    if (bs.bmIter->second.end >= bs.bmNext->first) {
-      bs.resolveOverlaps(flags.annotate);
-      bs.bmIter = bs.bedMap.begin();
-      bs.bmNext = bs.bedMap.begin();
-      bs.bmNext++;
-    }
-  }
-}
-
-// Build the variant structure for the new reference sequence and move the bed
-// file on until it reaches this reference sequence.
-void intersect::nextReferenceSequence(vcf& v, variant& var, bed& b, bedStructure& bs) {
-  v.success                = var.buildVariantStructure(v);
-  var.ovmIter              = var.originalVariantsMap.begin();
-  currentReferenceSequence = var.ovmIter->second.begin()->referenceSequence;
-
-  // Clear the current bed map.
-  bs.bmIter  = bs.bedMap.begin();
-  for (; bs.bmIter != bs.bedMap.end(); bs.bmIter++) {bs.bedMap.erase(bs.bmIter);}
-
-  // Parse through the bed file until the current reference sequence is found (or
-  // the end of the bed file is reached).
-  while (b.bRecord.referenceSequence != currentReferenceSequence) {b.success = b.getRecord();}
-  if (b.success) {
-    bs.lastBedInterval = false;
-    bs.initialiseBedMap(b, flags);
-  }
-}
-
 // Check to see that records for all reference sequences were compared
 // correctly.
 void intersect::checkReferenceSequences(variant& var1, variant& var2) {
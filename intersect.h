@@ -16,6 +16,7 @@
 #include <string>
 #include <getopt.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "bed.h"
 #include "bedStructure.h"
@@ -32,26 +33,37 @@ using namespace std;
 
 namespace vcfCTools {
 
+// The maximum number of vcf files that can be intersected at once.  The
+// files sharing an allele are held as a bit mask.
+#define MAX_INTERSECT_FILES 64
+
 class intersect {
   public:
     intersect(void);
     ~intersect(void);
-    void beyondInterval();
     void checkReferenceSequences(variant&, variant&);
+    void compareFilesSameLocus(vector<variant*>&, vector<unsigned int>&);
+    void flushFileRecords(vcfHeader&, variant&, output&);
     void intersectVcf(vcfHeader&, vcfHeader&, vcf&, variant&, vcf&, variant&, output&);
     void intersectVcfBed(vcfHeader&, vcf&, variant&, bed&, bedStructure&, output&);
-    void iterateBedFile(bed&, bedStructure&);
+    void intersectVcfFiles(vector<vcfHeader*>&, vector<vcf*>&, vector<variant*>&, output&);
     void iterateVcfFile(vcfHeader&, vcf&, variant&, output&);
-    void nextReferenceSequence(vcf&, variant&, bed&, bedStructure&);
-    bool priorToInterval(intFlags&);
+    bool keepAllele(uint64_t);
     void setBooleanFlags(bool, bool, bool, bool, bool, bool);
-    bool withinInterval(intFlags&);
+    void tagSources(recycledVector<originalVariants>&);
 
   public:
-    bool iterateBed;
-    bool iterateVcf;
-    string currentReferenceSequence;
+    unsigned int currentReferenceSequenceID;
     intFlags flags;
+
+    // When intersecting many files, alleles are kept if they appear in at
+    // least minimumFiles of the files, or (if exactMembership is set) in
+    // exactly the files in membership.  The files containing the alleles
+    // can be added to the info field.
+    unsigned int minimumFiles;
+    bool exactMembership;
+    uint64_t membership;
+    bool addSources;
     map<string, map<int, unsigned int> > distanceDist;
 };
 
@@ -0,0 +1,159 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// A memory mapped fasta reference, opened once and shared
+// by everything that needs reference sequence.
+// ******************************************************
+
+#include "mapped_fasta.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Constructor.
+mappedFasta::mappedFasta(void) {
+  data = NULL;
+  size = 0;
+}
+
+// Destructor.
+mappedFasta::~mappedFasta(void) {
+  close();
+}
+
+// Map the fasta file and read the index.
+bool mappedFasta::open(const string& fastaFile) {
+  close();
+  filename = fastaFile;
+
+  int descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (descriptor == -1) {return false;}
+
+  struct stat fileInfo;
+  if (fstat(descriptor, &fileInfo) != 0 || fileInfo.st_size == 0) {
+    ::close(descriptor);
+    return false;
+  }
+  size = fileInfo.st_size;
+  void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  ::close(descriptor);
+  if (mapped == MAP_FAILED) {
+    size = 0;
+    return false;
+  }
+  data = (const char*) mapped;
+
+  // Reading is mostly of short, scattered sub-sequences.
+  madvise(mapped, size, MADV_RANDOM);
+
+  // Read the fasta index, generating it if necessary, and copy the entries
+  // into the hash table.
+  FastaIndex index;
+  struct stat indexInfo;
+  string indexFile = filename + index.indexFileExtension();
+  if (stat(indexFile.c_str(), &indexInfo) == 0) {
+    index.readIndexFile(indexFile);
+  } else {
+    cerr << "index file " << indexFile << " not found, generating..." << endl;
+    index.indexReference(filename);
+    index.writeIndexFile(indexFile);
+  }
+  sequences.rehash(index.size());
+  for (FastaIndex::iterator iter = index.begin(); iter != index.end(); iter++) {
+    mappedSequence& sequence = sequences[iter->first];
+    sequence.offset    = iter->second.offset;
+    sequence.length    = iter->second.length;
+    sequence.lineBases = iter->second.line_blen;
+    sequence.lineBytes = iter->second.line_len;
+  }
+
+  return true;
+}
+
+// Unmap the file.
+void mappedFasta::close() {
+  if (data != NULL) {munmap((void*) data, size);}
+  data = NULL;
+  size = 0;
+  sequences.clear();
+}
+
+// Get the sequence of the given length starting at the (zero based) start
+// coordinate.  The sequence is truncated at the end of the reference
+// sequence.  Returns false if the sequence is not in the reference.
+bool mappedFasta::getSubSequence(const string& sequenceName, int start, int length, string& sequence) {
+  sequence.clear();
+  tr1::unordered_map<string, mappedSequence>::const_iterator iter = sequences.find(sequenceName);
+  if (iter == sequences.end()) {return false;}
+
+  const mappedSequence& entry = iter->second;
+  if (start < 0) {start = 0;}
+  if (start + length > entry.length) {length = entry.length - start;}
+  if (length <= 0) {return true;}
+  sequence.reserve(length);
+
+  // Copy the bases a line at a time.
+  int line   = start / entry.lineBases;
+  int column = start % entry.lineBases;
+  while (length > 0) {
+    size_t offset = entry.offset + (long long) line * entry.lineBytes + column;
+    int bases     = entry.lineBases - column;
+    if (bases > length) {bases = length;}
+    if (offset + bases > size) {break;}
+    sequence.append(data + offset, bases);
+    length -= bases;
+    column  = 0;
+    line++;
+  }
+
+  return true;
+}
+
+// As above, but terminate with an error if the sequence is not in the
+// reference.
+string mappedFasta::getSubSequence(const string& sequenceName, int start, int length) {
+  string sequence;
+  if (!getSubSequence(sequenceName, start, length, sequence)) {
+    cerr << "ERROR: Reference sequence " << sequenceName << " is not in the fasta file " << filename << "." << endl;
+    exit(1);
+  }
+
+  return sequence;
+}
+
+// Get the length of a sequence (0 if it is not in the reference).
+int mappedFasta::sequenceLength(const string& sequenceName) {
+  tr1::unordered_map<string, mappedSequence>::const_iterator iter = sequences.find(sequenceName);
+
+  return (iter == sequences.end()) ? 0 : iter->second.length;
+}
+
+// The references opened so far, shared by all threads.
+mappedFasta& vcfCTools::sharedFasta(const string& fastaFile) {
+  static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  static map<string, mappedFasta*> references;
+
+  pthread_mutex_lock(&lock);
+  map<string, mappedFasta*>::iterator iter = references.find(fastaFile);
+  if (iter == references.end()) {
+    mappedFasta* reference = new mappedFasta();
+    if (!reference->open(fastaFile)) {
+      cerr << "ERROR: Unable to open fasta reference: " << fastaFile << endl;
+      exit(1);
+    }
+    iter = references.insert(make_pair(fastaFile, reference)).first;
+  }
+  pthread_mutex_unlock(&lock);
+
+  return *iter->second;
+}
@@ -0,0 +1,66 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// A memory mapped fasta reference, opened once and shared
+// by everything that needs reference sequence.
+// ******************************************************
+
+#ifndef MAPPED_FASTA_H
+#define MAPPED_FASTA_H
+
+#include <pthread.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tr1/unordered_map>
+
+#include "Fasta.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The location of a sequence in the mapped file (from the fasta index).
+struct mappedSequence {
+  long long offset;
+  int length;
+  int lineBases;
+  int lineBytes;
+};
+
+// The whole fasta file is mapped into memory and the index (read from the
+// .fai file, which is generated if it does not exist) is held in a hash
+// table keyed by sequence name.  Sub-sequences are copied straight out of
+// the mapped pages a line at a time, skipping the newlines, so no file
+// operations are needed once the reference is open.  The mapping is read
+// only, so the reference can be used from multiple threads.
+class mappedFasta {
+  public:
+    mappedFasta(void);
+    ~mappedFasta(void);
+    bool open(const string&);
+    void close();
+    string getSubSequence(const string&, int, int);
+    bool getSubSequence(const string&, int, int, string&);
+    int sequenceLength(const string&);
+
+  public:
+    string filename;
+    const char* data;
+    size_t size;
+    tr1::unordered_map<string, mappedSequence> sequences;
+};
+
+// Get the reference for a fasta file.  Each file is opened and mapped the
+// first time it is requested and kept open until the program exits.
+mappedFasta& sharedFasta(const string&);
+
+} // namespace vcfCTools
+
+#endif // MAPPED_FASTA_H
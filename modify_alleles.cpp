@@ -16,6 +16,14 @@
 #define MISMATCH 'X'
 #define INSERTION 'I'
 #define DELETION 'D'
+
+// The number of reference bases first read to the left of an indel that
+// is being stepped.
+#define STEP_BLOCK_LENGTH 64
+
+// The number of diagonals either side of the alleles searched by the
+// banded alignment.
+#define ALIGNMENT_BAND_MARGIN 8
 #include "modify_alleles.h"
 
 using namespace std;
@@ -80,7 +88,9 @@ void modifyAlleles::extendAlleles() {
   workingAlt = anchor + flankFront + modifiedAlt + flankEnd + anchor;
 }
 
-// Align the alleles to each other.
+// Align the alleles to each other.  Complex variants are not currently
+// realigned (the call in variant::determineVariantType is disabled), so
+// this is not used yet.
 void modifyAlleles::alignAlleles() {
 
   // Align the alleles to each other.
@@ -112,9 +122,7 @@ void modifyAlleles::getFlankingReference() {
   int length   = modifiedRef.length() + 2 * flankLength;
   if (frontPos <= 0) {frontPos = 1;}
 
-  FastaReference* fr = new FastaReference(fasta);
-  flank = fr->getSubSequence(referenceSequence, frontPos, length);
-  delete fr;
+  flank = sharedFasta(fasta).getSubSequence(referenceSequence, frontPos, length);
 
   flankFront = flank.substr(0, flankLength);
   flankEnd   = flank.substr(flankLength + modifiedRef.length(), flankLength);
@@ -136,9 +144,14 @@ void modifyAlleles::smithWaterman() {
   const unsigned int referenceLen = strlen(reference);
   const unsigned int queryLen     = strlen(query);
 
+  // The alleles share the flanking sequence, so the alignment can only leave
+  // the diagonal within the alleles themselves.  Only the band of diagonals
+  // that the alleles can reach is filled.
+  unsigned int bandWidth = max(modifiedRef.length(), modifiedAlt.length()) + ALIGNMENT_BAND_MARGIN;
+
   // Call the Smith-Waterman routines.
   CSmithWatermanGotoh sw(matchScore, mismatchScore, gapOpenPenalty, gapExtendPenalty);
-  sw.Align(referencePos, workingRef, workingAlt, reference, referenceLen, query, queryLen);
+  sw.BandedAlign(referencePos, workingRef, workingAlt, reference, referenceLen, query, queryLen, bandWidth);
 }
 
 // After the alignment has taken place, generate the CIGAR string.
@@ -406,87 +419,55 @@ void modifyAlleles::updateWorkingAlleles() {
   workingAlt = "ZZZZZZZZZZZZZZZ" + flankFront + modifiedAlt + flankEnd + "ZZZZZZZZZZZZZZZ";
 }
 
-// Attempt to place the indel further left than reported in the vcf file.
-// Use fastahack to get flanking reference sequence.
+// Shift an insertion or deletion as far to the left as the reference
+// allows.  The inserted/deleted sequence can move one base to the left
+// whenever the base before it (the anchor base) is the same as its last
+// base.  The sequence is rotated as it moves, so the event walks back
+// through a repeat of any unit length a base at a time, without any
+// alignment.  For example, the deletion CAC -> C at the end of ACGACAC
+// moves to GAC -> G.  The reference to the left is read from the mapped
+// fasta in blocks, doubling in size, as it is needed.
 void modifyAlleles::stepAlleles() {
-  bool leftAligned = false;
-  bool reset;
-  unsigned int count;
-  unsigned int refPosition;
-  unsigned int indelPosition;
-  string anchor;
-  string laggingBase;
-
-  // Get the flanking reference sequence.  The variable sequence is
-  // populated with the inserted/deleted bases.
-  FastaReference* fr = new FastaReference(fasta);
-  if (type.isInsertion) {
-    flankLength = 30 * modifiedAlt.length();
-    sequence    = modifiedAlt.substr(1, modifiedAlt.length());
-    flank       = fr->getSubSequence(referenceSequence, originalPosition - 1 - flankLength, flankLength);
-    flank      += modifiedAlt;
-    laggingBase = fr->getSubSequence(referenceSequence, originalPosition, 1);
-  } else if (type.isDeletion) {
-    flankLength = 30 * modifiedRef.length();
-    sequence    = modifiedRef.substr(1, modifiedRef.length());
-    flank       = fr->getSubSequence(referenceSequence, originalPosition - 1 - flankLength, flankLength);
-    flank      += modifiedRef;
-    laggingBase = fr->getSubSequence(referenceSequence, originalPosition + sequence.length(), 1);
-  }
-
-  // Try stepping the inserted/deleted alleles backwards through the
-  // reference sequence.  The first base is an anchor base and may be
-  // permitted to change.  For example, consider the deletion of an
-  // AC in a dinucleotide repeat.  If the alleles are represented as
-  // CAC -> C, the starting C in the ref allele may be subject to
-  // change.  If the context is ACGACAC and the coordinate referes to
-  // deletion of the second AC, this can be replaced by GAC -> G and
-  // thus the starting C is not preserved.
-  count           = 0;
-  refPosition     = flank.length() - sequence.length() - 1;
-  workingPosition = modifiedPosition;
-  while (count < sequence.length()) {
-    indelPosition = 0;
-    while (sequence[indelPosition] == flank[refPosition + indelPosition] && indelPosition < sequence.length()) {
-
-      // If the whole sequence matches the reference then the sequence
-      // can be moved to this position.
-      if (indelPosition == sequence.length() - 1) {
-        workingPosition  = workingPosition - count - 1;
-        count            = 0;
-        anchor           = flank[refPosition - 1];
-
-        // Ensure that replacing the reported allele representation with
-        // the left-aligned one results in the same alleles.
-        string oldAllele, newAllele;
-        if (type.isInsertion) {
-          oldAllele = flank.substr(refPosition - 1, flankLength - refPosition + 2) + sequence + laggingBase;
-          newAllele = anchor[0] + flank.substr(refPosition - 1 + sequence.length() - 1, flankLength - refPosition + 1) + sequence + laggingBase;
-        } else if (type.isDeletion) {
-          oldAllele = flank.substr(refPosition - 1, flankLength - refPosition + 2) + laggingBase;
-          newAllele = anchor[0] + flank.substr(refPosition - 1 + sequence.length() - 1, flankLength - refPosition + 1) + laggingBase;
-        }
-        if (oldAllele == newAllele) {
-          leftAligned = true;
-          reset       = true;
-        }
-      }
-      indelPosition++;
+  mappedFasta& fr = sharedFasta(fasta);
+
+  // The variable sequence is populated with the inserted/deleted bases.
+  if (type.isInsertion) {sequence = modifiedAlt.substr(1);}
+  else if (type.isDeletion) {sequence = modifiedRef.substr(1);}
+  else {return;}
+  if (sequence.length() == 0) {return;}
+
+  // flank holds the reference from flankStart up to the current anchor.
+  int blockLength  = STEP_BLOCK_LENGTH;
+  int flankStart   = modifiedPosition + 1;
+  workingPosition  = modifiedPosition;
+  leftAligned      = false;
+  flank.clear();
+  while (true) {
+    if (workingPosition < flankStart) {
+      int start  = max(1, workingPosition - blockLength + 1);
+      flank      = fr.getSubSequence(referenceSequence, start - 1, workingPosition - start + 1);
+      flankStart = start;
+      blockLength *= 2;
     }
-    refPosition--;
-    if (reset) {reset = false;}
-    else {count++;}
+    if (workingPosition == 1 || toupper(flank[workingPosition - flankStart]) != toupper(sequence[sequence.length() - 1])) {break;}
+
+    sequence.insert(sequence.begin(), sequence[sequence.length() - 1]);
+    sequence.erase(sequence.length() - 1);
+    workingPosition--;
+    leftAligned = true;
   }
 
+  // The anchor of the shifted alleles is the reference base before the
+  // inserted/deleted sequence.
   if (leftAligned) {
-
-    // Change the first base in the reference and alternate alleles to
-    // the anchor base.  This is the leftmost base that both alleles
-    // share.
-    modifiedRef[0]   = anchor[0];
-    modifiedAlt[0]   = anchor[0];
+    string anchor(1, toupper(flank[workingPosition - flankStart]));
+    if (type.isInsertion) {
+      modifiedRef = anchor;
+      modifiedAlt = anchor + sequence;
+    } else {
+      modifiedRef = anchor + sequence;
+      modifiedAlt = anchor;
+    }
     modifiedPosition = workingPosition;
   }
-
-  delete fr;
 }
@@ -14,6 +14,7 @@
 #ifndef MODIFY_ALLELES_H
 #define MODIFY_ALLELES_H
 
+#include <cctype>
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
@@ -24,6 +25,7 @@
 #include <vector>
 
 #include "Fasta.h"
+#include "mapped_fasta.h"
 #include "SmithWatermanGotoh.h"
 #include "split.h"
 #include "structures.h"
@@ -10,62 +10,284 @@
 
 #include "output.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 using namespace std;
 using namespace vcfCTools;
 
 // Constructor.
-output::output(void) 
-{}
+fileOutputBuffer::fileOutputBuffer(void) {
+  descriptor = -1;
+}
+
+// Destructor.
+fileOutputBuffer::~fileOutputBuffer(void) {
+  close();
+}
+
+// Open the file for writing.  If no file name is given, write to the
+// standard output.
+bool fileOutputBuffer::open(string& filename) {
+  if (filename == "") {descriptor = STDOUT_FILENO;}
+  else {descriptor = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);}
+  if (descriptor == -1) {return false;}
+
+  block.resize(OUTPUT_BLOCK_SIZE);
+  setp(&block[0], &block[0] + block.size());
+
+  return true;
+}
+
+// Write out the current block and close the file.  The standard output is
+// left open.
+void fileOutputBuffer::close() {
+  if (descriptor == -1) {return;}
+  writeBlock(NULL, 0);
+  if (descriptor != STDOUT_FILENO) {::close(descriptor);}
+  descriptor = -1;
+}
+
+// Write the current block followed by the given text, and empty the block.
+void fileOutputBuffer::writeBlock(const char* text, size_t length) {
+  struct iovec parts[2];
+  parts[0].iov_base = pbase();
+  parts[0].iov_len  = pptr() - pbase();
+  parts[1].iov_base = (void*) text;
+  parts[1].iov_len  = length;
+
+  struct iovec* part = parts;
+  int numberParts    = 2;
+  while (numberParts != 0) {
+    if (part->iov_len == 0) {
+      part++;
+      numberParts--;
+      continue;
+    }
+    ssize_t written = writev(descriptor, part, numberParts);
+    if (written == -1) {
+      if (errno == EINTR) {continue;}
+      cerr << "ERROR: Unable to write to the output file." << endl;
+      exit(1);
+    }
+
+    // Move past the text written by a partial write.
+    while (numberParts != 0 && (size_t) written >= part->iov_len) {
+      written -= part->iov_len;
+      part++;
+      numberParts--;
+    }
+    if (numberParts != 0) {
+      part->iov_base = (char*) part->iov_base + written;
+      part->iov_len -= written;
+    }
+  }
+  setp(&block[0], &block[0] + block.size());
+}
+
+// Write out the full block.
+int fileOutputBuffer::overflow(int c) {
+  if (descriptor == -1) {return traits_type::eof();}
+  writeBlock(NULL, 0);
+  if (c != traits_type::eof()) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(c);
+}
+
+// Add text to the block.  If it does not fit, the block and the text are
+// written together.
+streamsize fileOutputBuffer::xsputn(const char* text, streamsize length) {
+  if (descriptor == -1) {return 0;}
+  if (length <= epptr() - pptr()) {
+    traits_type::copy(pptr(), text, length);
+    pbump(length);
+  } else {
+    writeBlock(text, length);
+  }
+
+  return length;
+}
+
+// Flushing the stream does not write the block.
+int fileOutputBuffer::sync() {
+  return 0;
+}
+
+// Constructor.
+output::output(void) {
+  bufferPositions            = 1000;
+  bufferedPositions          = 0;
+  currentReferenceSequenceID = NO_CONTIG;
+  firstChunk                 = 0;
+  outputStream               = &cout;
+}
 
 // Destructor.
 output::~output(void)
 {}
 
-// Open the output file.
+// Open the output file.  Files ending in .gz are written BGZF compressed.
+// If no file is given, the records are written to the standard output.
 ostream* output::openOutputFile(string& outputFile) {
-  ostream* outputStream;
-  if (outputFile == "") {outputStream = &cout;}
-  else {outputStream = new ofstream(outputFile.c_str());}
+  if (outputFile.size() > 3 && outputFile.substr(outputFile.size() - 3) == ".gz") {
+    if (!compressedBuffer.open(outputFile, threadPool::availableCores() - 1)) {
+      cerr << "Failed to open file: " << outputFile << endl;
+      exit(1);
+    }
+    outputStream = new ostream(&compressedBuffer);
+  } else {
+    if (!fileBuffer.open(outputFile)) {
+      cerr << "Failed to open file: " << outputFile << endl;
+      exit(1);
+    }
+    outputStream = new ostream(&fileBuffer);
+  }
 
   return outputStream;
 }
 
+// Close the output file.  This writes out the final block (and for
+// compressed output, the end of file marker).
+void output::closeOutputFile() {
+  writer.stop();
+  outputStream->flush();
+  if (outputStream != &cout) {
+    delete outputStream;
+    outputStream = &cout;
+  }
+  fileBuffer.close();
+  compressedBuffer.close();
+}
+
 // Populate the output buffer with a record.
-void output::flushToBuffer(int position, string& referenceSequence) {
+void output::flushToBuffer(int position, unsigned int referenceSequenceID) {
 
   // If the reference sequence of the variant to add to the buffer
-  // is not the same as the stored value and there are variants in the
-  // buffer, flush the buffer to the output file.
-  if (outputBuffer.size() != 0 && currentReferenceSequence != referenceSequence) {
-    currentReferenceSequence = referenceSequence;
-    for (obIter = outputBuffer.begin(); obIter != outputBuffer.end(); obIter++) {
-      for (recordIter = obIter->second.begin(); recordIter != obIter->second.end(); recordIter++) {
-        *outputStream << *recordIter << endl;
-      }
-      outputBuffer.erase(obIter);
-    }
+  // is not the same as the stored value, flush the buffer to the output
+  // file.
+  if (currentReferenceSequenceID != referenceSequenceID) {
+    currentReferenceSequenceID = referenceSequenceID;
+    writeBuffer(bufferIndex.size());
   }
 
-  // If the output buffer contains more than 1000 entries, flush the
-  // first entry to the output and erase it from the buffer.
-  if (outputBuffer.size() > 1000) {
-    obIter = outputBuffer.begin();
-    for (recordIter = obIter->second.begin(); recordIter != obIter->second.end(); recordIter++) {
-      *outputStream << *recordIter << endl;
-    }
-    outputBuffer.erase(obIter);
+  // If the output buffer contains more than the allowed number of
+  // positions, write out the records at the first position.
+  if (bufferPositions != 0 && bufferedPositions > bufferPositions) {
+    size_t end = 0;
+    while (end < bufferIndex.size() && bufferIndex[end].position == bufferIndex[0].position) {end++;}
+    writeBuffer(end);
   }
 
   // Add the new built record to the buffer.
-  outputBuffer[position].push_back(outputRecord);
+  bufferRecord(position);
+}
+
+// Add the built record to the buffer.  The text is added to the last
+// chunk, unless it is full.  Records almost always arrive in position
+// order, so the record is usually added to the back of the index.
+void output::bufferRecord(int position) {
+  size_t length = outputRecord.size() + 1;
+  if (bufferChunks.empty() || (bufferChunks.back().text.size() != 0 && bufferChunks.back().text.size() + length > OUTPUT_CHUNK_SIZE)) {
+    bufferChunks.push_back(bufferChunk());
+    bufferChunks.back().records = 0;
+    if (spareChunks.empty()) {bufferChunks.back().text.reserve(OUTPUT_CHUNK_SIZE);}
+    else {
+      bufferChunks.back().text.swap(spareChunks.back());
+      spareChunks.pop_back();
+    }
+  }
+  bufferChunk& chunk = bufferChunks.back();
+
+  bufferedRecord record;
+  record.position = position;
+  record.chunk    = firstChunk + bufferChunks.size() - 1;
+  record.offset   = chunk.text.size();
+  record.length   = length;
+  chunk.text += outputRecord;
+  chunk.text += '\n';
+  chunk.records++;
+
+  if (bufferIndex.empty() || position >= bufferIndex.back().position) {
+    if (bufferIndex.empty() || position != bufferIndex.back().position) {bufferedPositions++;}
+    bufferIndex.push_back(record);
+  } else {
+    deque<bufferedRecord>::iterator iter = upper_bound(bufferIndex.begin(), bufferIndex.end(), record, earlierPosition());
+    if (iter == bufferIndex.begin() || (iter - 1)->position != position) {bufferedPositions++;}
+    bufferIndex.insert(iter, record);
+  }
+}
+
+// Write out the first records in the buffer, up to (but not including)
+// the given index entry.  Only whole positions are written.  Records that
+// are adjacent in a chunk are written together.
+void output::writeBuffer(size_t end) {
+  size_t index = 0;
+  while (index < end) {
+    bufferChunk& chunk = bufferChunks[bufferIndex[index].chunk - firstChunk];
+    size_t chunkID     = bufferIndex[index].chunk;
+    size_t offset      = bufferIndex[index].offset;
+    size_t length      = 0;
+    do {
+      length += bufferIndex[index].length;
+      chunk.records--;
+      if (index + 1 == end || bufferIndex[index + 1].position != bufferIndex[index].position) {bufferedPositions--;}
+      index++;
+    } while (index < end && bufferIndex[index].chunk == chunkID && bufferIndex[index].offset == offset + length);
+    writeText(chunk.text.data() + offset, length);
+  }
+  bufferIndex.erase(bufferIndex.begin(), bufferIndex.begin() + end);
+  releaseChunks();
+}
+
+// Keep the chunks at the front of the buffer that have no records left to
+// write for reuse.
+void output::releaseChunks() {
+  while (!bufferChunks.empty() && bufferChunks.front().records == 0) {
+    spareChunks.push_back(string());
+    spareChunks.back().swap(bufferChunks.front().text);
+    spareChunks.back().clear();
+    bufferChunks.pop_front();
+    firstChunk++;
+  }
+}
+
+// Write out the entries in the output buffer before a position.
+void output::flushBefore(int position) {
+  size_t end = 0;
+  while (end < bufferIndex.size() && bufferIndex[end].position < position) {end++;}
+  writeBuffer(end);
 }
 
 // Clear all entries out of the output buffer.
 void output::flushOutputBuffer() {
-  for (obIter = outputBuffer.begin(); obIter != outputBuffer.end(); obIter++) {
-    for (recordIter = obIter->second.begin(); recordIter != obIter->second.end(); recordIter++) {
-      *outputStream << *recordIter << endl;
-    }
-    outputBuffer.erase(obIter);
+  writeBuffer(bufferIndex.size());
+}
+
+// Write the records on a separate thread.  This must be called after the
+// header has been written, and nothing else can be written to the output
+// stream until the file is closed.
+void output::startWriter() {
+  writer.start(outputStream);
+}
+
+// Write a record to the output file.
+void output::writeRecord(string& record) {
+  if (writer.running) {writer.write(record);}
+  else {
+    outputStream->write(record.data(), record.size());
+    outputStream->put('\n');
   }
 }
+
+// Write text holding whole records (each ended with a newline) to the
+// output file.
+void output::writeText(const char* text, size_t length) {
+  if (writer.running) {writer.write(text, length);}
+  else {outputStream->write(text, length);}
+}
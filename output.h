@@ -13,33 +13,122 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <streambuf>
 #include <string>
 #include <stdlib.h>
-#include <map>
 #include <vector>
 
+#include "bgzf.h"
+#include "contig_dictionary.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+
 using namespace std;
 
 namespace vcfCTools {
 
+// The size of the blocks written to an uncompressed output file.
+#define OUTPUT_BLOCK_SIZE 1048576
+
+// Stream buffer that writes an uncompressed file (or the standard output)
+// with write(2) in large blocks.  As with the BGZF buffer, flushing the
+// stream does not write the block, so lines ended with endl do not each
+// cost a system call.  Writes that do not fit in the space left in the
+// block are written together with the block in a single writev(2).
+class fileOutputBuffer : public streambuf {
+  public:
+    fileOutputBuffer(void);
+    ~fileOutputBuffer(void);
+    bool open(string&);
+    void close();
+
+  protected:
+    int overflow(int);
+    streamsize xsputn(const char*, streamsize);
+    int sync();
+
+  public:
+    void writeBlock(const char*, size_t);
+
+  public:
+    int descriptor;
+    vector<char> block;
+};
+
+// The size of the chunks of text holding the buffered records.
+#define OUTPUT_CHUNK_SIZE 1048576
+
+// A record held in the output buffer.  The text of the record (including
+// the newline) is held in one of the buffer chunks.
+struct bufferedRecord {
+  int position;
+  size_t chunk;
+  size_t offset;
+  size_t length;
+};
+
+// A chunk of buffered text and the number of records in it that are
+// still to be written.
+struct bufferChunk {
+  string text;
+  size_t records;
+};
+
+// Order buffered records by position.
+struct earlierPosition {
+  bool operator()(const bufferedRecord& a, const bufferedRecord& b) const {return a.position < b.position;}
+};
+
 class output {
   public:
     output(void);
     ~output(void);
   public:
     ostream* openOutputFile(string&);
-    void flushToBuffer(int, string&);
+    void closeOutputFile();
+    void flushBefore(int);
+    void flushToBuffer(int, unsigned int);
     void flushOutputBuffer();
+    void startWriter();
+    void writeRecord(string&);
+    void writeText(const char*, size_t);
+
+  public:
+    void bufferRecord(int);
+    void releaseChunks();
+    void writeBuffer(size_t);
 
   public:
     ostream* outputStream;
-    string currentReferenceSequence;
+
+    // If the output file name ends in .gz, the output is BGZF compressed
+    // with the blocks deflated on a pool of worker threads.  Otherwise,
+    // the output is written in large blocks.
+    bgzfOutputBuffer compressedBuffer;
+    fileOutputBuffer fileBuffer;
+
+    // Records can be written out on a separate thread.
+    outputWriter writer;
+    unsigned int currentReferenceSequenceID;
     string outputRecord;
-    map<int, vector<string> > outputBuffer;
-    map<int, vector<string> >::iterator obIter;
-    vector<string>::iterator recordIter;
+
+    // Records are held in the buffer, sorted by position, until more
+    // than this many positions are held (no limit if zero), the
+    // reference sequence changes or they are flushed.  The text of the
+    // records is appended to large chunks, and the index holds the
+    // records in position order (records at the same position in the
+    // order they were added).  Records are written from the front of the
+    // index, and once all of the records in a chunk have been written,
+    // the chunk is kept for reuse.
+    unsigned int bufferPositions;
+    deque<bufferedRecord> bufferIndex;
+    deque<bufferChunk> bufferChunks;
+    deque<string> spareChunks;
+    size_t firstChunk;
+    size_t bufferedPositions;
 };
 
 } // namespace vcfCTools
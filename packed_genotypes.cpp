@@ -0,0 +1,153 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Hold the genotypes of all samples in a record as packed
+// bit planes and count them for each sample.
+// ******************************************************
+
+#include "packed_genotypes.h"
+
+using namespace std;
+using namespace vcfCTools;
+
+// The number of bits in each counter.  A plane can be added this many
+// times less one before the counters must be flushed.
+#define COUNTER_BITS 16
+
+// Constructor.
+packedGenotypes::packedGenotypes(void) {
+  numberSamples = 0;
+  numberWords   = 0;
+}
+
+// Destructor.
+packedGenotypes::~packedGenotypes(void) {}
+
+// Set the bit for a sample.
+void packedGenotypes::setBit(vector<uint64_t>& plane, unsigned int sample) {
+  plane[sample >> 6] |= (uint64_t) 1 << (sample & 63);
+}
+
+// Decode the GT field of every sample in the record into the planes.  Only
+// the GT and GQ fields are read.  The first two alleles determine the
+// genotype.
+void packedGenotypes::decode(genotypeColumns& view, vcfHeader& header, string& referenceSequence, int position, double minQuality, unsigned int numberAlts) {
+  bool isPhased, isUnphased;
+  stringSpan geno;
+
+  numberSamples = header.samples.size();
+  numberWords   = (numberSamples + 63) / 64;
+  missing.assign(numberWords, 0);
+  homRef.assign(numberWords, 0);
+  phased.assign(numberWords, 0);
+  het.resize(numberAlts + 1);
+  hom.resize(numberAlts + 1);
+  for (unsigned int i = 0; i <= numberAlts; i++) {
+    het[i].assign(numberWords, 0);
+    hom[i].assign(numberWords, 0);
+  }
+
+  int gtIndex = view.formatIndex("GT");
+  int gqIndex = view.formatIndex("GQ");
+  unsigned int numberFormats = view.formats.size();
+  for (unsigned int sample = 0; sample < numberSamples && view.findSample(sample); sample++) {
+    unsigned int numberFields = view.numberFields(sample);
+
+    // Check that the number of entries is consistent with the format string.
+    if (numberFields != numberFormats && numberFields != 1) {
+      cerr << "ERROR: Number of fields in the genotype string is inconsistent with the format for sample ";
+      cerr << header.samples[sample] << " at " << referenceSequence << ":" << position << "." << endl;
+      exit(1);
+    } else if (view.isMissing(sample)) {
+      setBit(missing, sample);
+      continue;
+    }
+    if (gqIndex != -1 && view.getDouble(sample, gqIndex) < minQuality) {continue;}
+
+    // Find the allele IDs from the genotype string.  This can be 0 for
+    // reference and then any number up to the number of alternate alleles.
+    if (!view.getField(sample, gtIndex, geno) || (geno.length == 1 && (*view.genotypes)[geno.start] == '.')) {
+      setBit(missing, sample);
+      continue;
+    }
+    view.getAlleles(geno, alleles, isPhased, isUnphased);
+    if (!isPhased && !isUnphased) {
+      cerr << "ERROR: Unknown genotype separator in sample " << header.samples[sample];
+      cerr << " at " << referenceSequence << ":" << position << "." << endl;
+      exit(1);
+    }
+    if (isPhased) {setBit(phased, sample);}
+
+    int idA = alleles[0];
+    int idB = alleles[1];
+    bool unknown = false;
+    for (vector<int>::iterator iter = alleles.begin(); iter != alleles.end(); iter++) {
+      if (*iter == -1) {unknown = true;}
+    }
+
+    // Alleles that are not in the record are ignored.
+    if (unknown) {setBit(missing, sample);}
+    else if (idA == 0 && idB == 0) {setBit(homRef, sample);}
+    else if (idA == idB) {
+      if ((unsigned int) idA <= numberAlts) {setBit(hom[idA], sample);}
+    } else if (idA == 0 || idB == 0) {
+      unsigned int id = (idA == 0) ? idB : idA;
+      if (id <= numberAlts) {setBit(het[id], sample);}
+    }
+  }
+}
+
+// Constructor.
+sampleCounter::sampleCounter(void) {
+  numberWords = 0;
+  pending     = 0;
+}
+
+// Destructor.
+sampleCounter::~sampleCounter(void) {}
+
+// Set the number of samples.  Any counts not yet flushed are kept.
+void sampleCounter::resize(unsigned int numberSamples) {
+  flush();
+  numberWords = (numberSamples + 63) / 64;
+  slices.assign(numberWords * COUNTER_BITS, 0);
+  totals.resize(numberSamples, 0);
+}
+
+// Add one to the counter of every sample with its bit set.  The counter
+// bits for each word of samples are stored together, lowest first, and
+// the carry is rippled up until no bits are left to carry.
+void sampleCounter::add(vector<uint64_t>& plane) {
+  for (unsigned int word = 0; word < numberWords; word++) {
+    uint64_t carry  = plane[word];
+    uint64_t* slice = &slices[word * COUNTER_BITS];
+    for (unsigned int bit = 0; carry != 0 && bit < COUNTER_BITS; bit++) {
+      uint64_t next = slice[bit] & carry;
+      slice[bit]   ^= carry;
+      carry         = next;
+    }
+  }
+  if (++pending == (1 << COUNTER_BITS) - 1) {flush();}
+}
+
+// Add the counters to the totals and reset them.
+void sampleCounter::flush() {
+  if (pending == 0) {return;}
+
+  for (unsigned int word = 0; word < numberWords; word++) {
+    uint64_t* slice = &slices[word * COUNTER_BITS];
+    for (unsigned int bit = 0; bit < COUNTER_BITS; bit++) {
+      uint64_t bits = slice[bit];
+      while (bits != 0) {
+        totals[word * 64 + __builtin_ctzll(bits)] += 1 << bit;
+        bits &= bits - 1;
+      }
+      slice[bit] = 0;
+    }
+  }
+  pending = 0;
+}
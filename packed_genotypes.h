@@ -0,0 +1,76 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Hold the genotypes of all samples in a record as packed
+// bit planes and count them for each sample.
+// ******************************************************
+
+#ifndef PACKED_GENOTYPES_H
+#define PACKED_GENOTYPES_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "genotype_columns.h"
+#include "header.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The genotypes of a record, indexed by sample ordinal.  Each plane holds
+// one bit per sample, 64 samples to a word.  A called diploid genotype is
+// homozygous reference, heterozygous with the reference or homozygous
+// alternate (the het and hom planes are kept for each alternate allele),
+// with a separate bit for phasing.  Samples with any unknown allele are
+// marked as missing.  Samples failing the genotype quality threshold and
+// heterozygotes with two alternate alleles have no bit set in any of the
+// genotype planes.
+class packedGenotypes {
+  public:
+    packedGenotypes(void);
+    ~packedGenotypes(void);
+    void decode(genotypeColumns&, vcfHeader&, string&, int, double, unsigned int);
+    void setBit(vector<uint64_t>&, unsigned int);
+
+  public:
+    unsigned int numberSamples;
+    unsigned int numberWords;
+    vector<uint64_t> missing;
+    vector<uint64_t> homRef;
+    vector<uint64_t> phased;
+    vector<vector<uint64_t> > het;
+    vector<vector<uint64_t> > hom;
+    vector<int> alleles;
+};
+
+// Count the number of times each sample's bit is set in a series of
+// planes.  The counts are held as bit sliced (vertical) counters, so
+// adding a plane updates 64 samples with a handful of word operations.
+// The counters are moved into the per sample totals before they can
+// overflow, or when the totals are needed.
+class sampleCounter {
+  public:
+    sampleCounter(void);
+    ~sampleCounter(void);
+    void resize(unsigned int);
+    void add(vector<uint64_t>&);
+    void flush();
+
+  public:
+    unsigned int numberWords;
+    unsigned int pending;
+    vector<uint64_t> slices;
+    vector<unsigned int> totals;
+};
+
+} // namespace vcfCTools
+
+#endif // PACKED_GENOTYPES_H
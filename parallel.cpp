@@ -0,0 +1,171 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Split an indexed vcf file into regions that can be
+// processed in parallel.
+// ******************************************************
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <map>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Order jobs with the largest first.
+static bool largerJob(const regionJob* a, const regionJob* b) {
+  return a->task.size > b->task.size;
+}
+
+// Constructor.
+regionJob::regionJob(void) {
+  index = NULL;
+}
+
+// Destructor.
+regionJob::~regionJob(void) {}
+
+// Open the file, restrict reading to the region and process the records.
+// The file is already being read on multiple threads, so the blocks are
+// inflated on this thread.
+void regionJob::run() {
+  vcf v;
+  vcfHeader header;
+  vector<genomicRegion> regionList(1, task.region);
+
+  v.decompressionThreads = 0;
+  v.openVcf(vcfFilename);
+  header.parseHeader(v.input);
+  v.minimumStart = task.minimumStart;
+  v.setRegions(regionList, index);
+  processRegion(header, v);
+  v.closeVcf();
+}
+
+// Constructor.
+parallelRegions::parallelRegions(void) {}
+
+// Destructor.
+parallelRegions::~parallelRegions(void) {}
+
+// Read the index for the file.  Regions can only be read independently
+// from BGZF compressed files with a tabix or CSI index, so if there is
+// no index, return false and the file will be processed on one thread.
+bool parallelRegions::openIndex(string& filename) {
+  vcfFilename = filename;
+  if (filename != "-" && bgzfInputBuffer::isCompressed(filename) && index.openIndex(filename)) {return true;}
+
+  cerr << "WARNING: Multiple threads require a BGZF compressed file with a tabix or CSI index.  " << filename;
+  cerr << " will be processed on a single thread." << endl;
+
+  return false;
+}
+
+// Build the list of tasks.  Each of the requested regions (or each
+// reference sequence in the index if no regions were requested) is a
+// task, unless a chunk size is given, in which case the regions are
+// split into chunks of this many bases.  The tasks are listed in file
+// order.
+void parallelRegions::buildTasks(string& regionString, int chunkSize) {
+  map<string, vector<genomicRegion> > requested;
+  vector<genomicRegion> regionList;
+
+  tasks.clear();
+  if (regionString != "") {vcf::parseRegions(regionString, regionList);}
+  else {
+    for (vector<string>::iterator iter = index.sequenceNames.begin(); iter != index.sequenceNames.end(); iter++) {
+      genomicRegion region;
+      region.referenceSequence = *iter;
+      region.start             = 1;
+      region.end               = INT_MAX;
+      regionList.push_back(region);
+    }
+  }
+  for (vector<genomicRegion>::iterator iter = regionList.begin(); iter != regionList.end(); iter++) {
+    requested[iter->referenceSequence].push_back(*iter);
+  }
+
+  // The reference sequences appear in the index in the order in which
+  // they appear in the file.  Reference sequences that are not in the
+  // index have no records.
+  for (vector<string>::iterator iter = index.sequenceNames.begin(); iter != index.sequenceNames.end(); iter++) {
+    map<string, vector<genomicRegion> >::iterator rIter = requested.find(*iter);
+    if (rIter == requested.end()) {continue;}
+
+    // Records overlapping two requested regions belong to the first.
+    vcf::mergeRegions(rIter->second);
+    int previousEnd = 0;
+    for (vector<genomicRegion>::iterator regionIter = rIter->second.begin(); regionIter != rIter->second.end(); regionIter++) {
+      addTasks(*regionIter, previousEnd + 1, chunkSize);
+      previousEnd = regionIter->end;
+    }
+  }
+}
+
+// Add the tasks for a single region.  Only the first chunk includes the
+// records that start before the region.  Regions running to the end of
+// the reference sequence are split up to the last position in the index.
+void parallelRegions::addTasks(genomicRegion& region, int minimumStart, int chunkSize) {
+  int64_t end   = region.end;
+  int64_t start = region.start;
+
+  if (chunkSize > 0 && region.end == INT_MAX) {
+    end = max(start, (int64_t) index.sequenceLength(index.sequenceIDs[region.referenceSequence]));
+  }
+
+  while (true) {
+    regionTask task;
+    bool lastChunk = chunkSize <= 0 || start + chunkSize > end;
+
+    task.region       = region;
+    task.region.start = (int) start;
+    task.minimumStart = (start == region.start) ? minimumStart : (int) start;
+    if (!lastChunk) {task.region.end = (int) (start + chunkSize - 1);}
+    task.size = estimateSize(task.region);
+    tasks.push_back(task);
+
+    if (lastChunk) {break;}
+    start += chunkSize;
+  }
+}
+
+// Estimate the size of a region from the compressed data covered by the
+// index chunks.
+uint64_t parallelRegions::estimateSize(genomicRegion& region) {
+  vector<indexChunk> chunks;
+  uint64_t size = 0;
+
+  index.query(region, chunks);
+  for (vector<indexChunk>::iterator iter = chunks.begin(); iter != chunks.end(); iter++) {
+    size += (iter->end >> 16) - (iter->start >> 16) + 1;
+  }
+
+  return size;
+}
+
+// Start the jobs (one for each task, in the same order) on a pool of
+// threads.
+void parallelRegions::start(vector<regionJob*>& jobs, unsigned int threads) {
+  vector<regionJob*> order = jobs;
+
+  for (unsigned int i = 0; i < jobs.size(); i++) {
+    jobs[i]->vcfFilename = vcfFilename;
+    jobs[i]->task        = tasks[i];
+    jobs[i]->index       = &index;
+  }
+  stable_sort(order.begin(), order.end(), largerJob);
+
+  pool.startThreads(threads);
+  for (vector<regionJob*>::iterator iter = order.begin(); iter != order.end(); iter++) {pool.submit(*iter);}
+}
+
+// Wait for a job to complete.
+void parallelRegions::waitFor(regionJob* job) {
+  pool.waitFor(job);
+}
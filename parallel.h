@@ -0,0 +1,88 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Split an indexed vcf file into regions that can be
+// processed in parallel.
+// ******************************************************
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "header.h"
+#include "tabix.h"
+#include "thread_pool.h"
+#include "vcf.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// A region of the file to be processed as a single task.  Records that
+// start before minimumStart belong to the preceding task, so each record
+// is processed exactly once.  The size is an estimate of the amount of
+// compressed data in the region, used to schedule the largest tasks
+// first.
+struct regionTask {
+  genomicRegion region;
+  int minimumStart;
+  uint64_t size;
+};
+
+// A job processing the records in a single region.  Each job opens its
+// own copy of the file and reads its own header, so the jobs share
+// nothing but the (read only) index.  Anything written to the records
+// and errors streams is kept until the job is collected, so that the
+// results can be written out in file order.
+class regionJob : public threadJob {
+  public:
+    regionJob(void);
+    virtual ~regionJob(void);
+    void run();
+    virtual void processRegion(vcfHeader&, vcf&) = 0;
+
+  public:
+    string vcfFilename;
+    regionTask task;
+    tabixIndex* index;
+    ostringstream records;
+    ostringstream errors;
+};
+
+// Define the class used to run region jobs.  The regions are either those
+// given on the command line or each reference sequence in the index, and
+// can be split into chunks of a fixed size.  Jobs are taken from a shared
+// queue by whichever thread is free, so the largest regions are submitted
+// first to stop a large reference sequence being left until last.
+class parallelRegions {
+  public:
+    parallelRegions(void);
+    ~parallelRegions(void);
+    bool openIndex(string&);
+    void buildTasks(string&, int);
+    void start(vector<regionJob*>&, unsigned int);
+    void waitFor(regionJob*);
+
+  public:
+    void addTasks(genomicRegion&, int, int);
+    uint64_t estimateSize(genomicRegion&);
+
+  public:
+    string vcfFilename;
+    tabixIndex index;
+    vector<regionTask> tasks;
+    threadPool pool;
+};
+
+} // namespace vcfCTools
+
+#endif // PARALLEL_H
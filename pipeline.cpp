@@ -0,0 +1,174 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Queues and threads used to read input and write output
+// while the records are being processed.
+// ******************************************************
+
+#include "pipeline.h"
+#include "vcf.h"
+
+#include <cstdlib>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// The number of lines read into each batch and the size of the blocks of
+// output text passed to the writer.
+#define PIPELINE_BATCH_LINES 1024
+#define PIPELINE_BLOCK_SIZE 65536
+
+// Wait for another thread to make progress.  Most waits are short, so
+// first yield to the other threads, then sleep for up to a millisecond.
+void vcfCTools::pipelineWait(unsigned int& spins) {
+  if (spins < 64) {sched_yield();}
+  else {usleep((spins < 1024) ? spins : 1024);}
+  spins++;
+}
+
+// The function run by the reader thread.  Read batches of lines until the
+// end of the file (or region) is reached or the reader is stopped.
+static void* runReader(void* arg) {
+  lineReader* reader = (lineReader*) arg;
+  lineBatch batch;
+
+  while (true) {
+    batch.size = 0;
+    while (batch.size < PIPELINE_BATCH_LINES) {
+      if (batch.lines.size() == batch.size) {batch.lines.push_back(string());}
+      if (!reader->file->readLine(batch.lines[batch.size])) {break;}
+      batch.size++;
+    }
+    bool finished = batch.size < PIPELINE_BATCH_LINES;
+    if (batch.size != 0 && !reader->queue.push(batch)) {break;}
+    if (finished) {break;}
+  }
+  reader->queue.close();
+
+  return NULL;
+}
+
+// Constructor.
+lineReader::lineReader(void) {
+  currentLine = 0;
+  file        = NULL;
+  running     = false;
+  batch.size  = 0;
+}
+
+// Destructor.
+lineReader::~lineReader(void) {
+  stop();
+}
+
+// Start reading the file on the reader thread.
+void lineReader::start(vcf* v) {
+  stop();
+  file        = v;
+  currentLine = 0;
+  batch.size  = 0;
+  queue.reset();
+  if (pthread_create(&thread, NULL, runReader, this) != 0) {
+    cerr << "ERROR: Unable to create reader thread." << endl;
+    exit(1);
+  }
+  running = true;
+}
+
+// Stop the reader thread.  If the file has not been read to the end, the
+// queue is cancelled so that the reader does not wait for space.
+void lineReader::stop() {
+  if (!running) {return;}
+  queue.cancel();
+  pthread_join(thread, NULL);
+  running = false;
+}
+
+// Get the next line.  The line is swapped out of the batch, so the
+// storage of the previous line is reused by the reader.
+bool lineReader::getLine(string& line) {
+  if (currentLine == batch.size) {
+    if (!queue.pop(batch)) {return false;}
+    currentLine = 0;
+  }
+  line.swap(batch.lines[currentLine++]);
+
+  return true;
+}
+
+// The function run by the writer thread.  Write blocks of text until
+// the writer is stopped.
+static void* runWriter(void* arg) {
+  outputWriter* writer = (outputWriter*) arg;
+  string block;
+
+  while (writer->queue.pop(block)) {
+    writer->stream->write(block.data(), block.size());
+    block.clear();
+  }
+  writer->stream->flush();
+
+  return NULL;
+}
+
+// Constructor.
+outputWriter::outputWriter(void) {
+  running = false;
+  stream  = NULL;
+}
+
+// Destructor.
+outputWriter::~outputWriter(void) {
+  stop();
+}
+
+// Start writing to the stream on the writer thread.  Nothing else can
+// write to the stream until the writer is stopped.
+void outputWriter::start(ostream* output) {
+  stop();
+  stream = output;
+  block.clear();
+  block.reserve(PIPELINE_BLOCK_SIZE + 1024);
+  queue.reset();
+  if (pthread_create(&thread, NULL, runWriter, this) != 0) {
+    cerr << "ERROR: Unable to create writer thread." << endl;
+    exit(1);
+  }
+  running = true;
+}
+
+// Write out the last block and wait for the writer to finish.
+void outputWriter::stop() {
+  if (!running) {return;}
+  if (block.size() != 0) {queue.push(block);}
+  queue.close();
+  pthread_join(thread, NULL);
+  block.clear();
+  running = false;
+}
+
+// Add a line of text to the current block, passing the block to the writer
+// once it is full.
+void outputWriter::write(string& line) {
+  block += line;
+  block += '\n';
+  if (block.size() >= PIPELINE_BLOCK_SIZE) {
+    queue.push(block);
+    block.clear();
+  }
+}
+
+// Add text (already ended with a newline) to the current block.
+void outputWriter::write(const char* text, size_t length) {
+  block.append(text, length);
+  if (block.size() >= PIPELINE_BLOCK_SIZE) {
+    queue.push(block);
+    block.clear();
+  }
+}
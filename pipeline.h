@@ -0,0 +1,175 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define the queues and threads used to read input and
+// write output while the records are being processed.
+// ******************************************************
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace vcfCTools {
+
+class vcf;
+
+// Wait for another thread to make progress, yielding at first and then
+// sleeping for progressively longer.
+void pipelineWait(unsigned int&);
+
+// A batch of lines read from a file.
+struct lineBatch {
+  vector<string> lines;
+  unsigned int size;
+};
+
+// Exchange two batches without copying the lines.
+inline void swap(lineBatch& a, lineBatch& b) {
+  a.lines.swap(b.lines);
+  std::swap(a.size, b.size);
+}
+
+// A bounded queue with a single producer thread and a single consumer
+// thread.  The producer only moves the tail and the consumer only moves
+// the head, so no lock is needed.  Items are swapped in and out of the
+// slots rather than copied, so the consumer hands back the storage of
+// the items it has finished with for the producer to reuse.
+//
+// The producer closes the queue when there are no more items.  The
+// consumer can cancel the queue if it stops early, so that a producer
+// waiting for space gives up.
+template <class T>
+class boundedQueue {
+  public:
+    boundedQueue(void) : slots(8), head(0), tail(0), closed(false), cancelled(false) {}
+
+    // Reset the queue so that it can be used again.
+    void reset() {
+      head      = 0;
+      tail      = 0;
+      closed    = false;
+      cancelled = false;
+    }
+
+    bool tryPush(T& item) {
+      using std::swap;
+      if (tail - head == slots.size()) {return false;}
+      swap(slots[tail % slots.size()], item);
+      __sync_synchronize();
+      tail = tail + 1;
+
+      return true;
+    }
+
+    bool tryPop(T& item) {
+      using std::swap;
+      if (tail == head) {return false;}
+      __sync_synchronize();
+      swap(slots[head % slots.size()], item);
+      __sync_synchronize();
+      head = head + 1;
+
+      return true;
+    }
+
+    // Add an item, waiting for space if the queue is full.  Returns false
+    // if the consumer has cancelled the queue.
+    bool push(T& item) {
+      unsigned int spins = 0;
+      while (!tryPush(item)) {
+        if (cancelled) {return false;}
+        pipelineWait(spins);
+      }
+
+      return true;
+    }
+
+    // Remove an item, waiting if the queue is empty.  Returns false once
+    // the queue is closed and all items have been removed.
+    bool pop(T& item) {
+      unsigned int spins = 0;
+      while (!tryPop(item)) {
+        if (closed) {
+          __sync_synchronize();
+          return tryPop(item);
+        }
+        pipelineWait(spins);
+      }
+
+      return true;
+    }
+
+    void close() {
+      __sync_synchronize();
+      closed = true;
+    }
+
+    void cancel() {
+      cancelled = true;
+      __sync_synchronize();
+    }
+
+  public:
+    vector<T> slots;
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    volatile bool closed;
+    volatile bool cancelled;
+};
+
+// Read the lines of a vcf file on a separate thread.  The lines are read
+// in batches, so the queue is only touched once for many records.  Once
+// the reader is started, all reading (including seeking to the chunks of
+// indexed files) is done by the reader thread.
+class lineReader {
+  public:
+    lineReader(void);
+    ~lineReader(void);
+    void start(vcf*);
+    void stop();
+    bool getLine(string&);
+
+  public:
+    vcf* file;
+    pthread_t thread;
+    bool running;
+    boundedQueue<lineBatch> queue;
+    lineBatch batch;
+    unsigned int currentLine;
+};
+
+// Write the output on a separate thread.  Records are collected into
+// blocks of text, which are written to the output stream in order by
+// the writer thread.
+class outputWriter {
+  public:
+    outputWriter(void);
+    ~outputWriter(void);
+    void start(ostream*);
+    void stop();
+    void write(string&);
+    void write(const char*, size_t);
+
+  public:
+    ostream* stream;
+    pthread_t thread;
+    bool running;
+    boundedQueue<string> queue;
+    string block;
+};
+
+} // namespace vcfCTools
+
+#endif // PIPELINE_H
@@ -0,0 +1,172 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define a position ordered ring buffer used to hold
+// the variants in a sliding window over a sorted file.
+// ******************************************************
+
+#ifndef POSITION_BUFFER_H
+#define POSITION_BUFFER_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace vcfCTools {
+
+// A ring buffer of (position, value) pairs kept in position order.  This
+// replaces a map<int, T> for the variant structures.  Since the vcf file
+// is sorted, new positions are almost always appended to the back and
+// positions are removed from the front, both of which are constant time.
+// Positions that arrive out of order (e.g. indels that are moved to an
+// earlier position when the alleles are trimmed) are inserted in place.
+//
+// The slots are reused rather than freed: an erased entry is cleared
+// and left in the ring, so the memory held by the entries is recycled
+// instead of being returned to the heap.  T must provide clear() and
+// swap(), so that entries can be emptied and moved without copying.
+//
+// Iterators refer to a position in the window (an offset from the front)
+// rather than to an element, so unlike map iterators they are invalidated
+// by any insertion before them or erasure.  Iterators should be reset
+// (e.g. to begin()) after the buffer is modified.
+template <class T>
+class positionBuffer {
+  public:
+    typedef pair<int, T> value_type;
+
+    class iterator {
+      public:
+        iterator(void) : buffer(NULL), index(0) {}
+        iterator(positionBuffer* b, size_t i) : buffer(b), index(i) {}
+        value_type& operator*() const {return buffer->at(index);}
+        value_type* operator->() const {return &buffer->at(index);}
+        iterator& operator++() {index++; return *this;}
+        iterator operator++(int) {iterator old = *this; index++; return old;}
+        iterator& operator--() {index--; return *this;}
+        iterator operator--(int) {iterator old = *this; index--; return old;}
+        bool operator==(const iterator& other) const {return buffer == other.buffer && index == other.index;}
+        bool operator!=(const iterator& other) const {return !(*this == other);}
+
+      public:
+        positionBuffer* buffer;
+        size_t index;
+    };
+
+  public:
+    positionBuffer(void) : slots(16), head(0), length(0), mask(15) {}
+
+    iterator begin() {return iterator(this, 0);}
+    iterator end() {return iterator(this, length);}
+    size_t size() const {return length;}
+    bool empty() const {return length == 0;}
+
+    // The entry at the given offset from the front of the window.
+    value_type& at(size_t index) {return slots[(head + index) & mask];}
+
+    // Return the entry for a position, creating an empty entry if none
+    // exists (as map::operator[]).
+    T& operator[](int position) {
+      if (length == 0 || position > at(length - 1).first) {return insertAt(length, position);}
+      if (position == at(length - 1).first) {return at(length - 1).second;}
+
+      size_t index = lowerBound(position);
+      if (at(index).first == position) {return at(index).second;}
+
+      return insertAt(index, position);
+    }
+
+    // Find the entry for a position, returning end() if none exists.
+    iterator find(int position) {
+      if (length == 0) {return end();}
+      size_t index = lowerBound(position);
+
+      return (index < length && at(index).first == position) ? iterator(this, index) : end();
+    }
+
+    size_t count(int position) {return find(position) == end() ? 0 : 1;}
+
+    // Remove an entry.  Removing the front entry (the usual case) is
+    // constant time.
+    void erase(iterator iter) {
+      if (iter.index >= length) {return;}
+      at(iter.index).second.clear();
+      if (iter.index == 0) {
+        head = (head + 1) & mask;
+      } else {
+        for (size_t i = iter.index; i + 1 < length; i++) {swapEntries(at(i), at(i + 1));}
+      }
+      length--;
+    }
+
+    void pop_front() {erase(begin());}
+
+    // Remove all entries.
+    void clear() {
+      for (size_t i = 0; i < length; i++) {at(i).second.clear();}
+      head   = 0;
+      length = 0;
+    }
+
+  public:
+
+    // Exchange two entries without copying the values.
+    static void swapEntries(value_type& a, value_type& b) {
+      std::swap(a.first, b.first);
+      a.second.swap(b.second);
+    }
+
+    // The offset of the first entry with a position not less than the
+    // given position.
+    size_t lowerBound(int position) {
+      size_t low  = 0;
+      size_t high = length;
+      while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (at(middle).first < position) {low = middle + 1;}
+        else {high = middle;}
+      }
+
+      return low;
+    }
+
+    // Create an empty entry at the given offset.  The free slot at the back
+    // (or front) of the ring is swapped into place.
+    T& insertAt(size_t index, int position) {
+      if (length == slots.size()) {grow();}
+      if (index == 0 && length != 0) {
+        head = (head + mask) & mask;
+      } else {
+        for (size_t i = length; i > index; i--) {swapEntries(at(i), at(i - 1));}
+      }
+      length++;
+      at(index).first = position;
+
+      return at(index).second;
+    }
+
+    // Double the size of the ring, keeping the entries in order.
+    void grow() {
+      vector<value_type> larger(slots.size() * 2);
+      for (size_t i = 0; i < length; i++) {swapEntries(larger[i], at(i));}
+      slots.swap(larger);
+      head = 0;
+      mask = slots.size() - 1;
+    }
+
+  public:
+    vector<value_type> slots;
+    size_t head;
+    size_t length;
+    size_t mask;
+};
+
+} // namespace vcfCTools
+
+#endif // POSITION_BUFFER_H
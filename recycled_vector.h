@@ -0,0 +1,81 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define a vector that keeps its elements when cleared,
+// so that their memory is reused.
+// ******************************************************
+
+#ifndef RECYCLED_VECTOR_H
+#define RECYCLED_VECTOR_H
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace vcfCTools {
+
+// A vector whose elements are not destroyed when they are removed.
+// Clearing the vector only resets its length, and elements added later
+// are assigned over the old ones, so the strings and vectors inside them
+// reuse the memory they already hold rather than going back to the heap.
+// The variant structures are held in a positionBuffer of these, so once a
+// window of the file has been read, the records in later windows are
+// built in the memory of the earlier ones and releasing a locus is a
+// single reset.
+//
+// The iterators are those of the underlying vector.  Elements beyond the
+// length hold old values and must be fully overwritten when reused.
+template <class T>
+class recycledVector {
+  public:
+    typedef typename vector<T>::iterator iterator;
+    typedef typename vector<T>::const_iterator const_iterator;
+
+  public:
+    recycledVector(void) : length(0) {}
+
+    iterator begin() {return elements.begin();}
+    iterator end() {return elements.begin() + length;}
+    const_iterator begin() const {return elements.begin();}
+    const_iterator end() const {return elements.begin() + length;}
+    size_t size() const {return length;}
+    bool empty() const {return length == 0;}
+
+    T& operator[](size_t index) {return elements[index];}
+    const T& operator[](size_t index) const {return elements[index];}
+    T& front() {return elements[0];}
+    T& back() {return elements[length - 1];}
+
+    // Add an element to the back and return it.  An old element is reused
+    // if there is one, otherwise a new one is created.
+    T& push_back() {
+      if (length == elements.size()) {elements.push_back(T());}
+
+      return elements[length++];
+    }
+
+    // Copy a value to the back, assigning over an old element.
+    void push_back(const T& value) {push_back() = value;}
+
+    // Remove all elements, keeping them for reuse.
+    void clear() {length = 0;}
+
+    // Exchange the contents with another vector.
+    void swap(recycledVector& other) {
+      elements.swap(other.elements);
+      std::swap(length, other.length);
+    }
+
+  public:
+    vector<T> elements;
+    size_t length;
+};
+
+} // namespace vcfCTools
+
+#endif // RECYCLED_VECTOR_H
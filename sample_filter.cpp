@@ -0,0 +1,231 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Apply sample level filters (e.g. setting genotypes with
+// low quality to missing) to the genotypes of a record.
+// ******************************************************
+
+#include "sample_filter.h"
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Get the allele ID at the start of a genotype, moving the start past the
+// allele.  An unknown allele ('.') has the ID -1.
+static int parseAllele(const char*& start, const char* end) {
+  int allele   = 0;
+  bool unknown = false;
+  for (; start != end && *start != '/' && *start != '|'; start++) {
+    if (*start == '.') {unknown = true;}
+    else if (*start >= '0' && *start <= '9') {allele = 10 * allele + (*start - '0');}
+  }
+
+  return unknown ? -1 : allele;
+}
+
+// Get a numeric field as a float.  Plain decimals are converted directly,
+// anything else with strtod.  Missing or malformed values are infinite.
+static float parseValue(const char* start, const char* end) {
+  if (start == end) {return numeric_limits<float>::infinity();}
+
+  const char* c  = start;
+  bool negative  = (*c == '-');
+  if (negative) {c++;}
+  double value   = 0.;
+  double scale   = 1.;
+  bool hasDigits = false;
+  for (; c != end && *c >= '0' && *c <= '9'; c++) {
+    value     = 10. * value + (*c - '0');
+    hasDigits = true;
+  }
+  if (c != end && *c == '.') {
+    for (c++; c != end && *c >= '0' && *c <= '9'; c++) {
+      value     = 10. * value + (*c - '0');
+      scale    *= 10.;
+      hasDigits = true;
+    }
+  }
+  if (hasDigits && (c == end || *c == ',')) {return (float) ((negative ? -value : value) / scale);}
+
+  char* stop;
+  value = strtod(start, &stop);
+  if (stop == start || (stop != end && *stop != ',')) {return numeric_limits<float>::infinity();}
+
+  return (float) value;
+}
+
+// Constructor.
+sampleFilter::sampleFilter(void) {
+  checkNonReference = false;
+  maskLowGenotypes  = false;
+  minDepth          = 0.;
+  minQuality        = 0.;
+  numberSamples     = 0;
+}
+
+// Destructor.
+sampleFilter::~sampleFilter(void) {}
+
+// Set the samples of which at least one must have a non-reference allele.
+void sampleFilter::setSamples(vector<unsigned int>& samples) {
+  requiredSamples = samples;
+  sort(requiredSamples.begin(), requiredSamples.end());
+  checkNonReference = true;
+}
+
+// Apply the filters to a record, rewriting the genotypes if any are
+// masked.  Returns false if the record should be removed.
+bool sampleFilter::filterGenotypes(originalVariants& ov) {
+  if (!ov.hasGenotypes) {return !checkNonReference;}
+
+  decode(ov);
+  if (maskLowGenotypes && maskGenotypes() != 0) {rewriteGenotypes(ov);}
+
+  return !checkNonReference || hasNonReference();
+}
+
+// Decode the GT, GQ and DP fields of the samples.  All samples are
+// decoded if genotypes are being masked, otherwise only the required
+// samples are.  The genotype string is read in a single pass, and each
+// sample is only read as far as the last of the three fields.
+void sampleFilter::decode(originalVariants& ov) {
+  view.setRecord(ov.genotypeFormat, ov.genotypes);
+  gtIndex      = view.formatIndex("GT");
+  gqIndex      = view.formatIndex("GQ");
+  dpIndex      = view.formatIndex("DP");
+  maxIndex     = max(gtIndex, max(gqIndex, dpIndex));
+
+  const char* data  = ov.genotypes.c_str();
+  const char* end   = data + ov.genotypes.size();
+  const char* start = data;
+  unsigned int ordinal = 0;
+  numberSamples = 0;
+  while (maskLowGenotypes || numberSamples < requiredSamples.size()) {
+    const char* tab = NULL;
+    if (maskLowGenotypes || ordinal == requiredSamples[numberSamples]) {
+      if (numberSamples == alleleA.size()) {
+        unsigned int size = (numberSamples == 0) ? 64 : 2 * numberSamples;
+        genotypeFields.resize(size);
+        alleleA.resize(size);
+        alleleB.resize(size);
+        quality.resize(size);
+        depth.resize(size);
+        masked.resize(size);
+      }
+
+      unsigned int i = numberSamples++;
+      alleleA[i] = -1;
+      alleleB[i] = -2;
+      quality[i] = numeric_limits<float>::infinity();
+      depth[i]   = numeric_limits<float>::infinity();
+      genotypeFields[i].start  = 0;
+      genotypeFields[i].length = 0;
+
+      // Read the fields up to the last one needed.  The end of the sample
+      // is found at the same time if the last field is reached.
+      const char* field = start;
+      const char* c     = start;
+      int index         = 0;
+      while (true) {
+        if (c == end || *c == '\t' || *c == ':') {
+          decodeField(i, index, data, field, c);
+          if (c == end || *c == '\t' || ++index > maxIndex) {break;}
+          field = c + 1;
+        }
+        c++;
+      }
+      if (c == end || *c == '\t') {tab = c;}
+    }
+    if (tab == NULL) {tab = (const char*) memchr(start, '\t', end - start);}
+    if (tab == NULL) {tab = end;}
+
+    ordinal++;
+    if (tab == end) {break;}
+    start = tab + 1;
+  }
+}
+
+// Decode a field of a sample if it is one of GT, GQ or DP.
+void sampleFilter::decodeField(unsigned int i, int index, const char* data, const char* field, const char* stop) {
+  if (index == gtIndex) {
+    genotypeFields[i].start  = field - data;
+    genotypeFields[i].length = stop - field;
+    alleleA[i] = parseAllele(field, stop);
+    if (field != stop) {
+      field++;
+      alleleB[i] = parseAllele(field, stop);
+    }
+  } else if (index == gqIndex) {
+    quality[i] = parseValue(field, stop);
+  } else if (index == dpIndex) {
+    depth[i] = parseValue(field, stop);
+  }
+}
+
+// Mark the called genotypes with a quality or depth below the thresholds,
+// and make their alleles unknown.  The loop has no branches, so it can be
+// vectorised.  The number of masked genotypes is returned.
+unsigned int sampleFilter::maskGenotypes() {
+  if (numberSamples == 0) {return 0;}
+
+  const float* q   = &quality[0];
+  const float* d   = &depth[0];
+  int* a           = &alleleA[0];
+  int* b           = &alleleB[0];
+  unsigned char* m = &masked[0];
+  unsigned int count = 0;
+  for (unsigned int i = 0; i < numberSamples; i++) {
+    unsigned char low    = (q[i] < minQuality) | (d[i] < minDepth);
+    unsigned char called = (a[i] >= 0) | (b[i] >= 0);
+    m[i]   = low & called;
+    a[i]   = m[i] ? -1 : a[i];
+    b[i]   = (m[i] & (b[i] != -2)) ? -1 : b[i];
+    count += m[i];
+  }
+
+  return count;
+}
+
+// Check if any of the required samples has a non-reference allele.
+bool sampleFilter::hasNonReference() {
+  unsigned char found = 0;
+
+  // If all samples were decoded, the required samples are found by their
+  // ordinals, otherwise only the required samples were decoded.
+  if (maskLowGenotypes) {
+    for (vector<unsigned int>::iterator iter = requiredSamples.begin(); iter != requiredSamples.end(); iter++) {
+      if (*iter < numberSamples) {found |= (alleleA[*iter] > 0) | (alleleB[*iter] > 0);}
+    }
+  } else if (numberSamples != 0) {
+    const int* a = &alleleA[0];
+    const int* b = &alleleB[0];
+    for (unsigned int i = 0; i < numberSamples; i++) {found |= (a[i] > 0) | (b[i] > 0);}
+  }
+
+  return found != 0;
+}
+
+// Replace the GT field of the masked samples with a missing genotype.
+// The rest of the genotype string is copied unchanged.
+void sampleFilter::rewriteGenotypes(originalVariants& ov) {
+  modifiedGenotypes.clear();
+  modifiedGenotypes.reserve(ov.genotypes.size());
+
+  size_t copied = 0;
+  for (unsigned int i = 0; i < numberSamples; i++) {
+    if (!masked[i]) {continue;}
+    modifiedGenotypes.append(ov.genotypes, copied, genotypeFields[i].start - copied);
+    modifiedGenotypes += (alleleB[i] == -2) ? "." : "./.";
+    copied = genotypeFields[i].start + genotypeFields[i].length;
+  }
+  modifiedGenotypes.append(ov.genotypes, copied, string::npos);
+  ov.genotypes.swap(modifiedGenotypes);
+}
@@ -0,0 +1,81 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Apply sample level filters (e.g. setting genotypes with
+// low quality to missing) to the genotypes of a record.
+// ******************************************************
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "genotype_columns.h"
+#include "variant.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+// The GT, GQ and DP fields of the samples being filtered are decoded into
+// separate arrays (one entry per sample), so that the filters are simple
+// loops over the arrays.  Genotypes are held as the IDs of the first two
+// alleles (-1 for an unknown allele and -2 for an absent second allele).
+// Missing qualities and depths are infinite, so they never fail a
+// threshold.  The arrays are reused for every record.
+class sampleFilter {
+  public:
+    sampleFilter(void);
+    ~sampleFilter(void);
+    void setSamples(vector<unsigned int>&);
+    bool filterGenotypes(originalVariants&);
+
+  private:
+    void decode(originalVariants&);
+    void decodeField(unsigned int, int, const char*, const char*, const char*);
+    unsigned int maskGenotypes();
+    bool hasNonReference();
+    void rewriteGenotypes(originalVariants&);
+
+  public:
+
+    // Genotypes with a quality or depth below these values are set to
+    // missing when masking.
+    bool maskLowGenotypes;
+    float minQuality;
+    float minDepth;
+
+    // The samples (by ordinal) of which at least one must have a
+    // non-reference allele for the record to be kept.
+    bool checkNonReference;
+    vector<unsigned int> requiredSamples;
+
+  private:
+    genotypeColumns view;
+    string modifiedGenotypes;
+    int gtIndex;
+    int gqIndex;
+    int dpIndex;
+    int maxIndex;
+
+    // The decoded samples: the position of their GT field in the genotype
+    // string and the decoded values.  The arrays only grow, so only the
+    // first numberSamples entries belong to the current record.
+    unsigned int numberSamples;
+    vector<stringSpan> genotypeFields;
+    vector<int> alleleA;
+    vector<int> alleleB;
+    vector<float> quality;
+    vector<float> depth;
+    vector<unsigned char> masked;
+};
+
+} // namespace vcfCTools
+
+#endif // SAMPLE_FILTER_H
@@ -15,6 +15,7 @@ using namespace vcfCTools;
 
 // Constructor
 samples::samples(void) {
+  input     = NULL;
   noSamples = 0;
 };
 
@@ -30,14 +31,28 @@ bool samples::openSamplesFile(string& filename) {
     cerr << "Failed to open file: " << samplesFilename << endl;
     exit(1);
   }
+
+  return true;
+}
+
+// Add samples from a comma separated list.
+void samples::addSamples(const string& list) {
+  vector<string> names = split(list, ',');
+  for (vector<string>::iterator iter = names.begin(); iter != names.end(); iter++) {
+    if (*iter == "" || samplesMap.count(*iter) != 0) {continue;}
+    samplesMap[*iter] = -1;
+    noSamples++;
+  }
 }
 
-//
-void samples::getSamples(vcf& v) {
+// Read the samples from the file (if one was opened) and find the
+// positions of all of the samples in the header.
+void samples::getSamples(vcfHeader& header) {
   string sampleName;
 
   // Get the samples from the input file.
-  while (getline(*input, sampleName)) {
+  while (input != NULL && getline(*input, sampleName)) {
+    if (sampleName == "" || samplesMap.count(sampleName) != 0) {continue;}
     samplesMap[sampleName] = -1;
     noSamples++;
   }
@@ -46,7 +61,7 @@ void samples::getSamples(vcf& v) {
   // appears in the map, set the value equal to the position of this
   // sample in the list of genotype strings.
   unsigned int count = 0;
-  for (vector<string>::iterator iter = v.samples.begin(); iter != v.samples.end(); iter++) {
+  for (vector<string>::iterator iter = header.samples.begin(); iter != header.samples.end(); iter++) {
     if (samplesMap.count(*iter) > 0) {samplesMap[*iter] = count;}
     count++;
   }
@@ -55,11 +70,14 @@ void samples::getSamples(vcf& v) {
   // any that are not present in the vcf file.  If the map value is
   // -1 this indicates that it was not seen in the list of samples
   // from the vcf file.
-  for (map<string, int>::iterator iter = samplesMap.begin(); iter != samplesMap.end(); iter++) {
+  map<string, int>::iterator iter = samplesMap.begin();
+  while (iter != samplesMap.end()) {
     if (iter->second == -1) {
       cerr << "WARNING: Sample " << iter->first << " is not present in the vcf file." << endl;
-      samplesMap.erase(iter);
+      samplesMap.erase(iter++);
       noSamples--;
+    } else {
+      iter++;
     }
   }
 }
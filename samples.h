@@ -20,7 +20,8 @@
 #include <map>
 #include <vector>
 
-#include "vcf.h"
+#include "header.h"
+#include "split.h"
 
 using namespace std;
 
@@ -31,7 +32,8 @@ class samples {
     samples(void);
     ~samples(void);
     bool openSamplesFile(string&);
-    void getSamples(vcf&);
+    void addSamples(const string&);
+    void getSamples(vcfHeader&);
 
   public:
     string samplesFilename;
@@ -57,16 +57,42 @@ std::vector<std::string> split(const std::string &s, char delim, int n) {
     return split(s, delim, elems, n);
 }
 
-// Split on entries in a delimeter string.
+// Record the offsets of the fields rather than copying them.  Only split the
+// first n - 1 times.
+unsigned int splitSpans(const std::string &s, char delim, std::vector<stringSpan> &spans, unsigned int n) {
+    const char* begin = s.data();
+    const char* end   = begin + s.size();
+    const char* start = begin;
+    unsigned int count = 0;
+
+    if (n == 0) {return 0;}
+    if (spans.size() < n) {spans.resize(n);}
+    while (count + 1 < n) {
+        const char* next = (const char*) memchr(start, delim, end - start);
+        if (next == NULL) {break;}
+        spans[count].start  = start - begin;
+        spans[count].length = next - start;
+        start = next + 1;
+        count++;
+    }
+    spans[count].start  = start - begin;
+    spans[count].length = end - start;
+
+    return count + 1;
+}
+
+// Split on entries in a delimeter string.  The reentrant strtok_r is
+// used, so that records can be split on multiple threads.
 std::vector<std::string> &split(const std::string &s, const std::string& delims, std::vector<std::string> &elems) {
     char* tok;
+    char* save;
     char cchars [s.size()+1];
     char* cstr = &cchars[0];
     strcpy(cstr, s.c_str());
-    tok = strtok(cstr, delims.c_str());
+    tok = strtok_r(cstr, delims.c_str(), &save);
     while (tok != NULL) {
         elems.push_back(tok);
-        tok = strtok(NULL, delims.c_str());
+        tok = strtok_r(NULL, delims.c_str(), &save);
     }
     return elems;
 }
@@ -26,6 +26,19 @@ std::vector<std::string>  split(const std::string &s, char delim);
 std::vector<std::string>& split(const std::string &s, char delim, std::vector<std::string> &elems, int &n);
 std::vector<std::string>  split(const std::string &s, char delim, int n);
 
+// a field within a string, described by its offset and length rather than a
+// copy of the characters.
+struct stringSpan {
+    size_t start;
+    size_t length;
+};
+
+// split a string on a single delimiter character into spans, but only find the
+// first n - 1 splits (the last span holds the remainder of the string).  The
+// spans vector is reused between calls, so no allocation is made once it has
+// grown to size.  The number of spans found is returned.
+unsigned int splitSpans(const std::string &s, char delim, std::vector<stringSpan> &spans, unsigned int n);
+
 // split a string on any character found in the string of delimiters (delims)
 std::vector<std::string>& split(const std::string &s, const std::string& delims, std::vector<std::string> &elems);
 std::vector<std::string>  split(const std::string &s, const std::string& delims);
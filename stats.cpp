@@ -18,18 +18,47 @@
 #define DELETION 6
 #define COMPLEX 7
 
+// The sampleStats field for each sample level statistic, in the order
+// of the sampleField enumeration.
+static unsigned int sampleStats::* sampleFields[NUMBER_SAMPLE_FIELDS] = {
+  &sampleStats::knownAminations,
+  &sampleStats::knownDeaminations,
+  &sampleStats::knownHetTransitions,
+  &sampleStats::knownHetTransversions,
+  &sampleStats::knownHomTransitions,
+  &sampleStats::knownHomTransversions,
+  &sampleStats::novelAminations,
+  &sampleStats::novelDeaminations,
+  &sampleStats::novelHetTransitions,
+  &sampleStats::novelHetTransversions,
+  &sampleStats::novelHomTransitions,
+  &sampleStats::novelHomTransversions,
+  &sampleStats::hetMnps,
+  &sampleStats::hetDeletions,
+  &sampleStats::hetInsertions,
+  &sampleStats::homDeletions,
+  &sampleStats::homInsertions,
+  &sampleStats::hetComplex,
+  &sampleStats::homComplex,
+  &sampleStats::homMnps,
+  &sampleStats::homRef,
+  &sampleStats::unknown
+};
+
 using namespace std;
 using namespace vcfCTools;
 
 // Constructor.
 statistics::statistics(void) {
   lastSnpPosition          = -1;
-  lastSnpPosition          = -1;
+  lastMnpPosition          = -1;
   lastIndelPosition        = -1;
   currentReferenceSequence = "";
+  hasAnnotations           = false;
   hasInsertion             = false;
   hasDeletion              = false;
   hasMnp                   = false;
+  hasMultiSnp              = false;
   hasSnp                   = false;
   splitMnps                = false;
 
@@ -201,6 +230,64 @@ void statistics::generateStatistics(vcfHeader& header, variant& var, bool useAnn
   }
 }
 
+// Add the counts for one sample to those in another.
+static void addSampleStats(sampleStats& total, sampleStats& counts) {
+  total.knownAminations       += counts.knownAminations;
+  total.knownDeaminations     += counts.knownDeaminations;
+  total.knownHetTransitions   += counts.knownHetTransitions;
+  total.knownHetTransversions += counts.knownHetTransversions;
+  total.knownHomTransitions   += counts.knownHomTransitions;
+  total.knownHomTransversions += counts.knownHomTransversions;
+  total.novelAminations       += counts.novelAminations;
+  total.novelDeaminations     += counts.novelDeaminations;
+  total.novelHetTransitions   += counts.novelHetTransitions;
+  total.novelHetTransversions += counts.novelHetTransversions;
+  total.novelHomTransitions   += counts.novelHomTransitions;
+  total.novelHomTransversions += counts.novelHomTransversions;
+  total.hetMnps               += counts.hetMnps;
+  total.hetDeletions          += counts.hetDeletions;
+  total.hetInsertions         += counts.hetInsertions;
+  total.homDeletions          += counts.homDeletions;
+  total.homInsertions         += counts.homInsertions;
+  total.hetComplex            += counts.hetComplex;
+  total.homComplex            += counts.homComplex;
+  total.homMnps               += counts.homMnps;
+  total.homRef                += counts.homRef;
+  total.unknown               += counts.unknown;
+}
+
+// Add the statistics generated for another part of the file (e.g. a
+// region processed on another thread) to these statistics.  This must
+// be done before the totals are calculated with countByFilter.
+void statistics::mergeStatistics(statistics& stats) {
+  map<string, map<string, variantStruct> >::iterator variantIter = stats.variants.begin();
+  map<string, variantStruct>::iterator filterIter;
+
+  for (; variantIter != stats.variants.end(); variantIter++) {
+    for (filterIter = variantIter->second.begin(); filterIter != variantIter->second.end(); filterIter++) {
+      variants[variantIter->first][filterIter->first] = variants[variantIter->first][filterIter->first] + filterIter->second;
+    }
+  }
+
+  // Sample level statistics.
+  stats.collectSampleStats();
+  collectSampleStats();
+  if (sampleLevelStats.size() < stats.sampleLevelStats.size()) {sampleLevelStats.resize(stats.sampleLevelStats.size());}
+  for (unsigned int i = 0; i < stats.sampleLevelStats.size(); i++) {
+    addSampleStats(sampleLevelStats[i], stats.sampleLevelStats[i]);
+  }
+  for (map<string, unsigned int>::iterator iter = stats.annotationNames.begin(); iter != stats.annotationNames.end(); iter++) {
+    annotationNames[iter->first] += iter->second;
+  }
+
+  hasAnnotations = hasAnnotations || stats.hasAnnotations;
+  hasDeletion    = hasDeletion || stats.hasDeletion;
+  hasInsertion   = hasInsertion || stats.hasInsertion;
+  hasMnp         = hasMnp || stats.hasMnp;
+  hasMultiSnp    = hasMultiSnp || stats.hasMultiSnp;
+  hasSnp         = hasSnp || stats.hasSnp;
+}
+
 // Given the SNP alleles, determine if it is a transition/transversion and update
 // all necessary statistics.
 void statistics::determineSnpType(variant& var, string& alleles, unsigned int ac) {
@@ -255,96 +342,48 @@ void statistics::determineSnpType(variant& var, string& alleles, unsigned int ac
 // Parse the genotypes for each sample and update the relevant
 // statistics structures.
 void statistics::parseGenotypes(vcfHeader& header, variant& var, vector<unsigned int> variantIDs) {
-  unsigned int depth;
-  unsigned int sampleID = 0;
-  string entry;
-  string geno;
-  double quality;
-  vector<string> sampleEntries;
-  genotypeInfo gen(var.ovIter->genotypeFormat, var.ovIter->genotypes);
-  gen.processFormats(header);
-
-  // Parse each sample in turn.
-  vector<string>::iterator genoIter = gen.genotypes.begin();
-  for (; genoIter != gen.genotypes.end(); genoIter++) {
-    sampleEntries = split(*genoIter, ":");
-
-    // Check that the number of entries is consistent with the format string.
-    if (sampleEntries.size() != gen.genotypeFormats.size() && sampleEntries.size() != 1) {
-      cerr << "ERROR: Number of fields in the genotype string is inconsistent with the format for sample ";
-      cerr << header.samples[sampleID] << " at " << var.ovIter->referenceSequence << ":" << var.ovIter->position << "." << endl;
-      exit(1);
-    } else if (sampleEntries.size() == 1 && sampleEntries[0] == ".") {
-      sampleLevelStats[header.samples[sampleID]].unknown++;
-    } else {
-      quality = (gen.genotypeFields.count("GQ") == 0) ? 0. : atof( (sampleEntries[gen.genotypeFields["GQ"].ID]).c_str() );
-      if (quality >= minGenotypeQuality || gen.genotypeFields.count("GQ") == 0) {
-        geno  = sampleEntries[gen.genotypeFields["GT"].ID];
-        //depth = (gen.genotypeFields.count("GQ") == 0) ? 0 : atoi( (sampleEntries[gen.genotypeFields["DP"].ID]).c_str() );
-
-        // Find the allele IDs from the genotype string.  This can be 0 for
-        // reference and then any number up to the number of alternate alleles.
-        // Only do this if the genotype isn't '.'.
-        if (geno == ".") {
-          sampleLevelStats[header.samples[sampleID]].unknown++;
-        } else {
-          size_t separator = geno.find('/');
-          if (separator == string::npos) {
-            separator = geno.find("|");
-            if (separator == string::npos) {
-              cerr << "ERROR: Unknown genotype separator in sample " << header.samples[sampleID];
-              cerr << " at " << var.ovIter->referenceSequence << ":" << var.ovIter->position << "." << endl;
-              exit(1);
-            }
-          }
-          unsigned int idA = atoi((geno.substr(0, separator)).c_str());
-          unsigned int idB = atoi((geno.substr(separator + 1, geno.length())).c_str());
-
-          // Define a structure to hold boolean flags.  This will be used in other called
-          // routines.
-          statsFlags flags;
-          flags.het            = false;
-          flags.isAmination    = isAmination;
-          flags.isDeamination  = isDeamination;
-          flags.inDbsnp        = inDbsnp;
-          flags.isTransition   = isTransition;
-          flags.isTransversion = isTransversion;
-  
-          // If the allele IDs are the same, the sample is homozygous.  If they are
-          // both '0', then they are homozygous reference and can be dealt with immediately.
-          // For non-reference alleles, the array variantIDs can be used to determine
-          // which alternate allele the ID corresponds to.
-          size_t dotInGeno = geno.find('.');
-          if (dotInGeno != string::npos) {
-            sampleLevelStats[header.samples[sampleID]].unknown++;
-          } else if (idA == idB && idA == 0) {
-            sampleLevelStats[header.samples[sampleID]].homRef++;
-  
-          // Homozygous non-reference.
-          } else if (idA == idB) {
-            updateSampleLevelStats(flags, variantIDs[idA], header.samples[sampleID]);
-  
-          // Heterozygous with a ref allele.
-          } else if (idA == 0 | idB == 0) {
-            flags.het = true;
-            unsigned int id = (idA == 0) ? variantIDs[idB] : variantIDs[idA];
-            updateSampleLevelStats(flags, id, header.samples[sampleID]);
-  
-          // Heterozygous with two non-reference alleles.
-          } else {
-          }
-  
-          // Update the total depth for the sample.
-          //sampleSnps[header.samples[sampleID]].totalDepth += depth;
-        }
-      }
+
+  // Decode the genotypes of all samples into packed planes.
+  genotypeView.setRecord(var.ovIter->genotypeFormat, var.ovIter->genotypes);
+  genotypeView.checkFormats(header);
+  sampleGenotypes.decode(genotypeView, header, var.ovIter->referenceSequence, var.ovIter->position, minGenotypeQuality, variantIDs.size() - 1);
+
+  if (sampleCounters.size() != NUMBER_SAMPLE_FIELDS) {sampleCounters.resize(NUMBER_SAMPLE_FIELDS);}
+  if (sampleCounters[0].totals.size() != header.samples.size()) {
+    for (vector<sampleCounter>::iterator iter = sampleCounters.begin(); iter != sampleCounters.end(); iter++) {
+      iter->resize(header.samples.size());
     }
-    sampleID++;
+  }
+
+  // Define a structure to hold boolean flags.  This will be used in other called
+  // routines.
+  statsFlags flags;
+  flags.het            = false;
+  flags.isAmination    = isAmination;
+  flags.isDeamination  = isDeamination;
+  flags.inDbsnp        = inDbsnp;
+  flags.isTransition   = isTransition;
+  flags.isTransversion = isTransversion;
+
+  // Count the unknown and homozygous reference genotypes.  For non-reference
+  // alleles, the array variantIDs can be used to determine which alternate
+  // allele the ID corresponds to.
+  sampleCounters[SAMPLE_UNKNOWN].add(sampleGenotypes.missing);
+  sampleCounters[SAMPLE_HOM_REF].add(sampleGenotypes.homRef);
+  for (unsigned int id = 1; id < variantIDs.size(); id++) {
+
+    // Homozygous non-reference.
+    flags.het = false;
+    updateSampleLevelStats(flags, variantIDs[id], sampleGenotypes.hom[id]);
+
+    // Heterozygous with a ref allele.
+    flags.het = true;
+    updateSampleLevelStats(flags, variantIDs[id], sampleGenotypes.het[id]);
   }
 }
 
-// Update the sample level statistics.
-void statistics::updateSampleLevelStats(statsFlags& flags, unsigned int id, string& sample) {
+// Update the sample level statistics for all of the samples in the plane.
+void statistics::updateSampleLevelStats(statsFlags& flags, unsigned int id, vector<uint64_t>& plane) {
 
   // Update the statistics for the correct variant type.
   if (id == SNP) {
@@ -354,65 +393,70 @@ void statistics::updateSampleLevelStats(statsFlags& flags, unsigned int id, stri
 
       // Known SNPs.
       if (flags.inDbsnp) {
-        if (flags.isTransition) {sampleLevelStats[sample].knownHetTransitions++;}
-        else if (flags.isTransversion) {sampleLevelStats[sample].knownHetTransversions++;}
+        if (flags.isTransition) {sampleCounters[SAMPLE_KNOWN_HET_TRANSITIONS].add(plane);}
+        else if (flags.isTransversion) {sampleCounters[SAMPLE_KNOWN_HET_TRANSVERSIONS].add(plane);}
 
         // De/aminations.
-        if (flags.isAmination) {sampleLevelStats[sample].knownAminations++;}
-        else if (flags.isDeamination) {sampleLevelStats[sample].knownDeaminations++;}
+        if (flags.isAmination) {sampleCounters[SAMPLE_KNOWN_AMINATIONS].add(plane);}
+        else if (flags.isDeamination) {sampleCounters[SAMPLE_KNOWN_DEAMINATIONS].add(plane);}
 
       // Novel SNPs.
       } else {
-        if (flags.isTransition) {sampleLevelStats[sample].novelHetTransitions++;}
-        else if (flags.isTransversion) {sampleLevelStats[sample].novelHetTransversions++;}
+        if (flags.isTransition) {sampleCounters[SAMPLE_NOVEL_HET_TRANSITIONS].add(plane);}
+        else if (flags.isTransversion) {sampleCounters[SAMPLE_NOVEL_HET_TRANSVERSIONS].add(plane);}
 
         // De/aminations.
-        if (flags.isAmination) {sampleLevelStats[sample].novelAminations++;}
-        else if (flags.isDeamination) {sampleLevelStats[sample].novelDeaminations++;}
+        if (flags.isAmination) {sampleCounters[SAMPLE_NOVEL_AMINATIONS].add(plane);}
+        else if (flags.isDeamination) {sampleCounters[SAMPLE_NOVEL_DEAMINATIONS].add(plane);}
       }
     } else {
 
       // Known SNPs.
       if (flags.inDbsnp) {
-        if (flags.isTransition) {sampleLevelStats[sample].knownHomTransitions++;}
-        else if (flags.isTransversion) {sampleLevelStats[sample].knownHomTransversions++;}
+        if (flags.isTransition) {sampleCounters[SAMPLE_KNOWN_HOM_TRANSITIONS].add(plane);}
+        else if (flags.isTransversion) {sampleCounters[SAMPLE_KNOWN_HOM_TRANSVERSIONS].add(plane);}
 
         // De/aminations.
-        if (flags.isAmination) {sampleLevelStats[sample].knownAminations++;}
-        else if (flags.isDeamination) {sampleLevelStats[sample].knownDeaminations++;}
+        if (flags.isAmination) {sampleCounters[SAMPLE_KNOWN_AMINATIONS].add(plane);}
+        else if (flags.isDeamination) {sampleCounters[SAMPLE_KNOWN_DEAMINATIONS].add(plane);}
 
       // Novel SNPs.
       } else {
-        if (flags.isTransition) {sampleLevelStats[sample].novelHomTransitions++;}
-        else if (flags.isTransversion) {sampleLevelStats[sample].novelHomTransversions++;}
+        if (flags.isTransition) {sampleCounters[SAMPLE_NOVEL_HOM_TRANSITIONS].add(plane);}
+        else if (flags.isTransversion) {sampleCounters[SAMPLE_NOVEL_HOM_TRANSVERSIONS].add(plane);}
 
         // De/aminations.
-        if (flags.isAmination) {sampleLevelStats[sample].novelAminations++;}
-        else if (flags.isDeamination) {sampleLevelStats[sample].novelDeaminations++;}
+        if (flags.isAmination) {sampleCounters[SAMPLE_NOVEL_AMINATIONS].add(plane);}
+        else if (flags.isDeamination) {sampleCounters[SAMPLE_NOVEL_DEAMINATIONS].add(plane);}
       }
     }
   } else if (id == TRISNP) {
   } else if (id == QUADSNP) {
   } else if (id == MNP) {
-    if (flags.het) {sampleLevelStats[sample].hetMnps++;}
-    else {sampleLevelStats[sample].homMnps++;}
+    if (flags.het) {sampleCounters[SAMPLE_HET_MNPS].add(plane);}
+    else {sampleCounters[SAMPLE_HOM_MNPS].add(plane);}
   } else if (id == INSERTION) {
-    if (flags.het) {
-      sampleLevelStats[sample].hetInsertions++;
-    }
-    else {
-      sampleLevelStats[sample].homInsertions++;
-    }
+    if (flags.het) {sampleCounters[SAMPLE_HET_INSERTIONS].add(plane);}
+    else {sampleCounters[SAMPLE_HOM_INSERTIONS].add(plane);}
   } else if (id == DELETION) {
-    if (flags.het) {
-      sampleLevelStats[sample].hetDeletions++;
-    }
-    else {
-      sampleLevelStats[sample].homDeletions++;
-    }
+    if (flags.het) {sampleCounters[SAMPLE_HET_DELETIONS].add(plane);}
+    else {sampleCounters[SAMPLE_HOM_DELETIONS].add(plane);}
   } else if (id == COMPLEX) {
-    if (flags.het) {sampleLevelStats[sample].hetComplex++;}
-    else {sampleLevelStats[sample].homComplex++;}
+    if (flags.het) {sampleCounters[SAMPLE_HET_COMPLEX].add(plane);}
+    else {sampleCounters[SAMPLE_HOM_COMPLEX].add(plane);}
+  }
+}
+
+// Move the counts for each sample into the sample level statistics.
+void statistics::collectSampleStats() {
+  for (unsigned int field = 0; field < sampleCounters.size(); field++) {
+    sampleCounter& counter = sampleCounters[field];
+    counter.flush();
+    if (sampleLevelStats.size() < counter.totals.size()) {sampleLevelStats.resize(counter.totals.size());}
+    for (unsigned int i = 0; i < counter.totals.size(); i++) {
+      sampleLevelStats[i].*sampleFields[field] += counter.totals[i];
+      counter.totals[i] = 0;
+    }
   }
 }
 
@@ -986,26 +1030,29 @@ void statistics::printSampleSnps(vcfHeader& header, vcf& v, output& ofile) {
   //*ofile.outputStream << setw(12) << "Depth";
   //*ofile.outputStream << setw(12) << "Alt_depth";
   *ofile.outputStream << endl;
+  collectSampleStats();
+  if (sampleLevelStats.size() < header.samples.size()) {sampleLevelStats.resize(header.samples.size());}
   for (vector<string>::iterator sample = header.samples.begin(); sample != header.samples.end(); sample++) {
+    sampleStats& counts = sampleLevelStats[sample - header.samples.begin()];
 
     // Calculate transition/transversion ratios etc for each sample.
-    unsigned int aminations    = sampleLevelStats[*sample].novelAminations + sampleLevelStats[*sample].knownAminations;
-    unsigned int deaminations  = sampleLevelStats[*sample].novelDeaminations + sampleLevelStats[*sample].knownDeaminations;
-    unsigned int novelAm       = sampleLevelStats[*sample].novelAminations;
-    unsigned int novelDe       = sampleLevelStats[*sample].novelDeaminations;
-    unsigned int novelTs       = sampleLevelStats[*sample].novelHomTransitions + sampleLevelStats[*sample].novelHetTransitions;
-    unsigned int novelTv       = sampleLevelStats[*sample].novelHomTransversions + sampleLevelStats[*sample].novelHetTransversions;
-    unsigned int knownAm       = sampleLevelStats[*sample].knownAminations;
-    unsigned int knownDe       = sampleLevelStats[*sample].knownDeaminations;
-    unsigned int knownTs       = sampleLevelStats[*sample].knownHomTransitions + sampleLevelStats[*sample].knownHetTransitions;
-    unsigned int knownTv       = sampleLevelStats[*sample].knownHomTransversions + sampleLevelStats[*sample].knownHetTransversions;
+    unsigned int aminations    = counts.novelAminations + counts.knownAminations;
+    unsigned int deaminations  = counts.novelDeaminations + counts.knownDeaminations;
+    unsigned int novelAm       = counts.novelAminations;
+    unsigned int novelDe       = counts.novelDeaminations;
+    unsigned int novelTs       = counts.novelHomTransitions + counts.novelHetTransitions;
+    unsigned int novelTv       = counts.novelHomTransversions + counts.novelHetTransversions;
+    unsigned int knownAm       = counts.knownAminations;
+    unsigned int knownDe       = counts.knownDeaminations;
+    unsigned int knownTs       = counts.knownHomTransitions + counts.knownHetTransitions;
+    unsigned int knownTv       = counts.knownHomTransversions + counts.knownHetTransversions;
     unsigned int known         = knownTs + knownTv;
     unsigned int novel         = novelTs + novelTv;
     unsigned int transitions   = novelTs + knownTs;
     unsigned int transversions = novelTv + knownTv;
     unsigned int totalSnp      = transitions + transversions;
-    //double depth      = (totalSnp == 0) ? 0. : double(sampleLevelStats[*sample].totalDepth) / double(totalSnps);
-    //double altDepth   = (totalSnp == 0) ? 0. : double(sampleLevelStats[*sample].totalAltDepth) / double(totalSnp);
+    //double depth      = (totalSnp == 0) ? 0. : double(counts.totalDepth) / double(totalSnps);
+    //double altDepth   = (totalSnp == 0) ? 0. : double(counts.totalAltDepth) / double(totalSnp);
     double deam       = (aminations == 0) ? 0. : (double(aminations) / double(deaminations));
     double dbsnp      = (totalSnp == 0) ? 0. : (100. * double(known) / double(totalSnp));
     double tstv       = (transversions == 0) ? 0. : (double(transitions) / double(transversions));
@@ -1035,30 +1082,30 @@ void statistics::printSampleSnps(vcfHeader& header, vcf& v, output& ofile) {
     *ofile.outputStream << setw(8) << setprecision(3) << knowndeam;
 
     // SNP genotype information.
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].homRef;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].knownHetTransitions + sampleLevelStats[*sample].novelHetTransitions;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].knownHetTransversions + sampleLevelStats[*sample].novelHetTransversions;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].knownHomTransitions + sampleLevelStats[*sample].novelHomTransitions;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].knownHomTransversions + sampleLevelStats[*sample].novelHomTransversions;
+    *ofile.outputStream << setw(12) << counts.homRef;
+    *ofile.outputStream << setw(12) << counts.knownHetTransitions + counts.novelHetTransitions;
+    *ofile.outputStream << setw(12) << counts.knownHetTransversions + counts.novelHetTransversions;
+    *ofile.outputStream << setw(12) << counts.knownHomTransitions + counts.novelHomTransitions;
+    *ofile.outputStream << setw(12) << counts.knownHomTransversions + counts.novelHomTransversions;
 
     // MNPs.
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].hetMnps;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].homMnps;
+    *ofile.outputStream << setw(12) << counts.hetMnps;
+    *ofile.outputStream << setw(12) << counts.homMnps;
 
     // Insertions.
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].hetInsertions;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].homInsertions;
+    *ofile.outputStream << setw(12) << counts.hetInsertions;
+    *ofile.outputStream << setw(12) << counts.homInsertions;
 
     // Deletions.
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].hetDeletions;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].homDeletions;
+    *ofile.outputStream << setw(12) << counts.hetDeletions;
+    *ofile.outputStream << setw(12) << counts.homDeletions;
 
     // Complex variants.
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].hetComplex;
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].homComplex;
+    *ofile.outputStream << setw(12) << counts.hetComplex;
+    *ofile.outputStream << setw(12) << counts.homComplex;
 
     // Unknown genotypes (these contain at least one '.').
-    *ofile.outputStream << setw(12) << sampleLevelStats[*sample].unknown;
+    *ofile.outputStream << setw(12) << counts.unknown;
 //    *ofile.outputStream << setw(12) << sampleSnps[*sample].unknown;
 //    *ofile.outputStream << setw(12) << sampleSnps[*sample].singletons;
 //    *ofile.outputStream << setw(12) << setprecision(3) << depth;
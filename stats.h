@@ -12,6 +12,7 @@
 #define STATS_H
 
 #include "header.h"
+#include "packed_genotypes.h"
 #include "info.h"
 #include "output.h"
 #include "stats.h"
@@ -85,7 +86,7 @@ struct variantStruct {
     result.knownTransversions     = this->knownTransversions     + vs.knownTransversions;
     result.diffKnownTransversions = this->diffKnownTransversions + vs.diffKnownTransversions;
     result.knownAminations        = this->knownAminations        + vs.knownAminations;
-    result.knownDeaminations      = this->knownDeaminations      + vs.knownAminations;
+    result.knownDeaminations      = this->knownDeaminations      + vs.knownDeaminations;
     result.multiAllelic           = this->multiAllelic           + vs.multiAllelic;
 
     // MNPs
@@ -190,6 +191,34 @@ struct sampleStats {
   unsigned unknown;
 };
 
+// The sample level statistics, in the order of the sampleStats fields.
+// Each has a counter for every sample.
+enum sampleField {
+  SAMPLE_KNOWN_AMINATIONS,
+  SAMPLE_KNOWN_DEAMINATIONS,
+  SAMPLE_KNOWN_HET_TRANSITIONS,
+  SAMPLE_KNOWN_HET_TRANSVERSIONS,
+  SAMPLE_KNOWN_HOM_TRANSITIONS,
+  SAMPLE_KNOWN_HOM_TRANSVERSIONS,
+  SAMPLE_NOVEL_AMINATIONS,
+  SAMPLE_NOVEL_DEAMINATIONS,
+  SAMPLE_NOVEL_HET_TRANSITIONS,
+  SAMPLE_NOVEL_HET_TRANSVERSIONS,
+  SAMPLE_NOVEL_HOM_TRANSITIONS,
+  SAMPLE_NOVEL_HOM_TRANSVERSIONS,
+  SAMPLE_HET_MNPS,
+  SAMPLE_HET_DELETIONS,
+  SAMPLE_HET_INSERTIONS,
+  SAMPLE_HOM_DELETIONS,
+  SAMPLE_HOM_INSERTIONS,
+  SAMPLE_HET_COMPLEX,
+  SAMPLE_HOM_COMPLEX,
+  SAMPLE_HOM_MNPS,
+  SAMPLE_HOM_REF,
+  SAMPLE_UNKNOWN,
+  NUMBER_SAMPLE_FIELDS
+};
+
 // Define a structure for holding boolean flags about a particular
 // variant.
 struct statsFlags {
@@ -206,10 +235,12 @@ class statistics {
   public:
     statistics(void);
     ~statistics(void);
+    void collectSampleStats();
     void countByFilter();
     void determineSnpType(variant&, string&, unsigned int);
     void generateStatistics(vcfHeader&, variant&, bool, vector<string>&, bool, output&);
     void getAnnotations(vector<string>&, variantInfo&, map<string, unsigned int>&);
+    void mergeStatistics(statistics&);
     void parseGenotypes(vcfHeader&, variant&, vector<unsigned int>);
     void printAcs(output&);
     void printAfs(output&);
@@ -223,7 +254,7 @@ class statistics {
     void printSnpAnnotationStruct(output&, string&, variantStruct&, string&);
     void printSnpStatistics(output&);
     void printVariantStruct(output&, string, variantStruct&);
-    void updateSampleLevelStats(statsFlags&, unsigned int, string&);
+    void updateSampleLevelStats(statsFlags&, unsigned int, vector<uint64_t>&);
     void updateDetailedSnps(variant&, vcf&, unsigned int, output&);
 
   public:
@@ -258,7 +289,15 @@ class statistics {
     bool generateSampleStats;
     double minDetailedGenotypeQuality;
     double minGenotypeQuality;
-    map<string, sampleStats> sampleLevelStats;
+    vector<sampleStats> sampleLevelStats;
+
+    // The genotypes of the current record (reused for every record) and
+    // the counters for each sample level statistic, indexed by sample
+    // ordinal.  The counts are moved into sampleLevelStats by
+    // collectSampleStats.
+    genotypeColumns genotypeView;
+    packedGenotypes sampleGenotypes;
+    vector<sampleCounter> sampleCounters;
 };
 
 } // namespace vcfCTools
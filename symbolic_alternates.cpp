@@ -22,9 +22,9 @@ void validateAlternateAlleles(vcfHeader&, variant& var) {
   vector<variantType>::iterator typeIter = var.ovIter->type.begin();
   for (; aIter != var.ovIter->alts.end(); aIter++) {
     if (typeIter->isSv) {
-      cerr << *aIter << " " << typeIter->isSv << endl;
+      *var.errorStream << *aIter << " " << typeIter->isSv << endl;
     } else if (typeIter->isRearrangement) {
-      cerr << *aIter << " " << typeIter->isSv << endl;
+      *var.errorStream << *aIter << " " << typeIter->isSv << endl;
     }
     typeIter++;
   }
@@ -0,0 +1,307 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Read tabix (.tbi) and CSI (.csi) indexes and find the
+// chunks of a BGZF file that overlap a region.
+// ******************************************************
+
+#include "tabix.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Read little endian integers from the (compressed) index file.
+static bool readBytes(gzFile file, char* bytes, unsigned int length) {
+  return gzread(file, bytes, length) == (int) length;
+}
+
+static bool readInt32(gzFile file, int& value) {
+  unsigned char b[4];
+  if (!readBytes(file, (char*) b, 4)) {return false;}
+  value = (int) (b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int) b[3] << 24));
+
+  return true;
+}
+
+static bool readUint64(gzFile file, uint64_t& value) {
+  unsigned char b[8];
+  if (!readBytes(file, (char*) b, 8)) {return false;}
+  value = 0;
+  for (int i = 7; i >= 0; i--) {value = (value << 8) | b[i];}
+
+  return true;
+}
+
+// Order chunks by their start offset.
+static bool compareChunks(const indexChunk& a, const indexChunk& b) {
+  return a.start < b.start;
+}
+
+// Constructor.
+tabixIndex::tabixIndex(void) {
+  depth    = 5;
+  isCsi    = false;
+  minShift = 14;
+}
+
+// Destructor.
+tabixIndex::~tabixIndex(void) {}
+
+// Look for an index for the given (BGZF compressed) file.  The tabix
+// index (file.tbi) is preferred, otherwise the CSI index (file.csi) is
+// used.  Returns false if neither exists.
+bool tabixIndex::openIndex(string& filename) {
+  const char* extensions[2] = {".tbi", ".csi"};
+
+  for (unsigned int i = 0; i < 2; i++) {
+    string name = filename + extensions[i];
+    gzFile file = gzopen(name.c_str(), "rb");
+    if (file == NULL) {continue;}
+
+    bool success = readIndex(file, name);
+    gzclose(file);
+    if (!success) {
+      cerr << "ERROR: Unable to read index file: " << name << endl;
+      exit(1);
+    }
+    indexFilename = name;
+
+    return true;
+  }
+
+  return false;
+}
+
+// Read the contents of the index.
+bool tabixIndex::readIndex(gzFile file, string& name) {
+  char magic[4];
+  int numberReferences;
+
+  sequenceNames.clear();
+  sequenceIDs.clear();
+  references.clear();
+
+  if (!readBytes(file, magic, 4)) {return false;}
+  if (memcmp(magic, "TBI\1", 4) == 0) {
+    int values[7];
+
+    // Tabix header: the number of reference sequences, the file format,
+    // the sequence, start and end columns, the comment character and the
+    // number of lines to skip followed by the sequence names.
+    isCsi    = false;
+    minShift = 14;
+    depth    = 5;
+    if (!readInt32(file, numberReferences)) {return false;}
+    for (unsigned int i = 0; i < 7; i++) {
+      if (!readInt32(file, values[i])) {return false;}
+    }
+    if (values[6] < 0) {return false;}
+    vector<char> names(values[6] + 1, 0);
+    if (!readBytes(file, &names[0], values[6])) {return false;}
+    if (!readNames(&names[0], values[6])) {return false;}
+
+  } else if (memcmp(magic, "CSI\1", 4) == 0) {
+    int auxLength;
+
+    // CSI header: the bin parameters followed by auxiliary data.  For
+    // files indexed as text, the auxiliary data is the tabix header
+    // including the sequence names.
+    isCsi = true;
+    if (!readInt32(file, minShift) || !readInt32(file, depth) || !readInt32(file, auxLength)) {return false;}
+    if (auxLength < 0 || minShift <= 0 || depth <= 0) {return false;}
+    vector<char> aux(auxLength + 1, 0);
+    if (auxLength > 0 && !readBytes(file, &aux[0], auxLength)) {return false;}
+    if (auxLength < 28) {
+      cerr << "ERROR: The CSI index does not contain sequence names: " << name << endl;
+      exit(1);
+    }
+    const unsigned char* b = (const unsigned char*) &aux[24];
+    int namesLength = (int) (b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int) b[3] << 24));
+    if (namesLength < 0 || namesLength > auxLength - 28) {return false;}
+    if (!readNames(&aux[28], namesLength)) {return false;}
+    if (!readInt32(file, numberReferences)) {return false;}
+
+  } else {
+    cerr << "ERROR: Unrecognised index format: " << name << endl;
+    exit(1);
+  }
+
+  if (numberReferences < 0 || (unsigned int) numberReferences != sequenceNames.size()) {return false;}
+
+  // The pseudo-bin holds index metadata rather than chunks and is ignored.
+  unsigned int pseudoBin = ((1 << (3 * depth + 3)) - 1) / 7 + 1;
+
+  references.resize(numberReferences);
+  for (int i = 0; i < numberReferences; i++) {
+    indexReference& reference = references[i];
+    int numberBins;
+
+    if (!readInt32(file, numberBins)) {return false;}
+    for (int j = 0; j < numberBins; j++) {
+      int bin, numberChunks;
+      uint64_t binOffset = 0;
+
+      if (!readInt32(file, bin)) {return false;}
+      if (isCsi && !readUint64(file, binOffset)) {return false;}
+      if (!readInt32(file, numberChunks)) {return false;}
+
+      vector<indexChunk> chunks(numberChunks);
+      for (int k = 0; k < numberChunks; k++) {
+        if (!readUint64(file, chunks[k].start) || !readUint64(file, chunks[k].end)) {return false;}
+      }
+      if ((unsigned int) bin == pseudoBin) {continue;}
+      reference.bins[bin].swap(chunks);
+      if (isCsi) {reference.binOffsets[bin] = binOffset;}
+    }
+
+    // Tabix indexes include a linear index of the smallest offset in each
+    // 16kb window.
+    if (!isCsi) {
+      int numberIntervals;
+      if (!readInt32(file, numberIntervals) || numberIntervals < 0) {return false;}
+      reference.linearIndex.resize(numberIntervals);
+      for (int j = 0; j < numberIntervals; j++) {
+        if (!readUint64(file, reference.linearIndex[j])) {return false;}
+      }
+    }
+  }
+
+  return true;
+}
+
+// Read the null separated list of sequence names.
+bool tabixIndex::readNames(const char* names, int length) {
+  int start = 0;
+
+  for (int i = 0; i < length; i++) {
+    if (names[i] == '\0') {
+      string name(names + start, i - start);
+      sequenceIDs[name] = sequenceNames.size();
+      sequenceNames.push_back(name);
+      start = i + 1;
+    }
+  }
+
+  return start == length;
+}
+
+// Find all bins that may contain records overlapping the 0-based, half
+// open interval [begin, end).
+void tabixIndex::regionToBins(int64_t begin, int64_t end, vector<unsigned int>& bins) {
+  int shift      = minShift + 3 * depth;
+  int64_t offset = 0;
+
+  bins.clear();
+  if (end > ((int64_t) 1 << shift)) {end = (int64_t) 1 << shift;}
+  if (begin >= end) {return;}
+  end--;
+  for (int level = 0; level <= depth; level++) {
+    for (int64_t bin = offset + (begin >> shift); bin <= offset + (end >> shift); bin++) {bins.push_back(bin);}
+    offset += (int64_t) 1 << (3 * level);
+    shift  -= 3;
+  }
+}
+
+// Determine the smallest file offset of any record overlapping the
+// position begin (0-based).  Chunks ending before this offset cannot
+// contain records in the region.
+uint64_t tabixIndex::minimumOffset(indexReference& reference, int64_t begin) {
+
+  // Tabix: use the linear index.
+  if (!isCsi) {
+    if (reference.linearIndex.size() == 0) {return 0;}
+    uint64_t window = begin >> minShift;
+    if (window >= reference.linearIndex.size()) {window = reference.linearIndex.size() - 1;}
+
+    return reference.linearIndex[window];
+  }
+
+  // CSI: use the offset stored with the smallest bin containing this
+  // position, moving to the preceding bins and parents if it is absent.
+  int64_t bin = (((int64_t) 1 << (3 * depth)) - 1) / 7 + (begin >> minShift);
+  while (true) {
+    map<unsigned int, uint64_t>::iterator iter = reference.binOffsets.find(bin);
+    if (iter != reference.binOffsets.end()) {return iter->second;}
+    if (bin == 0) {return 0;}
+
+    int64_t parent = (bin - 1) >> 3;
+    if (bin > (parent << 3) + 1) {bin--;}
+    else {bin = parent;}
+  }
+}
+
+// Find the chunks of the file that contain all records overlapping the
+// region.  The chunks are returned sorted and non-overlapping.  If the
+// reference sequence is not in the index, no chunks are returned.
+void tabixIndex::query(genomicRegion& region, vector<indexChunk>& chunks) {
+  vector<unsigned int> bins;
+
+  chunks.clear();
+  map<string, unsigned int>::iterator idIter = sequenceIDs.find(region.referenceSequence);
+  if (idIter == sequenceIDs.end()) {return;}
+  indexReference& reference = references[idIter->second];
+
+  int64_t begin = (region.start > 0) ? region.start - 1 : 0;
+  int64_t end   = (region.end > 0) ? region.end : ((int64_t) 1 << (minShift + 3 * depth));
+  uint64_t minimum = minimumOffset(reference, begin);
+
+  regionToBins(begin, end, bins);
+  for (vector<unsigned int>::iterator binIter = bins.begin(); binIter != bins.end(); binIter++) {
+    map<unsigned int, vector<indexChunk> >::iterator iter = reference.bins.find(*binIter);
+    if (iter == reference.bins.end()) {continue;}
+    for (vector<indexChunk>::iterator chunkIter = iter->second.begin(); chunkIter != iter->second.end(); chunkIter++) {
+      if (chunkIter->end > minimum) {chunks.push_back(*chunkIter);}
+    }
+  }
+  mergeChunks(chunks);
+}
+
+// Find an upper bound on the length of a reference sequence from the
+// positions covered by the index.
+int tabixIndex::sequenceLength(unsigned int id) {
+  if (id >= references.size()) {return 0;}
+  indexReference& reference = references[id];
+  int64_t length = 0;
+
+  // Tabix: the linear index has an entry for every 16kb window.
+  if (!isCsi) {
+    length = (int64_t) reference.linearIndex.size() << minShift;
+
+  // CSI: find the end of the furthest bin.
+  } else {
+    for (map<unsigned int, vector<indexChunk> >::iterator iter = reference.bins.begin(); iter != reference.bins.end(); iter++) {
+      int level = 0;
+      while (level < depth && iter->first >= (unsigned int) ((((int64_t) 1 << (3 * (level + 1))) - 1) / 7)) {level++;}
+      int64_t first = (((int64_t) 1 << (3 * level)) - 1) / 7;
+      int64_t end   = (iter->first - first + 1) << (minShift + 3 * (depth - level));
+      if (end > length) {length = end;}
+    }
+  }
+
+  return (length > INT_MAX) ? INT_MAX : (int) length;
+}
+
+// Sort the chunks and merge any that overlap or are adjacent.
+void tabixIndex::mergeChunks(vector<indexChunk>& chunks) {
+  if (chunks.size() < 2) {return;}
+
+  sort(chunks.begin(), chunks.end(), compareChunks);
+  vector<indexChunk>::iterator last = chunks.begin();
+  for (vector<indexChunk>::iterator iter = chunks.begin() + 1; iter != chunks.end(); iter++) {
+    if (iter->start <= last->end) {
+      if (iter->end > last->end) {last->end = iter->end;}
+    } else {
+      *(++last) = *iter;
+    }
+  }
+  chunks.erase(last + 1, chunks.end());
+}
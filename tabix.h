@@ -0,0 +1,80 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define the tabix/CSI index reader used for random
+// access to regions of BGZF compressed files.
+// ******************************************************
+
+#ifndef TABIX_H
+#define TABIX_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <zlib.h>
+
+using namespace std;
+
+namespace vcfCTools {
+
+// A chunk of the compressed file, given as BGZF virtual offsets (the
+// offset of the block in the file shifted left 16 bits, plus the offset
+// within the uncompressed block).
+struct indexChunk {
+  uint64_t start;
+  uint64_t end;
+};
+
+// A genomic region.  Coordinates are 1-based and inclusive.
+struct genomicRegion {
+  string referenceSequence;
+  int start;
+  int end;
+};
+
+// The bins and linear index for a single reference sequence.  CSI
+// indexes store the smallest offset for each bin in place of the linear
+// index.
+struct indexReference {
+  map<unsigned int, vector<indexChunk> > bins;
+  map<unsigned int, uint64_t> binOffsets;
+  vector<uint64_t> linearIndex;
+};
+
+// The index.  Both the tabix (.tbi) and the CSI (.csi) formats are
+// supported.  Tabix indexes are the special case of a CSI index with a
+// minimum interval of 16kb and five levels of bins.
+class tabixIndex {
+  public:
+    tabixIndex(void);
+    ~tabixIndex(void);
+    bool openIndex(string&);
+    void query(genomicRegion&, vector<indexChunk>&);
+    int sequenceLength(unsigned int);
+    static void mergeChunks(vector<indexChunk>&);
+
+  public:
+    bool readIndex(gzFile, string&);
+    bool readNames(const char*, int);
+    void regionToBins(int64_t, int64_t, vector<unsigned int>&);
+    uint64_t minimumOffset(indexReference&, int64_t);
+
+  public:
+    bool isCsi;
+    string indexFilename;
+    int minShift;
+    int depth;
+    vector<string> sequenceNames;
+    map<string, unsigned int> sequenceIDs;
+    vector<indexReference> references;
+};
+
+} // namespace vcfCTools
+
+#endif // TABIX_H
@@ -0,0 +1,137 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Simple pool of worker threads.
+// ******************************************************
+
+#include "thread_pool.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Constructor.
+threadJob::threadJob(void) {
+  finished = true;
+}
+
+// Destructor.
+threadJob::~threadJob(void) {}
+
+// The function run by each of the worker threads.  Take jobs from the
+// queue until the pool is shut down.
+static void* runWorker(void* arg) {
+  threadPool* pool = (threadPool*) arg;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (pool->jobs.empty() && !pool->shutdown) {pthread_cond_wait(&pool->jobAvailable, &pool->mutex);}
+    if (pool->jobs.empty() && pool->shutdown) {break;}
+
+    threadJob* job = pool->jobs.front();
+    pool->jobs.pop_front();
+    pthread_mutex_unlock(&pool->mutex);
+
+    job->run();
+
+    pthread_mutex_lock(&pool->mutex);
+    job->finished = true;
+    pool->activeJobs--;
+    pthread_cond_broadcast(&pool->jobFinished);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+// Constructor.
+threadPool::threadPool(void) {
+  activeJobs    = 0;
+  numberThreads = 0;
+  shutdown      = false;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&jobAvailable, NULL);
+  pthread_cond_init(&jobFinished, NULL);
+}
+
+// Destructor.
+threadPool::~threadPool(void) {
+  stopThreads();
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&jobAvailable);
+  pthread_cond_destroy(&jobFinished);
+}
+
+// Determine the number of processor cores available.
+unsigned int threadPool::availableCores() {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (cores > 0) ? (unsigned int) cores : 1;
+}
+
+// Start the worker threads.
+void threadPool::startThreads(unsigned int number) {
+  stopThreads();
+  shutdown = false;
+  for (unsigned int i = 0; i < number; i++) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, runWorker, this) != 0) {
+      cerr << "ERROR: Unable to create worker thread." << endl;
+      exit(1);
+    }
+    threads.push_back(thread);
+  }
+  numberThreads = threads.size();
+}
+
+// Finish all outstanding jobs and stop the worker threads.
+void threadPool::stopThreads() {
+  if (threads.size() == 0) {return;}
+
+  pthread_mutex_lock(&mutex);
+  shutdown = true;
+  pthread_cond_broadcast(&jobAvailable);
+  pthread_mutex_unlock(&mutex);
+
+  for (vector<pthread_t>::iterator iter = threads.begin(); iter != threads.end(); iter++) {pthread_join(*iter, NULL);}
+  threads.clear();
+  numberThreads = 0;
+}
+
+// Add a job to the queue.  If there are no worker threads, run the
+// job now.
+void threadPool::submit(threadJob* job) {
+  if (numberThreads == 0) {
+    job->finished = false;
+    job->run();
+    job->finished = true;
+    return;
+  }
+
+  pthread_mutex_lock(&mutex);
+  job->finished = false;
+  jobs.push_back(job);
+  activeJobs++;
+  pthread_cond_signal(&jobAvailable);
+  pthread_mutex_unlock(&mutex);
+}
+
+// Wait until a particular job has completed.
+void threadPool::waitFor(threadJob* job) {
+  pthread_mutex_lock(&mutex);
+  while (!job->finished) {pthread_cond_wait(&jobFinished, &mutex);}
+  pthread_mutex_unlock(&mutex);
+}
+
+// Wait until all submitted jobs have completed.
+void threadPool::waitAll() {
+  pthread_mutex_lock(&mutex);
+  while (activeJobs != 0) {pthread_cond_wait(&jobFinished, &mutex);}
+  pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,64 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Define a simple pool of worker threads.
+// ******************************************************
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+namespace vcfCTools {
+
+// A unit of work that can be handed to the thread pool.  The run
+// method is executed on one of the worker threads and the finished
+// flag is set (under the pool's lock) when it completes.
+class threadJob {
+  public:
+    threadJob(void);
+    virtual ~threadJob(void);
+    virtual void run() = 0;
+
+  public:
+    bool finished;
+};
+
+// The thread pool.  Jobs are taken from a single queue by whichever
+// worker is free.  If the pool is started with no threads, jobs are
+// run immediately by the submitting thread.
+class threadPool {
+  public:
+    threadPool(void);
+    ~threadPool(void);
+    void startThreads(unsigned int);
+    void stopThreads();
+    void submit(threadJob*);
+    void waitFor(threadJob*);
+    void waitAll();
+    static unsigned int availableCores();
+
+  public:
+    unsigned int numberThreads;
+    unsigned int activeJobs;
+    bool shutdown;
+    deque<threadJob*> jobs;
+    vector<pthread_t> threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t jobAvailable;
+    pthread_cond_t jobFinished;
+};
+
+} // namespace vcfCTools
+
+#endif // THREAD_POOL_H
@@ -46,6 +46,8 @@ int annotateTool::Help(void) {
   cout << "	display intersect help." << endl;
   cout << "  -i, --in" << endl;
   cout << "	input vcf file." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "	only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -o, --output" << endl;
   cout << "	output vcf file." << endl;
   cout << "  -a, --annotation-vcf" << endl;
@@ -90,6 +92,7 @@ int annotateTool::parseCommandLine(int argc, char* argv[]) {
   static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"in", required_argument, 0, 'i'},
+    {"region", required_argument, 0, 'R'},
     {"out", required_argument, 0, 'o'},
     {"dbsnp", required_argument, 0, 'd'},
     {"annotation-vcf", required_argument, 0, 'a'},
@@ -107,7 +110,7 @@ int annotateTool::parseCommandLine(int argc, char* argv[]) {
   };
 
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hi:o:a:b:d:w:s123456", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hi:o:a:b:d:w:s123456R:", long_options, &option_index);
 
     if (argument == -1) {break;}
     switch (argument) {
@@ -117,6 +120,11 @@ int annotateTool::parseCommandLine(int argc, char* argv[]) {
         vcfFile = optarg;
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
       // Ouput vcf file.
       case 'o':
         outputFile = optarg;
@@ -244,6 +252,9 @@ int annotateTool::Run(int argc, char* argv[]) {
   vcfHeader header;
   header.parseHeader(v.input);
 
+  // Restrict the records read to the requested regions.
+  if (region != "") {v.setRegions(region);}
+
   // Add an extra line to the vcf header to indicate the file used for
   // performing dbsnp annotation.
   string taskDescription = "##vcfCTools=annotated vcf file with ";
@@ -273,8 +284,17 @@ int annotateTool::Run(int argc, char* argv[]) {
     // Define a header object and parse the header of the annotation vcf file.
     vcfHeader annHeader;
     annHeader.parseHeader(annVcf.input);
+
+    // Restrict the records read to the requested regions.
+    if (region != "") {annVcf.setRegions(region);}
+
     if (annotateDbsnp) {annVar.isDbsnp = true;}
 
+    // Read both files and write the output on separate threads.
+    v.startReader();
+    annVcf.startReader();
+    ofile.startWriter();
+
     // Perform the annotation by intersecting the two vcf files.
     ints.intersectVcf(header, annHeader, v, var, annVcf, annVar, ofile);
 
@@ -298,6 +318,10 @@ int annotateTool::Run(int argc, char* argv[]) {
     b.openBed(bedFile);
     b.parseHeader(bedFile);
 
+    // Read the vcf file and write the output on separate threads.
+    v.startReader();
+    ofile.startWriter();
+
     // Perform the annotation by intersecting the vcf file with the bed file.
     ints.intersectVcfBed(header, v, var, b, bs, ofile);
 
@@ -307,5 +331,8 @@ int annotateTool::Run(int argc, char* argv[]) {
     v.closeVcf();
   }
 
+  // Close the output file.
+  ofile.closeOutputFile();
+
   return 0;
 }
@@ -43,6 +43,7 @@ class annotateTool : public AbstractTool {
     string commandLine;
     string vcfFile;
     string outputFile;
+    string region;
     string annVcfFile;
     string bedFile;
     string currentReferenceSequence;
@@ -20,27 +20,32 @@ using namespace vcfCTools;
 filterTool::filterTool(void)
   : AbstractTool()
 {
-  appliedFilters           = false;
-  cleardbSnp               = false;
-  conditionalFilter        = false;
-  currentReferenceSequence = "";
-  filterFail               = false;
-  filterQuality            = false;
-  filterString             = "";
-  findHets                 = false;
-  keepRecords              = false;
-  markPass                 = false;
-  processComplex           = false;
-  processIndels            = false;
-  processMnps              = false;
-  processRearrangements    = false;
-  processSnps              = false;
-  processSvs               = false;
-  removeGenotypes          = false;
-  removeInfo               = false;
-  splitMnps                = false;
-  stripRecords             = false;
-  useSampleList            = false;
+  appliedFilters        = false;
+  chunkSize             = 0;
+  cleardbSnp            = false;
+  conditionalFilter     = false;
+  filterFail            = false;
+  filterExpressionSet   = false;
+  filterQuality         = false;
+  filterString          = "";
+  findHets              = false;
+  keepRecords           = false;
+  markPass              = false;
+  maskDepthValue        = 0.;
+  maskGenotypes         = false;
+  maskQualityValue      = 0.;
+  processComplex        = false;
+  processIndels         = false;
+  processMnps           = false;
+  processRearrangements = false;
+  processSnps           = false;
+  processSvs            = false;
+  removeGenotypes       = false;
+  removeInfo            = false;
+  splitMnps             = false;
+  stripRecords          = false;
+  threads               = 1;
+  useSampleList         = false;
 }
 
 // Destructor.
@@ -56,8 +61,14 @@ int filterTool::Help(void) {
   cout << "	display intersect help." << endl;
   cout << "  -i, --in" << endl;
   cout << "	input vcf files (two, or one if intersecting with bed file)." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "	only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -o, --out" << endl;
   cout << "	output vcf file." << endl;
+  cout << "  -j, --threads" << endl;
+  cout << "	process the regions of an indexed file on this many threads." << endl;
+  cout << "  -z, --chunk-size" << endl;
+  cout << "	split the reference sequences into chunks of this many bases when using multiple threads." << endl;
   //cout << "  -c, --clear-dbsnp" << endl;
   //cout << "	clear the rsid field and remove dbSNP info flag." << endl;
   //cout << "  -d, --delete-info" << endl;
@@ -74,10 +85,19 @@ int filterTool::Help(void) {
   cout << "	split MNPs into SNPs." << endl;
   cout << "  -q, --quality" << endl;
   cout << "	filter on variant quality." << endl;
+  cout << "  -x, --expr" << endl;
+  cout << "	filter out records failing the expression, e.g. 'QUAL>30 && INFO/DP>10 && INFO/AF<0.01'." << endl;
+  cout << "	values are QUAL, POS, numbers, INFO/TAG (or INFO/TAG[n] for the nth value) and FORMAT/TAG" << endl;
+  cout << "	(true if any sample matches).  An info tag on its own tests that the field is present." << endl;
+  cout << "	terms are compared with <, <=, >, >=, == and != and combined with &&, ||, ! and brackets." << endl;
   cout << "  -r, --remove-genotypes" << endl;
   cout << "	do not include genotypes in the output vcf file." << endl;
-  //cout << "  -s, --samples" << endl;
-  //cout << "	output variants that occur in the provided list of samples.." << endl;
+  cout << "  -G, --mask-genotype-quality" << endl;
+  cout << "	set the genotypes of samples with genotype quality (GQ) below this value to missing." << endl;
+  cout << "  -D, --mask-genotype-depth" << endl;
+  cout << "	set the genotypes of samples with depth (DP) below this value to missing." << endl;
+  cout << "  -s, --samples" << endl;
+  cout << "	only keep records where a sample in the provided list (one per line) has a non-reference allele." << endl;
   //cout << "  -t, --strip-records" << endl;
   //cout << "	strip out records containing the specified info field (comma separated list)." << endl;
   cout << "  -1, --snps" << endl;
@@ -113,7 +133,10 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
     static struct option long_options[] = {
       {"help", no_argument, 0, 'h'},
       {"in", required_argument, 0, 'i'},
+      {"region", required_argument, 0, 'R'},
       {"out", required_argument, 0, 'o'},
+      {"threads", required_argument, 0, 'j'},
+      {"chunk-size", required_argument, 0, 'z'},
       {"split-mnps", no_argument, 0, 'p'},
       {"clear-dbsnp", no_argument, 0, 'c'},
       {"delete-info", required_argument, 0, 'd'},
@@ -122,7 +145,10 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
       {"find-hets",no_argument, 0, 'e'},
       {"mark-as-pass", no_argument, 0, 'm'},
       {"quality", required_argument, 0, 'q'},
+      {"expr", required_argument, 0, 'x'},
       {"remove-genotypes", required_argument, 0, 'r'},
+      {"mask-genotype-quality", required_argument, 0, 'G'},
+      {"mask-genotype-depth", required_argument, 0, 'D'},
       {"samples", required_argument, 0, 's'},
       {"strip-records", required_argument, 0, 't'},
       {"snps", no_argument, 0, '1'},
@@ -136,7 +162,7 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
     };
 
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hi:o:cd:k:elpq:mrs:t:123456", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hi:o:cd:k:elpq:mrs:t:x:G:D:123456R:j:z:", long_options, &option_index);
 
     if (argument == -1) {break;}
     switch (argument) {
@@ -146,11 +172,26 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
         vcfFile = optarg;
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
       // Output vcf file.
       case 'o':
         outputFile = optarg;
         break;
 
+      // Number of threads.
+      case 'j':
+        threads = atoi(optarg);
+        break;
+
+      // Size of the chunks processed on each thread.
+      case 'z':
+        chunkSize = atoi(optarg);
+        break;
+
       // Clear the rsid field and the dbSNP info tag.
       case 'c':
         cleardbSnp = true;
@@ -197,6 +238,24 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
         filterQualityValue = atof(value);
         break;
 
+      // Filter on an expression.
+      case 'x':
+        filterExpressionSet = true;
+        appliedFilters      = true;
+        expressionString    = optarg;
+        break;
+
+      // Set low quality or low depth genotypes to missing.
+      case 'G':
+        maskGenotypes    = true;
+        maskQualityValue = atof(optarg);
+        break;
+
+      case 'D':
+        maskGenotypes  = true;
+        maskDepthValue = atof(optarg);
+        break;
+
       // Remove genotypes from the output file.
       case 'r':
         removeGenotypes = true;
@@ -274,6 +333,12 @@ int filterTool::parseCommandLine(int argc, char* argv[]) {
      exit(1);
    }
 
+// Check the number of threads and the chunk size.
+  if (threads < 1 || chunkSize < 0) {
+    cerr << "ERROR: --threads (-j) must be at least 1 and --chunk-size (-z) cannot be negative." << endl;
+    exit(1);
+  }
+
 // If keepRecords and stripRecords have been simultaneously specified, terminate
 // with an error.  This situation could lead to ambiguous decisions.
   if (stripRecords && keepRecords) {
@@ -303,7 +368,7 @@ vector<string> filterTool::checkInfoFields(vcfHeader& header, vcf& v, string& in
 }
 
 // Perform the required filtering tasks on the variants.
-void filterTool::filter(variant& var) {
+void filterTool::filter(variant& var, filterExpression& recordExpression, sampleFilter& recordGenotypeFilter) {
 
   // Loop over all records at this locus.
   var.ovIter = var.ovmIter->second.begin();
@@ -328,15 +393,27 @@ void filterTool::filter(variant& var) {
         filterString = (filterString != "") ? filterString + ";" + "Q" + s.str() : "Q" + s.str();
       }
     }
+
+    // Check the filter expression.
+    if (filterExpressionSet && !markPass) {
+      if (!recordExpression.evaluate(*var.ovIter)) {
+        filterString = (filterString != "") ? filterString + ";EXPR" : "EXPR";
+      }
+    }
   
     // If the filterString is blank, the record didn't fail any of the filters
     // so set the filter field to PASS, otherwise set it to the filter string.
     filterString = (filterString == "") ? "." : filterString;
     var.ovIter->filters = (filterString == "." && appliedFilters) ? "PASS" : filterString;
 
+    // Apply the sample level filters.  Records without a non-reference
+    // genotype in the sample list are removed.
+    bool keepRecord = true;
+    if (maskGenotypes || useSampleList) {keepRecord = recordGenotypeFilter.filterGenotypes(*var.ovIter);}
+
     // If only records marked as PASS as to be kept, check the value and update the
     // filtered vector as necessary.
-    if (filterFail && var.ovIter->filters != "PASS") {
+    if (!keepRecord || (filterFail && var.ovIter->filters != "PASS")) {
       vector<bool>::iterator fIter = var.ovIter->filtered.begin();
       for (; fIter != var.ovIter->filtered.end(); fIter++) {*fIter = true;}
     }
@@ -567,9 +644,8 @@ void filterTool::performFilter(vcf& v, int position, variantDescription& varIter
 //  }
 }
 
-// Run the tool.
-int filterTool::Run(int argc, char* argv[]) {
-  int getOptions = filterTool::parseCommandLine(argc, argv);
+// Define the variants to be processed.
+void filterTool::initialiseVariant(variant& var) {
 
   // Depending on the filtering being performed, it may or may not be necessary
   // to look at each individual allele.  For example, if the only action is to
@@ -578,6 +654,49 @@ int filterTool::Run(int argc, char* argv[]) {
   //bool processAlleles = (stripRecords || findHets || keepRecords || splitMnps || useSampleList) ? true : false;
   bool processAlleles = true;
 
+  var.determineVariantsToProcess(processSnps, processMnps, processIndels, processComplex, processSvs, processRearrangements, splitMnps, processAlleles, false);
+
+  // If the genotypes are to be removed, set the removeGenotypes value to 
+  // true for the variant object.
+  if (removeGenotypes) {var.removeGenotypes = true;}
+}
+
+// Filter all of the records read from the vcf file.
+void filterTool::filterRecords(vcfHeader& header, vcf& v, variant& var, output& ofile, filterExpression& recordExpression, sampleFilter& recordGenotypeFilter) {
+  unsigned int currentReferenceSequenceID = NO_CONTIG;
+
+  // Get the first record from the vcf file.
+  v.success = v.getRecord();
+  while (v.success) {
+
+    // Build the variant structure for this reference sequence.
+    if (var.originalVariantsMap.size() == 0) {
+      currentReferenceSequenceID = v.variantRecord.referenceSequenceID;
+      v.success                  = var.buildVariantStructure(v);
+    }
+
+    // Loop over the variant structure until it is empty.  While v.update is true,
+    // i.e. when the reference sequence is still the current reference sequence,
+    // keep adding variants to the structure.
+    while (var.originalVariantsMap.size() != 0) {
+      if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
+        var.addVariantToStructure(v.position, v.variantRecord);
+        v.success = v.getRecord();
+      }
+      var.ovmIter = var.originalVariantsMap.begin();
+
+      // Perform all filtering tasks on this variant.
+      filter(var, recordExpression, recordGenotypeFilter);
+      var.buildOutputRecord(ofile, header);
+      var.originalVariantsMap.erase(var.ovmIter);
+    }
+  }
+}
+
+// Run the tool.
+int filterTool::Run(int argc, char* argv[]) {
+  int getOptions = filterTool::parseCommandLine(argc, argv);
+
   // Define an output object and open the output file.
   output ofile;
   ofile.outputStream = ofile.openOutputFile(outputFile);
@@ -590,13 +709,20 @@ int filterTool::Run(int argc, char* argv[]) {
   vcfHeader header;
   header.parseHeader(v.input);
 
-  // Define the variant object.
-  variant var;
-  var.determineVariantsToProcess(processSnps, processMnps, processIndels, processComplex, processSvs, processRearrangements, splitMnps, processAlleles, false);
+  // Restrict the records read to the requested regions.
+  if (region != "") {v.setRegions(region);}
 
   string taskDescription = "##vcfCTools=filter";
   if (markPass) {taskDescription += "marked all records as PASS";}
 
+  // Compile the filter expression against the info descriptions in the
+  // header.
+  if (filterExpressionSet) {
+    expression.compile(expressionString, header);
+    taskDescription += " filtered on " + expressionString;
+    header.filterLine["EXPR"] = "##FILTER=<ID=EXPR,Description=\"Failed the filter expression: " + expressionString + "\">";
+  }
+
   // If MNPs are to be broken up, add a line to the header explaining this.
   if (splitMnps) {
     string text = "Indicates that this SNP was generated from the decomposition of an MNP.\">";
@@ -613,18 +739,32 @@ int filterTool::Run(int argc, char* argv[]) {
   // Add an information line to the header describing the HET info.
   //if (findHets) {v.headerInfoLine["HET"] = "##INFO=<ID=HET,Number=.,Type=String,Description=\"List of samples heterozygous at this locus.\">";}
 
-  // If variants that are found in the list of provided samples are to be outputted,
-  // check that genotypes exist and that the provided file contains at least one 
-  // sample.  Also check that the samples provided exist in the vcf file.
-  //if (useSampleList) {
-  //  samples sl; // Create a samples list object.
-  //  sl.openSamplesFile(samplesListFile);
-  //  sl.getSamples(v);
-  //}
+  // Set up the sample level filters.
+  if (maskGenotypes) {
+    genotypeFilter.maskLowGenotypes = true;
+    genotypeFilter.minQuality       = maskQualityValue;
+    genotypeFilter.minDepth         = maskDepthValue;
+    ostringstream s;
+    s << " masked genotypes with GQ<" << maskQualityValue << " or DP<" << maskDepthValue;
+    taskDescription += s.str();
+  }
 
-  // If the genotypes are to be removed, set the removeGenotypes value to 
-  // true for the vcf object.
-  if (removeGenotypes) {var.removeGenotypes = true;}
+  // If variants that are found in the list of provided samples are to be outputted,
+  // check that the provided file contains at least one sample that exists in the
+  // vcf file.
+  if (useSampleList) {
+    samples sl; // Create a samples list object.
+    sl.openSamplesFile(samplesListFile);
+    sl.getSamples(header);
+    if (sl.noSamples == 0) {
+      cerr << "ERROR: None of the samples in " << samplesListFile << " are present in the vcf file." << endl;
+      exit(1);
+    }
+    vector<unsigned int> ordinals;
+    for (map<string, int>::iterator iter = sl.samplesMap.begin(); iter != sl.samplesMap.end(); iter++) {ordinals.push_back(iter->second);}
+    genotypeFilter.setSamples(ordinals);
+    taskDescription += " kept records with non-reference genotypes in the samples in " + samplesListFile;
+  }
 
   // If records are to be stripped out of the vcf file, check the inputted
   // IDs and populate the list of IDs to be stripped.
@@ -669,31 +809,30 @@ int filterTool::Run(int argc, char* argv[]) {
 //    genotypePosition = count;
 //  }
 
-  // Get the first record from the vcf file.
-  v.success = v.getRecord();
-  while (v.success) {
-
-    // Build the variant structure for this reference sequence.
-    if (var.originalVariantsMap.size() == 0) {
-      currentReferenceSequence = v.variantRecord.referenceSequence;
-      v.success                = var.buildVariantStructure(v);
+  // If multiple threads are to be used, filter each region of the file
+  // on a separate thread, writing out the filtered records in file order.
+  parallelRegions parallel;
+  if (threads > 1 && parallel.openIndex(vcfFile)) {
+    vector<regionJob*> jobs;
+
+    parallel.buildTasks(region, chunkSize);
+    for (unsigned int i = 0; i < parallel.tasks.size(); i++) {jobs.push_back(new filterJob(this));}
+    parallel.start(jobs, threads);
+    for (vector<regionJob*>::iterator iter = jobs.begin(); iter != jobs.end(); iter++) {
+      parallel.waitFor(*iter);
+      cerr << (*iter)->errors.str();
+      *ofile.outputStream << (*iter)->records.str();
+      delete *iter;
     }
 
-    // Loop over the variant structure until it is empty.  While v.update is true,
-    // i.e. when the reference sequence is still the current reference sequence,
-    // keep adding variants to the structure.
-    while (var.originalVariantsMap.size() != 0) {
-      if (v.variantRecord.referenceSequence == currentReferenceSequence && v.success) {
-        var.addVariantToStructure(v.position, v.variantRecord);
-        v.success = v.getRecord();
-      }
-      var.ovmIter = var.originalVariantsMap.begin();
-
-      // Perform all filtering tasks on this variant.
-      filter(var);
-      var.buildOutputRecord(ofile, header);
-      var.originalVariantsMap.erase(var.ovmIter);
-    }
+  // Otherwise, filter the records on this thread while the file is read
+  // and the output written on separate threads.
+  } else {
+    variant var;
+    initialiseVariant(var);
+    v.startReader();
+    ofile.startWriter();
+    filterRecords(header, v, var, ofile, expression, genotypeFilter);
   }
 
   // Close the vcf files.
@@ -701,6 +840,28 @@ int filterTool::Run(int argc, char* argv[]) {
 
   // Flush the output buffer.
   ofile.flushOutputBuffer();
+  ofile.closeOutputFile();
 
   return 0;
 }
+
+// filterJob implementation.
+filterJob::filterJob(filterTool* parent) {
+  tool           = parent;
+  expression     = parent->expression;
+  genotypeFilter = parent->genotypeFilter;
+}
+
+// Filter the records in the region, keeping the output until the job is
+// collected.
+void filterJob::processRegion(vcfHeader& header, vcf& v) {
+  output ofile;
+  variant var;
+
+  ofile.outputStream = &records;
+  tool->initialiseVariant(var);
+  var.errorStream = &errors;
+  v.errorStream   = &errors;
+  tool->filterRecords(header, v, var, ofile, expression, genotypeFilter);
+  ofile.flushOutputBuffer();
+}
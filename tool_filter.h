@@ -14,9 +14,12 @@
 #ifndef TOOL_FILTER_H
 #define TOOL_FILTER_H
 
+#include "filter_expression.h"
 #include "header.h"
 #include "info.h"
 #include "output.h"
+#include "parallel.h"
+#include "sample_filter.h"
 #include "samples.h"
 #include "tools.h"
 #include "variant.h"
@@ -40,14 +43,29 @@ class filterTool : public AbstractTool {
     int Run(int argc, char* argv[]);
     int parseCommandLine(int argc, char* argv[]);
     vector<string> checkInfoFields(vcfHeader&, vcf&, string&);
-    void filter(variant&);
+    void filter(variant&, filterExpression&, sampleFilter&);
+    void filterRecords(vcfHeader&, vcf&, variant&, output&, filterExpression&, sampleFilter&);
+    void initialiseVariant(variant&);
     void performFilter(vcf&, int, variantDescription&);
 
+  public:
+
+    // The compiled filter expression and the sample level filters.  Each
+    // thread uses its own copy.
+    filterExpression expression;
+    sampleFilter genotypeFilter;
+
   private:
     string commandLine;
     string vcfFile;
     string outputFile;
+    string region;
+    int threads;
+    int chunkSize;
     double filterQualityValue;
+    double maskQualityValue;
+    double maskDepthValue;
+    string expressionString;
     string removeInfoString;
     vector<string> removeInfoList;
     string keepInfoFields;
@@ -56,7 +74,6 @@ class filterTool : public AbstractTool {
     vector<string> stripInfoList;
     bool writeRecord;
     bool conditionalFilter;
-    string currentReferenceSequence;
     string filterString;
     unsigned int genotypePosition;
     string samplesListFile;
@@ -66,9 +83,11 @@ class filterTool : public AbstractTool {
     bool cleardbSnp;
     bool filterFail;
     bool filterQuality;
+    bool filterExpressionSet;
     bool findHets;
     bool keepRecords;
     bool markPass;
+    bool maskGenotypes;
     bool processComplex;
     bool processIndels;
     bool processMnps;
@@ -82,6 +101,19 @@ class filterTool : public AbstractTool {
     bool useSampleList;
 };
 
+// Filter the records in a single region when running on multiple
+// threads.
+class filterJob : public regionJob {
+  public:
+    filterJob(filterTool*);
+    void processRegion(vcfHeader&, vcf&);
+
+  public:
+    filterTool* tool;
+    filterExpression expression;
+    sampleFilter genotypeFilter;
+};
+
 } // namespace vcfCTools
 
 #endif
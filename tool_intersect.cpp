@@ -18,12 +18,15 @@ using namespace vcfCTools;
 intersectTool::intersectTool(void)
   : AbstractTool()
 {
+  addSources               = false;
   distanceDistribution     = false;
   allowMismatch            = false;
   passFilters              = false;
   findCommon               = false;
   findUnion                = false;
   findUnique               = false;
+  minimumFiles             = 0;
+  multipleFiles            = false;
   sitesOnly                = false;
   processComplex           = false;
   processIndels            = false;
@@ -47,7 +50,9 @@ int intersectTool::Help(void) {
   cout << "  -h, --help" << endl;
   cout << "	display intersect help." << endl;
   cout << "  -i, --in" << endl;
-  cout << "	input vcf files (two, or one if intersecting with bed file)." << endl;
+  cout << "	input vcf files (two or more, or one if intersecting with bed file)." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "	only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -b, --bed" << endl;
   cout << "	input bed file." << endl;
   cout << "  -o, --output" << endl;
@@ -62,6 +67,12 @@ int intersectTool::Help(void) {
   cout << "	output variants unique to one of the files." << endl;
   cout << "  -u, --union" << endl;
   cout << "	output variants present in either file." << endl;
+  cout << "  -k, --at-least" << endl;
+  cout << "	output variants present in at least this many of the files." << endl;
+  cout << "  -M, --membership" << endl;
+  cout << "	output variants present in exactly the files marked 1 in a string of 0s and 1s (one per file)." << endl;
+  cout << "  -t, --tag-sources" << endl;
+  cout << "	add the files containing each variant (numbered from 1) to the info field (SOURCES)." << endl;
   cout << "  -s, --sites-only" << endl;
   cout << "	only compare files based on sites.  Do not evaluate the alleles." << endl;
   cout << "  -p, --pass-filters" << endl;
@@ -88,6 +99,12 @@ int intersectTool::Help(void) {
   cout << "  b: Write out records from the second file." << endl;
   cout << "  q: Write out records with the highest variant quality." << endl;
   cout << endl;
+  cout << "  If more than two vcf files are given, or any of -k, -M or -t are used, all" << endl;
+  cout << "  of the files are intersected in one pass.  -c finds variants in all of the" << endl;
+  cout << "  files, -u in any file and -q in only the file given by the argument (a for" << endl;
+  cout << "  the first file, b for the second and so on).  Each variant is written out" << endl;
+  cout << "  from the first file in which it appears." << endl;
+  cout << endl;
   exit(0);
 
   return 0;
@@ -109,12 +126,16 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
     {"bed", required_argument, 0, 'b'},
     {"common", required_argument, 0, 'c'},
     {"in", required_argument, 0, 'i'},
+    {"region", required_argument, 0, 'R'},
     {"out", required_argument, 0, 'o'},
     {"distance", no_argument, 0, 'd'},
     {"mismatch", no_argument, 0, 'm'},
     {"pass-filters", no_argument, 0, 'p'},
     {"unique", required_argument, 0, 'q'},
     {"union", required_argument, 0, 'u'},
+    {"at-least", required_argument, 0, 'k'},
+    {"membership", required_argument, 0, 'M'},
+    {"tag-sources", no_argument, 0, 't'},
     {"sites-only", no_argument, 0, 's'},
     {"wholly-within-interval", no_argument, 0, 'w'},
     {"snps", no_argument, 0, '1'},
@@ -129,7 +150,7 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
 
   while (true) {
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hb:i:o:dmpc:u:q:sw123456", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hb:i:o:dmpc:u:q:k:M:tsw123456R:", long_options, &option_index);
 
     if (argument == -1) {break;}
     switch (argument) {
@@ -149,6 +170,11 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
         vcfFiles.push_back(optarg);
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
       // Help.
       case 'h':
         return Help();
@@ -176,6 +202,24 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
         writeFrom = optarg;
         break;
 
+      // Find variants present in at least this many files.
+      case 'k':
+        minimumFiles  = atoi(optarg);
+        multipleFiles = true;
+        break;
+
+      // Find variants present in exactly the given files.
+      case 'M':
+        membership    = optarg;
+        multipleFiles = true;
+        break;
+
+      // Add the files containing the variants to the info field.
+      case 't':
+        addSources    = true;
+        multipleFiles = true;
+        break;
+
       // Determine if comparing for exact matches or not.
       case 'm':
         allowMismatch = true;
@@ -245,6 +289,21 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
   }
 
 // Check that either two vcf files or one vcf and one bed file is specified.
+// More than two vcf files are intersected together in a single pass.
+  if (vcfFiles.size() > 2 && bedFile == "") {multipleFiles = true;}
+  if (multipleFiles) {
+    if (bedFile != "" || vcfFiles.size() < 2) {
+      cerr << "At least two vcf files and no bed file must be specified to intersect multiple files (--in, -i)." << endl;
+      exit(1);
+    } else if (vcfFiles.size() > MAX_INTERSECT_FILES) {
+      cerr << "At most " << MAX_INTERSECT_FILES << " vcf files can be intersected at once." << endl;
+      exit(1);
+    }
+    checkMultipleFileOperation();
+
+    return 0;
+  }
+
   if (vcfFiles.size() == 0 || (vcfFiles.size() == 1 and bedFile == "") || (bedFile != "" && vcfFiles.size() != 1) || vcfFiles.size() > 2) {
     cerr << "Two vcf files or a vcf and a bed file must be specified (--in, -i, --bed, -b)." << endl;
     exit(1);
@@ -272,6 +331,37 @@ int intersectTool::parseCommandLine(int argc, char* argv[]) {
   return 0;
 }
 
+// Check that one operation has been selected for the intersection of multiple
+// files and convert it to the number of files or the exact set of files that
+// must contain each variant.
+void intersectTool::checkMultipleFileOperation() {
+  if ( (findCommon + findUnion + findUnique + (minimumFiles != 0) + (membership != "")) != 1) {
+    cerr << "One operation (-c [--common], -u [--union], -q [--unique], -k [--at-least] or -M [--membership]) must be selected." << endl;
+    exit(1);
+  }
+
+  if (findCommon) {minimumFiles = vcfFiles.size();}
+  else if (findUnion) {minimumFiles = 1;}
+  else if (findUnique) {
+    if (writeFrom.size() != 1 || writeFrom[0] < 'a' || (unsigned int) (writeFrom[0] - 'a') >= vcfFiles.size()) {
+      cerr << "The file whose unique variants are required needs to be selected (a for the first file, b for the second etc.)." << endl;
+      exit(1);
+    }
+    membership = string(vcfFiles.size(), '0');
+    membership[writeFrom[0] - 'a'] = '1';
+  } else if (minimumFiles > vcfFiles.size()) {
+    cerr << "The number of files required (-k, --at-least) is larger than the number of files." << endl;
+    exit(1);
+  }
+
+  if (membership != "") {
+    if (membership.size() != vcfFiles.size() || membership.find_first_not_of("01") != string::npos) {
+      cerr << "The membership (-M, --membership) must have a 0 or 1 for each vcf file." << endl;
+      exit(1);
+    }
+  }
+}
+
 // Run the tool.
 int intersectTool::Run(int argc, char* argv[]) {
   int getOptions = intersectTool::parseCommandLine(argc, argv);
@@ -285,9 +375,59 @@ int intersectTool::Run(int argc, char* argv[]) {
   if (writeFrom == "a") {ints.flags.writeFromFirst = true;}
   else if (writeFrom == "b") {ints.flags.writeFromFirst = false;}
 
+  // Intersect any number of vcf files in one pass.
+  if (multipleFiles) {
+    vector<vcf*> files;
+    vector<variant*> variants;
+    vector<vcfHeader*> headers;
+    string taskDescription = "##vcfCTools=intersect ";
+    for (unsigned int file = 0; file < vcfFiles.size(); file++) {
+      files.push_back(new vcf());
+      files[file]->openVcf(vcfFiles[file]);
+      variants.push_back(new variant());
+      variants[file]->determineVariantsToProcess(processSnps, processMnps, processIndels, processComplex, processSvs, processRearrangements, false, true, true);
+      headers.push_back(new vcfHeader());
+      headers[file]->parseHeader(files[file]->input);
+      if (region != "") {files[file]->setRegions(region);}
+
+      if (headers[file]->samples != headers[0]->samples) {cerr << "WARNING: Different samples in file: " << vcfFiles[file] << endl;}
+      taskDescription += (file == 0) ? vcfFiles[file] : ", " + vcfFiles[file];
+    }
+
+    // Set the operation.  Each character of the membership is the file
+    // at the same position.
+    ints.minimumFiles = minimumFiles;
+    ints.addSources   = addSources;
+    if (membership != "") {
+      ints.exactMembership = true;
+      for (unsigned int file = 0; file < membership.size(); file++) {
+        if (membership[file] == '1') {ints.membership |= (uint64_t) 1 << file;}
+      }
+    }
+
+    // Records are built with the header of the file they come from, so the
+    // SOURCES tag is described in all of the headers.  Write the header of
+    // the first file to the output file.
+    if (addSources) {
+      string sourcesLine = "##INFO=<ID=SOURCES,Number=.,Type=Integer,Description=\"Input files (numbered from 1) containing the variant.\">";
+      for (unsigned int file = 0; file < headers.size(); file++) {headers[file]->addInfoLine(sourcesLine);}
+    }
+    headers[0]->writeHeader(ofile.outputStream, false, taskDescription);
+
+    // Intersect the files.
+    ints.intersectVcfFiles(headers, files, variants, ofile);
+
+    // Close the vcf files.
+    for (unsigned int file = 0; file < vcfFiles.size(); file++) {
+      files[file]->closeVcf();
+      delete files[file];
+      delete variants[file];
+      delete headers[file];
+    }
+
   // If intersection is between a vcf file and a bed file, create a vcf and a bed object
   // and intersect.
-  if (bedFile != "") {
+  } else if (bedFile != "") {
 
     // Create a vcf object.
     vcf v;
@@ -305,6 +445,9 @@ int intersectTool::Run(int argc, char* argv[]) {
     vcfHeader header;
     header.parseHeader(v.input);
 
+    // Restrict the records read to the requested regions.
+    if (region != "") {v.setRegions(region);}
+
     b.parseHeader(bedFile);
 
     // Write the header to the output file.
@@ -370,6 +513,12 @@ int intersectTool::Run(int argc, char* argv[]) {
     vcfHeader header2;
     header2.parseHeader(v2.input);
 
+    // Restrict the records read from both files to the requested regions.
+    if (region != "") {
+      v1.setRegions(region);
+      v2.setRegions(region);
+    }
+
     // Check that the header for the two files contain the same samples.
     //if (v1.samples != v2.samples) {
     //  cerr << "vcf files contain different samples (or sample order)." << endl;
@@ -392,5 +541,8 @@ int intersectTool::Run(int argc, char* argv[]) {
     v2.closeVcf();
   }
 
+  // Close the output file.
+  ofile.closeOutputFile();
+
   return 0;
 }
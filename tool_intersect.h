@@ -38,22 +38,30 @@ class intersectTool : public AbstractTool {
     int Help(void);
     int Run(int argc, char* argv[]);
     int parseCommandLine(int argc, char* argv[]);
+    void checkMultipleFileOperation();
 
   private:
     string commandLine;
     string bedFile;
     vector<string> vcfFiles;
     string outputFile;
+    string region;
 
     string currentReferenceSequence;
     string writeFrom;
 
+    // Intersection of more than two files.
+    unsigned int minimumFiles;
+    string membership;
+
     // Boolean flags.
+    bool addSources;
     bool allowMismatch;
     bool distanceDistribution;
     bool findCommon;
     bool findUnion;
     bool findUnique;
+    bool multipleFiles;
     bool passFilters;
     bool processComplex;
     bool processIndels;
@@ -17,12 +17,12 @@ using namespace vcfCTools;
 // intersectTool imlementation.
 mergeTool::mergeTool(void)
   : AbstractTool()
-{
-  currentReferenceSequence = "";
-}
+{}
 
 // Destructor.
-mergeTool::~mergeTool(void) {}
+mergeTool::~mergeTool(void) {
+  for (vector<mergeInput*>::iterator iter = inputs.begin(); iter != inputs.end(); iter++) {delete *iter;}
+}
 
 // Help
 int mergeTool::Help(void) {
@@ -33,7 +33,9 @@ int mergeTool::Help(void) {
   cout << "  -h, --help" << endl;
   cout << "	display intersect help." << endl;
   cout << "  -i, --in" << endl;
-  cout << "	input vcf files to merge (minimum two files)." << endl;
+  cout << "	input vcf files to merge (minimum two files, each sorted by position)." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "	only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -o, --out" << endl;
   cout << "	output vcf file." << endl;
   cout << endl;
@@ -55,6 +57,7 @@ int mergeTool::parseCommandLine(int argc, char* argv[]) {
   static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"in", required_argument, 0, 'i'},
+    {"region", required_argument, 0, 'R'},
     {"out", required_argument, 0, 'o'},
 
     {0, 0, 0, 0}
@@ -62,7 +65,7 @@ int mergeTool::parseCommandLine(int argc, char* argv[]) {
 
   while (true) {
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hi:o:", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hi:o:R:", long_options, &option_index);
 
     if (argument == -1) {break;}
     switch (argument) {
@@ -72,6 +75,11 @@ int mergeTool::parseCommandLine(int argc, char* argv[]) {
         vcfFiles.push_back(optarg);
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
       // Output vcf file - required input.
       case 'o':
         outputFile = optarg;
@@ -125,64 +133,96 @@ int mergeTool::Run(int argc, char* argv[]) {
   }
   taskDescription.erase(taskDescription.end() - 2, taskDescription.end());
 
-  unsigned int index = 0;
-  for (vector<string>::iterator iter = vcfFiles.begin(); iter != vcfFiles.end(); iter++) {
-
-    // Create a vcf object.
-    vcf v;
-    v.openVcf(vcfFiles[index]);
-
-    // Create variant object.
-    variant var;
-    var.determineVariantsToProcess(true, true, true, true, true, true, false, false, false);
-
-    // Define a header object and parse the header information.
-    vcfHeader header;
-    header.parseHeader(v.input);
+// Open all of the files and parse their headers before any records are
+// read, so that the contig dictionary holds the contigs declared in all of
+// the headers.  Reading each file on its own thread uses a queue of lines
+// for every input, so this is only done if there is a core for each file.
+// The cores are also shared between the inputs for inflating compressed
+// files, so that merging many files does not start a pool of threads for
+// each (with many files, each file is inflated on the thread reading it).
+  bool useReaders = vcfFiles.size() <= threadPool::availableCores();
+  unsigned int decompressionThreads = (threadPool::availableCores() - 1) / vcfFiles.size();
+  for (unsigned int index = 0; index < vcfFiles.size(); index++) {
+    mergeInput* in = new mergeInput();
+    inputs.push_back(in);
+    in->index = index;
+    in->v.decompressionThreads = decompressionThreads;
+    in->v.openVcf(vcfFiles[index]);
+    in->var.determineVariantsToProcess(true, true, true, true, true, true, false, false, false);
+    in->header.parseHeader(in->v.input);
+
+    // Restrict the records read to the requested regions.
+    if (region != "") {in->v.setRegions(region);}
 
 // Store the samples list from the first vcf file.  The samplesList from 
 // all other vcf files being merged will be checked against this.
-// Also, print out the header.
-    if (index == 0) {
-      samples = header.samples;
-      header.writeHeader(ofile.outputStream, false, taskDescription);
-    } else {
-      if (header.samples != samples) {cerr << "WARNING: Different samples in file: " << v.vcfFilename << endl;}
-    }
+    if (index == 0) {samples = in->header.samples;}
+    else if (in->header.samples != samples) {cerr << "WARNING: Different samples in file: " << in->v.vcfFilename << endl;}
+  }
 
-// Print out the records.
-    v.success = v.getRecord();
-    while (v.success) {
-
-      // Build the variant structure for this reference sequence.
-      if (var.originalVariantsMap.size() == 0) {
-        currentReferenceSequence = v.variantRecord.referenceSequence;
-        v.success = var.buildVariantStructure(v);
-      }
-
-      // For merging, the vcf records are not interrogated and reduced to
-      // the shortest unambiguous description.  As such, loop over the
-      // originalVariants structure writing out each position in order until
-      // it is empty.  While the reference sequence remains the same, keep
-      // adding variants to the structure.
-      while (var.originalVariantsMap.size() != 0) {
-        if (v.variantRecord.referenceSequence == currentReferenceSequence && v.success) {
-          var.addVariantToStructure(v.position, v.variantRecord);
-          v.success = v.getRecord();
-        }
-        var.ovmIter = var.originalVariantsMap.begin();
-        var.buildOutputRecord(ofile, header);
-        var.originalVariantsMap.erase(var.ovmIter);
-      }
-    }
+// Print out the header from the first file.
+  inputs[0]->header.writeHeader(ofile.outputStream, false, taskDescription);
+  ofile.startWriter();
 
-// Close the vcf file.
-    v.closeVcf(); // Close the vcf file
-    index++; // Increment the index to ensure header information is written out once.
+// Read the first record from each file and put the files with records on
+// the heap.
+  for (vector<mergeInput*>::iterator iter = inputs.begin(); iter != inputs.end(); iter++) {
+    if (useReaders) {(*iter)->v.startReader();}
+    (*iter)->v.success = (*iter)->v.getRecord();
+    if ((*iter)->v.success) {heap.push_back(*iter);}
+  }
+  make_heap(heap.begin(), heap.end(), laterRecord());
+
+// Repeatedly write out the earliest record of all the files and replace it
+// with the next record from the same file.  For merging, the vcf records
+// are not interrogated and reduced to the shortest unambiguous description,
+// so each record is just passed through the variant structure of its file
+// to build the output record.
+  while (heap.size() != 0) {
+    pop_heap(heap.begin(), heap.end(), laterRecord());
+    mergeInput* in = heap.back();
+
+    in->var.addVariantToStructure(in->v.position, in->v.variantRecord);
+    in->var.ovmIter = in->var.originalVariantsMap.begin();
+    in->var.buildOutputRecord(ofile, in->header);
+    in->var.originalVariantsMap.erase(in->var.ovmIter);
+
+    nextRecord(in);
+    if (in->v.success) {push_heap(heap.begin(), heap.end(), laterRecord());}
+    else {heap.pop_back();}
   }
 
+// Close the vcf files.
+  for (vector<mergeInput*>::iterator iter = inputs.begin(); iter != inputs.end(); iter++) {(*iter)->v.closeVcf();}
+
 // Flush the output buffer.
   ofile.flushOutputBuffer();
+  ofile.closeOutputFile();
 
   return 0;
 }
+
+// Read the next record from an input.  The merge relies on each file being
+// sorted, so terminate if a record is found before the previous record on
+// the same reference sequence.  The heap orders the reference sequences by
+// their IDs, so an input moving to a sequence with a lower ID would also
+// give unsorted output.  Without ##contig lines, the IDs are given in the
+// order the sequences are first seen, so this happens if the files list
+// the sequences in different orders.
+void mergeTool::nextRecord(mergeInput* in) {
+  unsigned int referenceSequenceID = in->v.variantRecord.referenceSequenceID;
+  int position                     = in->v.position;
+
+  in->v.success = in->v.getRecord();
+  if (!in->v.success) {return;}
+  if (in->v.variantRecord.referenceSequenceID == referenceSequenceID && in->v.position < position) {
+    cerr << "ERROR: vcf file " << in->v.vcfFilename << " is not sorted (" << in->v.variantRecord.referenceSequence << ":";
+    cerr << in->v.position << " follows " << position << ")." << endl;
+    exit(1);
+  } else if (in->v.variantRecord.referenceSequenceID < referenceSequenceID) {
+    cerr << "ERROR: reference sequence " << in->v.variantRecord.referenceSequence << " follows " << sharedContigs().getName(referenceSequenceID);
+    cerr << " in vcf file " << in->v.vcfFilename << ", but is ordered before it in the merge." << endl;
+    cerr << "The files must list the reference sequences in the same order (or declare them with ##contig lines)." << endl;
+    exit(1);
+  }
+}
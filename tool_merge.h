@@ -13,11 +13,13 @@
 
 #include "header.h"
 #include "output.h"
+#include "thread_pool.h"
 #include "tools.h"
 #include "variant.h"
 #include "vcfCTools_tool.h"
 #include "vcf.h"
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -28,6 +30,31 @@ using namespace std;
 
 namespace vcfCTools {
 
+// One input to the merge.  Each input holds only its current record, which
+// is passed through the variant structure to build the output record.
+class mergeInput {
+  public:
+    vcf v;
+    vcfHeader header;
+    variant var;
+    unsigned int index;
+};
+
+// Order the inputs on the heap by the contig ID and position of their
+// current records.  Records at the same locus are written in the order of
+// the input files.  The standard heap functions keep the largest element
+// at the front, so the comparison is reversed.
+struct laterRecord {
+  bool operator()(mergeInput* a, mergeInput* b) const {
+    if (a->v.variantRecord.referenceSequenceID != b->v.variantRecord.referenceSequenceID) {
+      return a->v.variantRecord.referenceSequenceID > b->v.variantRecord.referenceSequenceID;
+    }
+    if (a->v.position != b->v.position) {return a->v.position > b->v.position;}
+
+    return a->index > b->index;
+  }
+};
+
 class mergeTool : public AbstractTool {
   public:
     mergeTool(void);
@@ -35,12 +62,15 @@ class mergeTool : public AbstractTool {
     int Help(void);
     int Run(int argc, char* argv[]);
     int parseCommandLine(int argc, char* argv[]);
+    void nextRecord(mergeInput*);
 
   private:
     string commandLine;
     vector<string> vcfFiles;
     string outputFile;
-    string currentReferenceSequence;
+    string region;
+    vector<mergeInput*> inputs;
+    vector<mergeInput*> heap;
 
     // Boolean flags.
     bool processComplex;
@@ -0,0 +1,350 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Write out the records of a vcf file with the alleles
+// trimmed and left aligned.
+// ******************************************************
+
+#include "tool_normalize.h"
+
+using namespace std;
+using namespace vcfCTools;
+
+// normalizeTool implementation.
+normalizeTool::normalizeTool(void)
+  : AbstractTool()
+{
+  fasta         = DEFAULT_REFERENCE_FASTA;
+  flushedBefore = 0;
+  maxShift      = 0;
+  splitAlleles  = false;
+  window        = 100;
+}
+
+// Destructor.
+normalizeTool::~normalizeTool(void) {}
+
+// Help
+int normalizeTool::Help(void) {
+  cout << "Normalize help" << endl;
+  cout << "Usage: ./vcfCTools normalize [options]." << endl;
+  cout << endl;
+  cout << "Trim the alleles of each record to the shortest description and move" << endl;
+  cout << "indels to their leftmost position in the reference sequence." << endl;
+  cout << endl;
+  cout << "Options:" << endl;
+  cout << "  -h, --help" << endl;
+  cout << "	display normalize help." << endl;
+  cout << "  -i, --in" << endl;
+  cout << "	input vcf file." << endl;
+  cout << "  -o, --out" << endl;
+  cout << "	output vcf file." << endl;
+  cout << "  -f, --fasta" << endl;
+  cout << "	reference fasta file used to left align indels (default: " << DEFAULT_REFERENCE_FASTA << ")." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "	only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
+  cout << "  -s, --split" << endl;
+  cout << "	write each alternate allele of a multiallelic record as a separate record." << endl;
+  cout << "  -w, --window" << endl;
+  cout << "	hold records for at least this many bases to keep the output sorted (default: 100)." << endl;
+  cout << "	The window grows to the largest shift seen." << endl;
+  cout << endl;
+  exit(0);
+
+  return 0;
+}
+
+// Parse the command line and get all required and optional arguments.
+int normalizeTool::parseCommandLine(int argc, char* argv[]) {
+  commandLine = argv[0];
+  for (int i = 2; i < argc; i++) {
+    commandLine += " ";
+    commandLine += argv[i];
+  }
+
+  int argument; // Counter for getopt.
+
+  // Define the long options.
+  while (true) {
+    static struct option long_options[] = {
+      {"help", no_argument, 0, 'h'},
+      {"in", required_argument, 0, 'i'},
+      {"out", required_argument, 0, 'o'},
+      {"fasta", required_argument, 0, 'f'},
+      {"region", required_argument, 0, 'R'},
+      {"split", no_argument, 0, 's'},
+      {"window", required_argument, 0, 'w'},
+
+      {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    argument = getopt_long(argc, argv, "hi:o:f:R:sw:", long_options, &option_index);
+
+    if (argument == -1) {break;}
+    switch (argument) {
+
+      // Input vcf file - required input.
+      case 'i':
+        vcfFile = optarg;
+        break;
+
+      // Output vcf file.
+      case 'o':
+        outputFile = optarg;
+        break;
+
+      // Reference fasta file.
+      case 'f':
+        fasta = optarg;
+        break;
+
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
+      // Split multiallelic records.
+      case 's':
+        splitAlleles = true;
+        break;
+
+      // The minimum number of bases that records are held for.
+      case 'w':
+        window = atoi(optarg);
+        break;
+
+      // Help.
+      case 'h':
+        return Help();
+
+      //
+      case '?':
+        cerr << "Unknown option: " << argv[optind - 1] << endl;
+        exit(1);
+ 
+      // default
+      default:
+        abort ();
+
+    }
+  }
+
+// Remaining arguments are unknown, so terminate with an error.
+  if (optind < argc - 1) {
+    cerr << "Unknown options." << endl;
+    exit(1);
+  }
+
+// Check that a vcf file was specified.
+  if (vcfFile == "") {
+    cerr << "A vcf file must be specified (--in, -i)." << endl;
+    exit(1);
+  }
+
+// Check the window.
+  if (window < 0) {
+    cerr << "ERROR: --window (-w) cannot be negative." << endl;
+    exit(1);
+  }
+
+  return 0;
+}
+
+// Trim the bases shared by the end and then the start of every allele of
+// a record, leaving at least one base in each allele.  Records with
+// symbolic or missing alleles are left as they are.
+void normalizeTool::trimAlleles(int& position, string& ref, vector<string>& alts) {
+  vector<string>::iterator iter;
+
+  for (iter = alts.begin(); iter != alts.end(); iter++) {
+    if (iter->find_first_not_of("ACGTNacgtn") != string::npos) {return;}
+  }
+
+  // Start at the end and work backwards.
+  while (ref.length() > 1) {
+    for (iter = alts.begin(); iter != alts.end(); iter++) {
+      if (iter->length() == 1 || toupper((*iter)[iter->length() - 1]) != toupper(ref[ref.length() - 1])) {break;}
+    }
+    if (iter != alts.end()) {break;}
+    ref.erase(ref.length() - 1);
+    for (iter = alts.begin(); iter != alts.end(); iter++) {iter->erase(iter->length() - 1);}
+  }
+
+  // Start at the beginning and work forwards.
+  while (ref.length() > 1) {
+    for (iter = alts.begin(); iter != alts.end(); iter++) {
+      if (iter->length() == 1 || toupper((*iter)[0]) != toupper(ref[0])) {break;}
+    }
+    if (iter != alts.end()) {break;}
+    ref.erase(0, 1);
+    for (iter = alts.begin(); iter != alts.end(); iter++) {iter->erase(0, 1);}
+    position++;
+  }
+}
+
+// Build a record with new alleles and position and add it to the output
+// buffer.  If alleles have been removed from the record, alleleIDs maps
+// the original allele IDs to the new ones (-1 for removed alleles) and
+// the info and genotypes are modified to match.
+void normalizeTool::writeRecord(originalVariants& ov, vcfHeader& header, output& ofile, int position, string& ref, string& alts, vector<int>& alleleIDs) {
+
+  // Keep track of the largest distance that a record has been moved to
+  // the left.
+  if (ov.position - position > maxShift) {maxShift = ov.position - position;}
+  if (position < flushedBefore) {
+    cerr << "WARNING: Record at " << ov.referenceSequence << ":" << ov.position << " was moved to " << position;
+    cerr << ", further than the records held back.  The output may not be sorted (increase --window, -w)." << endl;
+  }
+
+  // The quality is written as it appears in the input (converting the
+  // value back to a string would lose the missing value and precision).
+  ostringstream sPosition;
+  sPosition << position;
+
+  variantInfo info(ov.info);
+  if (alleleIDs.size() != 0) {info.modifyInfo(alleleIDs, header);}
+
+  ofile.outputRecord = ov.referenceSequence + "	" +
+                       sPosition.str() + "	" +
+                       ov.rsid + "	" +
+                       ref + "	" +
+                       alts + "	" +
+                       ov.qualityString + "	" +
+                       ov.filters + "	" +
+                       info.infoString;
+
+  if (ov.hasGenotypes) {
+    genotypeInfo gen(ov.genotypeFormat, ov.genotypes);
+    if (alleleIDs.size() != 0) {gen.modifyGenotypes(header, alleleIDs);}
+    ofile.outputRecord += "	" + gen.genotypeFormat + "	" + gen.genotypeString;
+  }
+  ofile.flushToBuffer(position, ov.referenceSequenceID);
+}
+
+// Normalize a record.  Records with a single alternate allele (or each
+// allele if multiallelic records are split) take the reduced alleles and
+// position found for the allele when the record was read.  The alleles
+// of a multiallelic record are only trimmed together, since the
+// alternate alleles need not reduce to the same position.
+void normalizeTool::normalizeRecord(originalVariants& ov, vcfHeader& header, output& ofile) {
+  vector<int> alleleIDs;
+
+  if (ov.numberAlts == 1) {
+    writeRecord(ov, header, ofile, ov.reducedPosition[0], ov.reducedRef[0], ov.reducedAlts[0], alleleIDs);
+  } else if (splitAlleles) {
+    for (unsigned int allele = 0; allele < ov.numberAlts; allele++) {
+      alleleIDs.assign(ov.numberAlts + 1, -1);
+      alleleIDs[0]          = 0;
+      alleleIDs[allele + 1] = 1;
+      writeRecord(ov, header, ofile, ov.reducedPosition[allele], ov.reducedRef[allele], ov.reducedAlts[allele], alleleIDs);
+    }
+  } else {
+    int position        = ov.position;
+    string ref          = ov.ref;
+    vector<string> alts = ov.alts;
+    string altString;
+
+    trimAlleles(position, ref, alts);
+    for (vector<string>::iterator iter = alts.begin(); iter != alts.end(); iter++) {
+      if (iter != alts.begin()) {altString += ",";}
+      altString += *iter;
+    }
+    writeRecord(ov, header, ofile, position, ref, altString, alleleIDs);
+  }
+}
+
+// Normalize all of the records read from the vcf file.
+void normalizeTool::normalizeRecords(vcfHeader& header, vcf& v, variant& var, output& ofile) {
+  unsigned int currentReferenceSequenceID = NO_CONTIG;
+
+  // Get the first record from the vcf file.
+  v.success = v.getRecord();
+  while (v.success) {
+
+    // Build the variant structure for this reference sequence.  The output
+    // buffer is flushed when the reference sequence changes.
+    if (var.originalVariantsMap.size() == 0) {
+      currentReferenceSequenceID = v.variantRecord.referenceSequenceID;
+      v.success                  = var.buildVariantStructure(v);
+      flushedBefore              = 0;
+    }
+
+    // Loop over the variant structure until it is empty.  While v.update is true,
+    // i.e. when the reference sequence is still the current reference sequence,
+    // keep adding variants to the structure.
+    while (var.originalVariantsMap.size() != 0) {
+      if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
+        var.addVariantToStructure(v.position, v.variantRecord);
+        v.success = v.getRecord();
+      }
+      var.ovmIter = var.originalVariantsMap.begin();
+      int position = var.ovmIter->first;
+      for (var.ovIter = var.ovmIter->second.begin(); var.ovIter != var.ovmIter->second.end(); var.ovIter++) {
+        normalizeRecord(*var.ovIter, header, ofile);
+      }
+      var.originalVariantsMap.erase(var.ovmIter);
+
+      // All of the remaining records are at or after this position, so
+      // records more than the window before it are in their final order.
+      int flushPosition = position - max(window, maxShift);
+      if (flushPosition > flushedBefore) {
+        ofile.flushBefore(flushPosition);
+        flushedBefore = flushPosition;
+      }
+    }
+  }
+}
+
+// Run the tool.
+int normalizeTool::Run(int argc, char* argv[]) {
+  int getOptions = normalizeTool::parseCommandLine(argc, argv);
+
+  // Define an output object and open the output file.  The records are
+  // only written out of the buffer once they are in order.
+  output ofile;
+  ofile.outputStream    = ofile.openOutputFile(outputFile);
+  ofile.bufferPositions = 0;
+
+  // Define the vcf object.
+  vcf v;
+  v.openVcf(vcfFile);
+
+  // Define the header object and read in the header information.
+  vcfHeader header;
+  header.parseHeader(v.input);
+
+  // Restrict the records read to the requested regions.
+  if (region != "") {v.setRegions(region);}
+
+  // Write out the header.
+  string taskDescription = "##vcfCTools=normalize";
+  if (splitAlleles) {taskDescription += " split multiallelic records";}
+  header.writeHeader(ofile.outputStream, false, taskDescription);
+
+  // Every allele is reduced, and indels are left aligned against the
+  // reference.  The warnings about each modified allele are not needed
+  // here.
+  ostream discard(NULL);
+  variant var;
+  var.determineVariantsToProcess(false, false, false, false, false, false, false, true, false);
+  var.fasta       = fasta;
+  var.errorStream = &discard;
+
+  v.startReader();
+  ofile.startWriter();
+  normalizeRecords(header, v, var, ofile);
+
+  // Close the vcf file.
+  v.closeVcf();
+
+  // Flush the output buffer.
+  ofile.flushOutputBuffer();
+  ofile.closeOutputFile();
+
+  return 0;
+}
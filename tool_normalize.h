@@ -0,0 +1,66 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Write out the records of a vcf file with the alleles
+// trimmed and left aligned.
+// ******************************************************
+
+#ifndef TOOL_NORMALIZE_H
+#define TOOL_NORMALIZE_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <stdlib.h>
+
+#include "genotype_info.h"
+#include "header.h"
+#include "info.h"
+#include "output.h"
+#include "variant.h"
+#include "vcf.h"
+#include "vcfCTools_tool.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+class normalizeTool : public AbstractTool {
+  public:
+    normalizeTool(void);
+    ~normalizeTool(void);
+    int Help(void);
+    int Run(int argc, char* argv[]);
+    int parseCommandLine(int argc, char* argv[]);
+    void normalizeRecord(originalVariants&, vcfHeader&, output&);
+    void normalizeRecords(vcfHeader&, vcf&, variant&, output&);
+    void trimAlleles(int&, string&, vector<string>&);
+    void writeRecord(originalVariants&, vcfHeader&, output&, int, string&, string&, vector<int>&);
+
+  private:
+    string commandLine;
+    string fasta;
+    string outputFile;
+    string region;
+    string vcfFile;
+
+    // Records moved to the left are held in the output buffer until no
+    // later record can be moved in front of them.  The records are held
+    // for at least window bases, or the largest shift seen if that is
+    // greater.
+    int flushedBefore;
+    int maxShift;
+    int window;
+
+    // Boolean flags.
+    bool splitAlleles;
+};
+
+} // namespace vcfCTools
+
+#endif // TOOL_NORMALIZE_H
@@ -0,0 +1,196 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Sort the records of a vcf file by reference sequence
+// and position.
+// ******************************************************
+
+#include "tool_sort.h"
+
+using namespace std;
+using namespace vcfCTools;
+
+// sortTool implementation.
+sortTool::sortTool(void)
+  : AbstractTool()
+{
+  memory        = 1024;
+  tempDirectory = (getenv("TMPDIR") != NULL) ? getenv("TMPDIR") : "/tmp";
+  threads       = threadPool::availableCores();
+}
+
+// Destructor.
+sortTool::~sortTool(void) {}
+
+// Help
+int sortTool::Help(void) {
+  cout << "Sort help" << endl;
+  cout << "Usage: ./vcfCTools sort [options]." << endl;
+  cout << endl;
+  cout << "Sort the records of a vcf file by reference sequence and position.  The" << endl;
+  cout << "reference sequences are ordered as in the ##contig header lines, followed" << endl;
+  cout << "by any others in the order they are first seen.  Records at the same" << endl;
+  cout << "position keep their input order.  Files larger than the memory allowed" << endl;
+  cout << "are sorted in runs that are written to temporary files and merged." << endl;
+  cout << endl;
+  cout << "Options:" << endl;
+  cout << "  -h, --help" << endl;
+  cout << "	display sort help." << endl;
+  cout << "  -i, --in" << endl;
+  cout << "	input vcf file." << endl;
+  cout << "  -o, --out" << endl;
+  cout << "	output vcf file." << endl;
+  cout << "  -m, --memory" << endl;
+  cout << "	memory used to hold records, in megabytes (default: 1024)." << endl;
+  cout << "  -T, --temp-dir" << endl;
+  cout << "	directory for temporary files (default: $TMPDIR or /tmp)." << endl;
+  cout << "  -j, --threads" << endl;
+  cout << "	number of threads sorting runs (default: number of cores)." << endl;
+  cout << endl;
+  exit(0);
+
+  return 0;
+}
+
+// Parse the command line and get all required and optional arguments.
+int sortTool::parseCommandLine(int argc, char* argv[]) {
+  commandLine = argv[0];
+  for (int i = 2; i < argc; i++) {
+    commandLine += " ";
+    commandLine += argv[i];
+  }
+
+  int argument; // Counter for getopt.
+
+  // Define the long options.
+  while (true) {
+    static struct option long_options[] = {
+      {"help", no_argument, 0, 'h'},
+      {"in", required_argument, 0, 'i'},
+      {"out", required_argument, 0, 'o'},
+      {"memory", required_argument, 0, 'm'},
+      {"temp-dir", required_argument, 0, 'T'},
+      {"threads", required_argument, 0, 'j'},
+
+      {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    argument = getopt_long(argc, argv, "hi:o:m:T:j:", long_options, &option_index);
+
+    if (argument == -1) {break;}
+    switch (argument) {
+
+      // Input vcf file - required input.
+      case 'i':
+        vcfFile = optarg;
+        break;
+
+      // Output vcf file.
+      case 'o':
+        outputFile = optarg;
+        break;
+
+      // Memory used to hold records.
+      case 'm':
+        memory = atoi(optarg);
+        break;
+
+      // Directory for temporary files.
+      case 'T':
+        tempDirectory = optarg;
+        break;
+
+      // Number of threads sorting runs.
+      case 'j':
+        threads = atoi(optarg);
+        break;
+
+      // Help.
+      case 'h':
+        return Help();
+
+      //
+      case '?':
+        cerr << "Unknown option: " << argv[optind - 1] << endl;
+        exit(1);
+ 
+      // default
+      default:
+        abort ();
+
+    }
+  }
+
+// Remaining arguments are unknown, so terminate with an error.
+  if (optind < argc - 1) {
+    cerr << "Unknown options." << endl;
+    exit(1);
+  }
+
+// Check that a vcf file was specified.
+  if (vcfFile == "") {
+    cerr << "A vcf file must be specified (--in, -i)." << endl;
+    exit(1);
+  }
+
+// Check the memory and threads.
+  if (memory < 1) {
+    cerr << "ERROR: --memory (-m) must be at least 1." << endl;
+    exit(1);
+  }
+  if (threads < 0) {
+    cerr << "ERROR: --threads (-j) cannot be negative." << endl;
+    exit(1);
+  }
+
+  return 0;
+}
+
+// Run the tool.
+int sortTool::Run(int argc, char* argv[]) {
+  int getOptions = sortTool::parseCommandLine(argc, argv);
+
+  // Define an output object and open the output file.
+  output ofile;
+  ofile.outputStream = ofile.openOutputFile(outputFile);
+
+  // Define the vcf object.
+  vcf v;
+  v.openVcf(vcfFile);
+
+  // Define the header object and read in the header information.  The
+  // ##contig lines set the order of the reference sequences.
+  vcfHeader header;
+  header.parseHeader(v.input);
+
+  // Write out the header.
+  string taskDescription = "##vcfCTools=sort";
+  header.writeHeader(ofile.outputStream, false, taskDescription);
+
+  // Read in all of the records, sorting them in runs as they are read.
+  externalSorter sorter;
+  sorter.start((size_t) memory * 1024 * 1024, tempDirectory, threads);
+
+  string line;
+  v.startReader();
+  while (v.reader.getLine(line)) {
+    if (line.empty() || line[0] == '#') {continue;}
+    sorter.add(line);
+  }
+
+  // Close the vcf file.
+  v.closeVcf();
+
+  // Merge the runs and write out the sorted records.
+  ofile.startWriter();
+  sorter.finish(ofile);
+  ofile.flushOutputBuffer();
+  ofile.closeOutputFile();
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Sort the records of a vcf file by reference sequence
+// and position.
+// ******************************************************
+
+#ifndef TOOL_SORT_H
+#define TOOL_SORT_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <stdlib.h>
+
+#include "external_sort.h"
+#include "header.h"
+#include "output.h"
+#include "thread_pool.h"
+#include "vcf.h"
+#include "vcfCTools_tool.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+class sortTool : public AbstractTool {
+  public:
+    sortTool(void);
+    ~sortTool(void);
+    int Help(void);
+    int Run(int argc, char* argv[]);
+    int parseCommandLine(int argc, char* argv[]);
+
+  private:
+    string commandLine;
+    string outputFile;
+    string tempDirectory;
+    string vcfFile;
+
+    // The memory used to hold records (in megabytes) and the number of
+    // threads sorting runs.
+    int memory;
+    int threads;
+};
+
+} // namespace vcfCTools
+
+#endif // TOOL_SORT_H
@@ -17,19 +17,20 @@ using namespace vcfCTools;
 statsTool::statsTool(void)
   : AbstractTool()
 {
-  annotationFlagsString    = "";
-  currentReferenceSequence = "";
-  generateAfs              = false;
-  generateDetailed         = false;
-  generateSampleStats      = false;
-  processComplex           = false;
-  processIndels            = false;
-  processMnps              = false;
-  processRearrangements    = false;
-  processSnps              = false;
-  processSvs               = false;
-  splitMnps                = false;
-  useAnnotations           = false;
+  annotationFlagsString = "";
+  chunkSize             = 0;
+  generateAfs           = false;
+  generateDetailed      = false;
+  generateSampleStats   = false;
+  processComplex        = false;
+  processIndels         = false;
+  processMnps           = false;
+  processRearrangements = false;
+  processSnps           = false;
+  processSvs            = false;
+  splitMnps             = false;
+  threads               = 1;
+  useAnnotations        = false;
 }
 
 // Destructor.
@@ -45,8 +46,14 @@ int statsTool::Help(void) {
   cout << "     display intersect help." << endl;
   cout << "  -i, --in" << endl;
   cout << "     input vcf file." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "     only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -o, --output" << endl;
   cout << "     output vcf file." << endl;
+  cout << "  -j, --threads" << endl;
+  cout << "     process the regions of an indexed file on this many threads." << endl;
+  cout << "  -z, --chunk-size" << endl;
+  cout << "     split the reference sequences into chunks of this many bases when using multiple threads." << endl;
   cout << "  -a, --allele-frequency-spectrum" << endl;
   cout << "     generate statistics as a function of the AFS." << endl;
   cout << "  -d, --detailed" << endl;
@@ -85,7 +92,10 @@ int statsTool::parseCommandLine(int argc, char* argv[]) {
   static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"in", required_argument, 0, 'i'},
+    {"region", required_argument, 0, 'R'},
     {"out", required_argument, 0, 'o'},
+    {"threads", required_argument, 0, 'j'},
+    {"chunk-size", required_argument, 0, 'z'},
     {"allele-frequency-spectrum", no_argument, 0, 'a'},
     {"detailed", required_argument, 0, 'd'},
     {"annotations", required_argument, 0, 'n'},
@@ -103,7 +113,7 @@ int statsTool::parseCommandLine(int argc, char* argv[]) {
 
   while (true) {
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hi:o:ad:n:ps:123456", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hi:o:ad:n:ps:123456R:j:z:", long_options, &option_index);
 
     if (argument == -1)
       break;
@@ -114,6 +124,11 @@ int statsTool::parseCommandLine(int argc, char* argv[]) {
         vcfFile = optarg;
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
       // Help.
       case 'h':
         return Help();
@@ -122,6 +137,16 @@ int statsTool::parseCommandLine(int argc, char* argv[]) {
       case 'o':
         outputFile = optarg;
         break;
+
+      // Number of threads.
+      case 'j':
+        threads = atoi(optarg);
+        break;
+
+      // Size of the chunks processed on each thread.
+      case 'z':
+        chunkSize = atoi(optarg);
+        break;
  
       // Generate the allele frequency spectrum.
       case 'a':
@@ -206,9 +231,50 @@ int statsTool::parseCommandLine(int argc, char* argv[]) {
     exit(1);
   }
 
+// Check the number of threads and the chunk size.
+  if (threads < 1 || chunkSize < 0) {
+    cerr << "ERROR: --threads (-j) must be at least 1 and --chunk-size (-z) cannot be negative." << endl;
+    exit(1);
+  }
+
   return 0;
 }
 
+// Define the variants to be processed.
+void statsTool::initialiseVariant(variant& var) {
+  var.determineVariantsToProcess(processSnps, processMnps, processIndels, processComplex, processSvs, processRearrangements, false, true, false);
+}
+
+// Generate statistics on all of the records read from the vcf file.
+void statsTool::processRecords(vcfHeader& header, vcf& v, variant& var, statistics& stats, output& ofile) {
+  unsigned int currentReferenceSequenceID = NO_CONTIG;
+
+  // Read through all the entries in the file.  First construct the
+  // structure to contain the variants in memory and populate.
+  v.success = v.getRecord();
+  while (v.success) {
+
+    // Build the variant structure for this reference sequence.
+    if (var.originalVariantsMap.size() == 0) {
+      currentReferenceSequenceID = v.variantRecord.referenceSequenceID;
+      v.success                = var.buildVariantStructure(v);
+    }
+
+    // Loop over the variant structure until it is empty.  While v.update is true,
+    // i.e. when the reference sequence is still the current reference sequence,
+    // keep adding variants to the structre.
+    while (var.originalVariantsMap.size() != 0) {
+      if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
+        var.addVariantToStructure(v.position, v.variantRecord);
+        v.success = v.getRecord();
+      }
+      var.ovmIter = var.originalVariantsMap.begin();
+      stats.generateStatistics(header, var, useAnnotations, annotationFlags, generateAfs, ofile);
+      var.originalVariantsMap.erase(var.ovmIter);
+    } 
+  }
+}
+
 // Run the tool.
 int statsTool::Run(int argc, char* argv[]) {
   int getOptions = statsTool::parseCommandLine(argc, argv);
@@ -221,15 +287,15 @@ int statsTool::Run(int argc, char* argv[]) {
   vcf v; // Create a vcf object.
   v.openVcf(vcfFile);
 
-  // Create a variant structure to hold the variants.
-  variant var; // Create a variant structure to hold the variants.
-  var.determineVariantsToProcess(processSnps, processMnps, processIndels, processComplex, processSvs, processRearrangements, false, true, false);
   statistics stats; // Create a statistics object.
 
   // Define a header object and parse the header information.
   vcfHeader header;
   header.parseHeader(v.input);
 
+  // Restrict the records read to the requested regions.
+  if (region != "") {v.setRegions(region);}
+
   // If MNPs should be broken up into SNPs, ensure that the boolean flag is set.
   if (splitMnps) {stats.splitMnps = true;}
 
@@ -290,29 +356,27 @@ int statsTool::Run(int argc, char* argv[]) {
   // Print the header for detailed statistics if necessary.
   //if (generateDetailed) {stats.printDetailedHeader(output);}
 
-  // Read through all the entries in the file.  First construct the
-  // structure to contain the variants in memory and populate.
-  v.success = v.getRecord();
-  while (v.success) {
-
-    // Build the variant structure for this reference sequence.
-    if (var.originalVariantsMap.size() == 0) {
-      currentReferenceSequence = v.variantRecord.referenceSequence;
-      v.success                = var.buildVariantStructure(v);
+  // If multiple threads are to be used, generate statistics for each region
+  // of the file on a separate thread and merge them in file order.
+  parallelRegions parallel;
+  if (threads > 1 && parallel.openIndex(vcfFile)) {
+    vector<regionJob*> jobs;
+
+    parallel.buildTasks(region, chunkSize);
+    for (unsigned int i = 0; i < parallel.tasks.size(); i++) {jobs.push_back(new statsJob(this, stats));}
+    parallel.start(jobs, threads);
+    for (vector<regionJob*>::iterator iter = jobs.begin(); iter != jobs.end(); iter++) {
+      parallel.waitFor(*iter);
+      cerr << (*iter)->errors.str();
+      stats.mergeStatistics(((statsJob*) *iter)->stats);
+      delete *iter;
     }
 
-    // Loop over the variant structure until it is empty.  While v.update is true,
-    // i.e. when the reference sequence is still the current reference sequence,
-    // keep adding variants to the structre.
-    while (var.originalVariantsMap.size() != 0) {
-      if (v.variantRecord.referenceSequence == currentReferenceSequence && v.success) {
-        var.addVariantToStructure(v.position, v.variantRecord);
-        v.success = v.getRecord();
-      }
-      var.ovmIter = var.originalVariantsMap.begin();
-      stats.generateStatistics(header, var, useAnnotations, annotationFlags, generateAfs, ofile);
-      var.originalVariantsMap.erase(var.ovmIter);
-    } 
+  // Otherwise, generate the statistics on this thread.
+  } else {
+    variant var;
+    initialiseVariant(var);
+    processRecords(header, v, var, stats, ofile);
   }
 
 // Count the total number of variants in each class and then rint out the
@@ -330,8 +394,28 @@ int statsTool::Run(int argc, char* argv[]) {
   if (stats.hasInsertion || stats.hasDeletion) {stats.printIndelStatistics(ofile);}
   if (generateSampleStats) {stats.printSampleSnps(header, v, ofile);}
 
-// Close the vcf file and return.
+// Close the vcf and output files and return.
   v.closeVcf();
+  ofile.closeOutputFile();
 
   return 0;
 }
+
+// statsJob implementation.  The statistics start from a copy of the
+// configured (empty) statistics object.
+statsJob::statsJob(statsTool* parent, statistics& prototype) {
+  stats = prototype;
+  tool  = parent;
+}
+
+// Generate the statistics for the region.
+void statsJob::processRegion(vcfHeader& header, vcf& v) {
+  output ofile;
+  variant var;
+
+  ofile.outputStream = &records;
+  tool->initialiseVariant(var);
+  var.errorStream = &errors;
+  v.errorStream   = &errors;
+  tool->processRecords(header, v, var, stats, ofile);
+}
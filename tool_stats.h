@@ -20,6 +20,7 @@
 
 #include "header.h"
 #include "output.h"
+#include "parallel.h"
 #include "stats.h"
 #include "tools.h"
 #include "variant.h"
@@ -37,12 +38,16 @@ class statsTool : public AbstractTool {
     int Help( void );
     int Run( int argc, char* argv[] );
     int parseCommandLine( int argc, char* argv[] );
+    void initialiseVariant(variant&);
+    void processRecords(vcfHeader&, vcf&, variant&, statistics&, output&);
 
   private:
     string commandLine;
     string vcfFile;
     string outputFile;
-    string currentReferenceSequence;
+    string region;
+    int threads;
+    int chunkSize;
     string annotationFlagsString;
     vector<string> annotationFlags;
     string detailedGenotypeQualityString;
@@ -62,6 +67,18 @@ class statsTool : public AbstractTool {
     bool useAnnotations;
 };
 
+// Generate statistics on the records in a single region when running on
+// multiple threads.  The statistics are merged when the job is collected.
+class statsJob : public regionJob {
+  public:
+    statsJob(statsTool*, statistics&);
+    void processRegion(vcfHeader&, vcf&);
+
+  public:
+    statsTool* tool;
+    statistics stats;
+};
+
 } // namespace vcfCTools
 
 #endif
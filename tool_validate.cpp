@@ -20,8 +20,9 @@ using namespace vcfCTools;
 validateTool::validateTool(void)
   : AbstractTool()
 {
-  currentReferenceSequence = "";
-  error                    = false;
+  chunkSize = 0;
+  error     = false;
+  threads   = 1;
 }
 
 // Destructor.
@@ -37,8 +38,14 @@ int validateTool::Help(void) {
   cout << "     display intersect help." << endl;
   cout << "  -i, --in" << endl;
   cout << "     input vcf file." << endl;
+  cout << "  -R, --region" << endl;
+  cout << "     only process records in the region(s) (chr, chr:start or chr:start-end, comma separated)." << endl;
   cout << "  -o, --output" << endl;
   cout << "     output file." << endl;
+  cout << "  -j, --threads" << endl;
+  cout << "     process the regions of an indexed file on this many threads." << endl;
+  cout << "  -z, --chunk-size" << endl;
+  cout << "     split the reference sequences into chunks of this many bases when using multiple threads." << endl;
   return 0;
 }
 
@@ -55,13 +62,16 @@ int validateTool::parseCommandLine(int argc, char* argv[]) {
   static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"in", required_argument, 0, 'i'},
+    {"region", required_argument, 0, 'R'},
+    {"threads", required_argument, 0, 'j'},
+    {"chunk-size", required_argument, 0, 'z'},
 
     {0, 0, 0, 0}
   };
 
   while (true) {
     int option_index = 0;
-    argument = getopt_long(argc, argv, "hi:", long_options, &option_index);
+    argument = getopt_long(argc, argv, "hi:R:j:z:", long_options, &option_index);
 
     if (argument == -1)
       break;
@@ -72,6 +82,21 @@ int validateTool::parseCommandLine(int argc, char* argv[]) {
         vcfFile = optarg;
         break;
 
+      // Only read records in the given regions.
+      case 'R':
+        region = optarg;
+        break;
+
+      // Number of threads.
+      case 'j':
+        threads = atoi(optarg);
+        break;
+
+      // Size of the chunks processed on each thread.
+      case 'z':
+        chunkSize = atoi(optarg);
+        break;
+
       // Help.
       case 'h':
         return Help();
@@ -100,40 +125,22 @@ int validateTool::parseCommandLine(int argc, char* argv[]) {
     exit(1);
   }
 
+// Check the number of threads and the chunk size.
+  if (threads < 1 || chunkSize < 0) {
+    cerr << "ERROR: --threads (-j) must be at least 1 and --chunk-size (-z) cannot be negative." << endl;
+    exit(1);
+  }
+
   return 0;
 }
 
-// Run the tool.
-int validateTool::Run(int argc, char* argv[]) {
-  int getOptions = validateTool::parseCommandLine(argc, argv);
-
-  // Create a vcf object.
-  vcf v; // Create a vcf object.
-  v.openVcf(vcfFile);
+// Validate all of the records read from the vcf file.  Errors are
+// written to the given stream and error is set if any are found.
+void validateTool::validateRecords(vcfHeader& header, vcf& v, variant& var, bool& error, ostream* errorStream) {
+  unsigned int currentReferenceSequenceID = NO_CONTIG;
 
-  // Define a variant object.
-  variant var; // Define variant object.
-  var.determineVariantsToProcess(true, true, true, true, true, true, false, true, false);
-
-  // Define a header object and parse the header information.
-  vcfHeader header;
-  header.parseHeader(v.input);
-
-  // Check that all of the info descriptions in the header are in the correct form.
-  map<string, headerInfo>::iterator iter;
-  for (iter = header.infoFields.begin(); iter != header.infoFields.end(); iter++) {
-    if ( !(iter->second.success) ) {
-      cerr << "ERROR: Malformed info string in the header: " << iter->first << endl;
-      exit(1);
-    }
-  }
-
-  for (iter = header.formatFields.begin(); iter != header.formatFields.end(); iter++) {
-    if ( !(iter->second.success) ) {
-      cerr << "ERROR: Malformed format string in the header: " << iter->first << endl;
-      exit(1);
-    }
-  }
+  var.errorStream = errorStream;
+  v.errorStream   = errorStream;
 
   // Read through all the entries in the file.
   v.success = v.getRecord();
@@ -141,15 +148,15 @@ int validateTool::Run(int argc, char* argv[]) {
 
     // Build the variant structure for this reference sequence.
     if (var.originalVariantsMap.size() == 0) {
-      currentReferenceSequence = v.variantRecord.referenceSequence;
-      v.success = var.buildVariantStructure(v);
+      currentReferenceSequenceID = v.variantRecord.referenceSequenceID;
+      v.success                = var.buildVariantStructure(v);
     }
 
     // Loop over the variant structure until it is empty.  While v.update is true,
     // i.e. when the reference sequence is still the current reference sequence,
     // keep adding variants to the structure.
     while (var.originalVariantsMap.size() != 0) {
-      if (v.variantRecord.referenceSequence == currentReferenceSequence && v.success) {
+      if (v.variantRecord.referenceSequenceID == currentReferenceSequenceID && v.success) {
         var.addVariantToStructure(v.position, v.variantRecord);
         v.success = v.getRecord();
       }
@@ -164,17 +171,74 @@ int validateTool::Run(int argc, char* argv[]) {
 
         // Check the info string for inconsistencies.
         variantInfo info(var.ovIter->info);
+        info.errorStream = errorStream;
         info.validateInfo(header, var.ovIter->referenceSequence, var.ovIter->position, var.ovIter->numberAlts, error);
 
         // Check the genotypes for inconsistencies.
         if (var.ovIter->hasGenotypes) {
           genotypeInfo gen(var.ovIter->genotypeFormat, var.ovIter->genotypes);
+          gen.errorStream = errorStream;
           gen.validateGenotypes(header, var.ovIter->referenceSequence, var.ovIter->position, var.ovIter->numberAlts, error);
         }
       }
       var.originalVariantsMap.erase(var.ovmIter);
     }
   }
+}
+
+// Run the tool.
+int validateTool::Run(int argc, char* argv[]) {
+  int getOptions = validateTool::parseCommandLine(argc, argv);
+
+  // Create a vcf object.
+  vcf v; // Create a vcf object.
+  v.openVcf(vcfFile);
+
+  // Define a header object and parse the header information.
+  vcfHeader header;
+  header.parseHeader(v.input);
+
+  // Restrict the records read to the requested regions.
+  if (region != "") {v.setRegions(region);}
+
+  // Check that all of the info descriptions in the header are in the correct form.
+  map<string, headerInfo>::iterator iter;
+  for (iter = header.infoFields.begin(); iter != header.infoFields.end(); iter++) {
+    if ( !(iter->second.success) ) {
+      cerr << "ERROR: Malformed info string in the header: " << iter->first << endl;
+      exit(1);
+    }
+  }
+
+  for (iter = header.formatFields.begin(); iter != header.formatFields.end(); iter++) {
+    if ( !(iter->second.success) ) {
+      cerr << "ERROR: Malformed format string in the header: " << iter->first << endl;
+      exit(1);
+    }
+  }
+
+  // If multiple threads are to be used, validate each region of the file
+  // on a separate thread and write out the errors in file order.
+  parallelRegions parallel;
+  if (threads > 1 && parallel.openIndex(vcfFile)) {
+    vector<regionJob*> jobs;
+
+    parallel.buildTasks(region, chunkSize);
+    for (unsigned int i = 0; i < parallel.tasks.size(); i++) {jobs.push_back(new validateJob(this));}
+    parallel.start(jobs, threads);
+    for (vector<regionJob*>::iterator iter = jobs.begin(); iter != jobs.end(); iter++) {
+      parallel.waitFor(*iter);
+      cerr << (*iter)->errors.str();
+      if (((validateJob*) *iter)->error) {error = true;}
+      delete *iter;
+    }
+
+  // Otherwise, validate the records on this thread.
+  } else {
+    variant var;
+    var.determineVariantsToProcess(true, true, true, true, true, true, false, true, false);
+    validateRecords(header, v, var, error, &cerr);
+  }
 
   // Close the vcf files.
   v.closeVcf();
@@ -184,3 +248,17 @@ int validateTool::Run(int argc, char* argv[]) {
 
   return 0;
 }
+
+// validateJob implementation.
+validateJob::validateJob(validateTool* parent) {
+  error = false;
+  tool  = parent;
+}
+
+// Validate the records in the region.
+void validateJob::processRegion(vcfHeader& header, vcf& v) {
+  variant var;
+
+  var.determineVariantsToProcess(true, true, true, true, true, true, false, true, false);
+  tool->validateRecords(header, v, var, error, &errors);
+}
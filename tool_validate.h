@@ -23,6 +23,7 @@
 #include "genotype_info.h"
 #include "header.h"
 #include "info.h"
+#include "parallel.h"
 #include "symbolic_alternates.h"
 #include "variant.h"
 #include "vcf.h"
@@ -39,13 +40,28 @@ class validateTool : public AbstractTool {
     int Help(void);
     int Run(int argc, char* argv[]);
     int parseCommandLine(int argc, char* argv[]);
+    void validateRecords(vcfHeader&, vcf&, variant&, bool&, ostream*);
     //void validateAlternateAlleles(vcfHeader&, variant&);
 
   private:
     bool error;
     string commandLine;
-    string currentReferenceSequence;
     string vcfFile;
+    string region;
+    int threads;
+    int chunkSize;
+};
+
+// Validate the records in a single region when running on multiple
+// threads.  Any errors are kept until the job is collected.
+class validateJob : public regionJob {
+  public:
+    validateJob(validateTool*);
+    void processRegion(vcfHeader&, vcf&);
+
+  public:
+    validateTool* tool;
+    bool error;
 };
 
 } // namespace vcfCTools
@@ -0,0 +1,399 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Write out a vcf file keeping only the genotypes of a
+// subset of the samples.
+// ******************************************************
+
+#include "tool_view.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+using namespace vcfCTools;
+
+// Append an unsigned integer to a string.
+static void appendNumber(string& text, unsigned int value) {
+  char digits[16];
+  int length = snprintf(digits, sizeof(digits), "%u", value);
+  text.append(digits, length);
+}
+
+// viewTool implementation.
+viewTool::viewTool(void)
+  : AbstractTool()
+{
+  alleleNumber    = 0;
+  calculateCounts = false;
+  gtIndex         = -1;
+}
+
+// Destructor.
+viewTool::~viewTool(void) {}
+
+// Help
+int viewTool::Help(void) {
+  cout << "View help" << endl;
+  cout << "Usage: ./vcfCTools view [options]." << endl;
+  cout << endl;
+  cout << "Write out the records of a vcf file with the genotypes of the selected" << endl;
+  cout << "samples only.  The samples are kept in the order they appear in the vcf" << endl;
+  cout << "file.  The genotypes are copied as they are; only the info field is" << endl;
+  cout << "changed, and only if the allele counts are recalculated." << endl;
+  cout << endl;
+  cout << "Options:" << endl;
+  cout << "  -h, --help" << endl;
+  cout << "	display view help." << endl;
+  cout << "  -i, --in" << endl;
+  cout << "	input vcf file." << endl;
+  cout << "  -o, --out" << endl;
+  cout << "	output vcf file." << endl;
+  cout << "  -s, --samples" << endl;
+  cout << "	samples to keep (comma separated list)." << endl;
+  cout << "  -S, --samples-file" << endl;
+  cout << "	file containing the samples to keep (one per line)." << endl;
+  cout << "  -c, --calculate-counts" << endl;
+  cout << "	recalculate the AC and AN info fields from the genotypes of the kept samples" << endl;
+  cout << "	(records without GT in the format are left unchanged)." << endl;
+  cout << endl;
+  exit(0);
+
+  return 0;
+}
+
+// Parse the command line and get all required and optional arguments.
+int viewTool::parseCommandLine(int argc, char* argv[]) {
+  commandLine = argv[0];
+  for (int i = 2; i < argc; i++) {
+    commandLine += " ";
+    commandLine += argv[i];
+  }
+
+  int argument; // Counter for getopt.
+
+  // Define the long options.
+  while (true) {
+    static struct option long_options[] = {
+      {"help", no_argument, 0, 'h'},
+      {"in", required_argument, 0, 'i'},
+      {"out", required_argument, 0, 'o'},
+      {"samples", required_argument, 0, 's'},
+      {"samples-file", required_argument, 0, 'S'},
+      {"calculate-counts", no_argument, 0, 'c'},
+
+      {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    argument = getopt_long(argc, argv, "hi:o:s:S:c", long_options, &option_index);
+
+    if (argument == -1) {break;}
+    switch (argument) {
+
+      // Input vcf file - required input.
+      case 'i':
+        vcfFile = optarg;
+        break;
+
+      // Output vcf file.
+      case 'o':
+        outputFile = optarg;
+        break;
+
+      // Samples to keep.
+      case 's':
+        samplesList = optarg;
+        break;
+
+      // File containing the samples to keep.
+      case 'S':
+        samplesFile = optarg;
+        break;
+
+      // Recalculate the allele counts.
+      case 'c':
+        calculateCounts = true;
+        break;
+
+      // Help.
+      case 'h':
+        return Help();
+
+      //
+      case '?':
+        cerr << "Unknown option: " << argv[optind - 1] << endl;
+        exit(1);
+
+      // default
+      default:
+        abort ();
+
+    }
+  }
+
+// Remaining arguments are unknown, so terminate with an error.
+  if (optind < argc - 1) {
+    cerr << "Unknown options." << endl;
+    exit(1);
+  }
+
+// Check that a vcf file was specified.
+  if (vcfFile == "") {
+    cerr << "A vcf file must be specified (--in, -i)." << endl;
+    exit(1);
+  }
+
+// Check that samples were specified.
+  if (samplesList == "" && samplesFile == "") {
+    cerr << "ERROR: The samples to keep must be specified (--samples, -s or --samples-file, -S)." << endl;
+    exit(1);
+  }
+
+  return 0;
+}
+
+// Find the requested samples in the header and keep only those in the
+// header.
+void viewTool::selectSamples(vcfHeader& header) {
+  samples sl;
+  if (samplesFile != "") {sl.openSamplesFile(samplesFile);}
+  if (samplesList != "") {sl.addSamples(samplesList);}
+  sl.getSamples(header);
+  if (sl.noSamples == 0) {
+    cerr << "ERROR: None of the requested samples are present in the vcf file." << endl;
+    exit(1);
+  }
+
+  for (map<string, int>::iterator iter = sl.samplesMap.begin(); iter != sl.samplesMap.end(); iter++) {
+    selectedSamples.push_back(iter->second);
+  }
+  sort(selectedSamples.begin(), selectedSamples.end());
+
+  vector<string> names;
+  isSelected.assign(header.samples.size(), false);
+  for (vector<unsigned int>::iterator iter = selectedSamples.begin(); iter != selectedSamples.end(); iter++) {
+    names.push_back(header.samples[*iter]);
+    isSelected[*iter] = true;
+  }
+  header.samples.swap(names);
+  header.numberSamples = header.samples.size();
+}
+
+// Build the output record from a record of the input file.  The columns
+// before the genotypes are copied (with a new info field if the counts are
+// recalculated), followed by the selected samples.  Samples after the last
+// selected sample are not read.
+void viewTool::subsetRecord(const string& line, string& record) {
+  const char* data = line.data();
+  const char* end  = data + line.size();
+
+  // Find the start of the first nine columns.  Records without genotypes
+  // are written as they are.
+  size_t columns[10];
+  const char* start = data;
+  for (unsigned int column = 0; column < 9; column++) {
+    columns[column]  = start - data;
+    const char* tab  = (const char*) memchr(start, '\t', end - start);
+    if (tab == NULL) {
+      record = line;
+      return;
+    }
+    start = tab + 1;
+  }
+  columns[9] = start - data;
+
+  // Find the selected samples.
+  keptSamples.clear();
+  unsigned int ordinal = 0;
+  while (keptSamples.size() < selectedSamples.size()) {
+    const char* tab = (const char*) memchr(start, '\t', end - start);
+    if (tab == NULL) {tab = end;}
+    if (isSelected[ordinal]) {
+      stringSpan span;
+      span.start  = start - data;
+      span.length = tab - start;
+      keptSamples.push_back(span);
+    }
+    ordinal++;
+    if (tab == end || ordinal == isSelected.size()) {break;}
+    start = tab + 1;
+  }
+
+  // Find GT in the format.  The position is kept until the format changes.
+  if (calculateCounts && line.compare(columns[8], columns[9] - columns[8] - 1, format) != 0) {
+    format.assign(line, columns[8], columns[9] - columns[8] - 1);
+    vector<string> keys = split(format, ':');
+    gtIndex = -1;
+    for (unsigned int i = 0; i < keys.size(); i++) {
+      if (keys[i] == "GT") {gtIndex = i;}
+    }
+  }
+
+  // Records without genotypes in the format keep their info field.
+  if (calculateCounts && gtIndex != -1) {
+
+    // Count the alternate alleles.
+    unsigned int numberAlts = 0;
+    if (line.compare(columns[4], columns[5] - columns[4] - 1, ".") != 0) {
+      numberAlts = count(data + columns[4], data + columns[5] - 1, ',') + 1;
+    }
+
+    alleleCounts.assign(numberAlts, 0);
+    alleleNumber = 0;
+    for (vector<stringSpan>::iterator iter = keptSamples.begin(); iter != keptSamples.end(); iter++) {
+      countAlleles(data + iter->start, data + iter->start + iter->length);
+    }
+
+    stringSpan info;
+    info.start  = columns[7];
+    info.length = columns[8] - columns[7] - 1;
+    record.assign(line, 0, columns[7]);
+    updateInfo(line, info, record);
+    record += '\t';
+    record.append(line, columns[8], columns[9] - columns[8] - 1);
+  } else {
+    record.assign(line, 0, columns[9] - 1);
+  }
+
+  for (vector<stringSpan>::iterator iter = keptSamples.begin(); iter != keptSamples.end(); iter++) {
+    record += '\t';
+    record.append(line, iter->start, iter->length);
+  }
+}
+
+// Add the alleles in the GT field of a sample to the allele counts.
+// Unknown alleles, and alleles not in the record, are not counted.
+void viewTool::countAlleles(const char* start, const char* end) {
+  if (gtIndex == -1) {return;}
+
+  for (int i = 0; i < gtIndex; i++) {
+    start = (const char*) memchr(start, ':', end - start);
+    if (start == NULL) {return;}
+    start++;
+  }
+  const char* colon = (const char*) memchr(start, ':', end - start);
+  if (colon != NULL) {end = colon;}
+
+  unsigned int allele = 0;
+  bool hasDigits      = false;
+  for (const char* c = start; ; c++) {
+    if (c == end || *c == '/' || *c == '|') {
+      if (hasDigits) {
+        if (allele == 0) {alleleNumber++;}
+        else if (allele <= alleleCounts.size()) {
+          alleleCounts[allele - 1]++;
+          alleleNumber++;
+        }
+      }
+      allele    = 0;
+      hasDigits = false;
+      if (c == end) {break;}
+    } else if (*c >= '0' && *c <= '9') {
+      allele    = 10 * allele + (*c - '0');
+      hasDigits = true;
+    } else {
+      hasDigits = false;
+      allele    = 0;
+      while (c + 1 != end && c[1] != '/' && c[1] != '|') {c++;}
+    }
+  }
+}
+
+// Append the info field with the AC and AN values replaced by the counts.
+// The other fields keep their order and the counts are added after them.
+// AC is left out of records without alternate alleles.
+void viewTool::updateInfo(const string& line, stringSpan& info, string& record) {
+  bool first = true;
+
+  if (line.compare(info.start, info.length, ".") != 0) {
+    const char* start = line.data() + info.start;
+    const char* end   = start + info.length;
+    while (start < end) {
+      const char* stop = (const char*) memchr(start, ';', end - start);
+      if (stop == NULL) {stop = end;}
+      const char* equals = (const char*) memchr(start, '=', stop - start);
+      size_t tagLength   = ((equals == NULL) ? stop : equals) - start;
+
+      bool isCount = tagLength == 2 && (memcmp(start, "AC", 2) == 0 || memcmp(start, "AN", 2) == 0);
+      if (!isCount && stop != start) {
+        if (!first) {record += ';';}
+        record.append(start, stop - start);
+        first = false;
+      }
+      start = stop + 1;
+    }
+  }
+
+  if (alleleCounts.size() != 0) {
+    if (!first) {record += ';';}
+    record += "AC=";
+    for (unsigned int i = 0; i < alleleCounts.size(); i++) {
+      if (i != 0) {record += ',';}
+      appendNumber(record, alleleCounts[i]);
+    }
+    first = false;
+  }
+  if (!first) {record += ';';}
+  record += "AN=";
+  appendNumber(record, alleleNumber);
+}
+
+// Run the tool.
+int viewTool::Run(int argc, char* argv[]) {
+  int getOptions = viewTool::parseCommandLine(argc, argv);
+
+  // Define an output object and open the output file.
+  output ofile;
+  ofile.outputStream = ofile.openOutputFile(outputFile);
+
+  // Define the vcf object.
+  vcf v;
+  v.openVcf(vcfFile);
+
+  // Define the header object and read in the header information.
+  vcfHeader header;
+  header.parseHeader(v.input);
+
+  // Keep only the selected samples in the header and describe the counts
+  // if they are being added.
+  selectSamples(header);
+  string taskDescription = "##vcfCTools=view kept samples ";
+  for (vector<string>::iterator iter = header.samples.begin(); iter != header.samples.end(); iter++) {
+    if (iter != header.samples.begin()) {taskDescription += ",";}
+    taskDescription += *iter;
+  }
+  if (calculateCounts) {
+    taskDescription += " and recalculated AC and AN";
+    if (header.infoFields.count("AC") == 0) {
+      header.infoLine["AC"] = "##INFO=<ID=AC,Number=A,Type=Integer,Description=\"Allele count in genotypes, for each ALT allele\">";
+    }
+    if (header.infoFields.count("AN") == 0) {
+      header.infoLine["AN"] = "##INFO=<ID=AN,Number=1,Type=Integer,Description=\"Total number of alleles in called genotypes\">";
+    }
+  }
+  header.writeHeader(ofile.outputStream, false, taskDescription);
+
+  // Write out each record with the selected samples.
+  string line, record;
+  v.startReader();
+  ofile.startWriter();
+  while (v.reader.getLine(line)) {
+    if (line.empty() || line[0] == '#') {continue;}
+    subsetRecord(line, record);
+    ofile.writeRecord(record);
+  }
+
+  // Close the vcf file.
+  v.closeVcf();
+
+  // Flush the output buffer.
+  ofile.flushOutputBuffer();
+  ofile.closeOutputFile();
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+// ******************************************************
+// vcfCTools (c) 2011 Alistair Ward
+// Marth Lab, Department of Biology, Boston College
+// All rights reserved.
+// ------------------------------------------------------
+// Last modified: 18 February 2011
+// ------------------------------------------------------
+// Write out a vcf file keeping only the genotypes of a
+// subset of the samples.
+// ******************************************************
+
+#ifndef TOOL_VIEW_H
+#define TOOL_VIEW_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <stdlib.h>
+
+#include "header.h"
+#include "output.h"
+#include "samples.h"
+#include "split.h"
+#include "vcf.h"
+#include "vcfCTools_tool.h"
+
+using namespace std;
+
+namespace vcfCTools {
+
+class viewTool : public AbstractTool {
+  public:
+    viewTool(void);
+    ~viewTool(void);
+    int Help(void);
+    int Run(int argc, char* argv[]);
+    int parseCommandLine(int argc, char* argv[]);
+    void selectSamples(vcfHeader&);
+    void subsetRecord(const string&, string&);
+    void countAlleles(const char*, const char*);
+    void updateInfo(const string&, stringSpan&, string&);
+
+  private:
+    string commandLine;
+    string outputFile;
+    string samplesFile;
+    string samplesList;
+    string vcfFile;
+
+    // Recalculate the AC and AN info fields from the kept genotypes.
+    bool calculateCounts;
+
+    // The selected samples (by ordinal, in file order) and a flag for
+    // every sample in the file.
+    vector<unsigned int> selectedSamples;
+    vector<bool> isSelected;
+
+    // The samples kept from the current record, the position of GT in
+    // the format and the allele counts.
+    vector<stringSpan> keptSamples;
+    string format;
+    int gtIndex;
+    vector<unsigned int> alleleCounts;
+    unsigned int alleleNumber;
+};
+
+} // namespace vcfCTools
+
+#endif // TOOL_VIEW_H
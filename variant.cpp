@@ -15,6 +15,8 @@ using namespace vcfCTools;
 
 //Constructor.
 variant::variant(void) {
+  errorStream           = &cerr;
+  fasta                 = DEFAULT_REFERENCE_FASTA;
   isDbsnp               = false;
   processAll            = false;
   processComplex        = false;
@@ -77,25 +79,26 @@ bool variant::buildVariantStructure(vcf& v) {
 // When variants in the correct reference sequence are found, build the variant
 // structure.
   count = 0;
-  string tempReferenceSequence = v.variantRecord.referenceSequence;
+  unsigned int referenceSequenceID = v.variantRecord.referenceSequenceID;
 
   // If this is not the first time that this reference sequence has been seen
   // when building, the structure then the records for this reference sequence
   // are not contiguous in the vcf file.  For a number of tools (especially
   // the intersect tool), this will cause erroneous results to be generated.
-  if (referenceSequenceInfo.count(tempReferenceSequence) != 0) {
-    referenceSequenceInfo[tempReferenceSequence].contiguous = false;
+  // The information is found once, rather than for every record.
+  refSeqIter = referenceSequenceInfo.find(v.variantRecord.referenceSequence);
+  if (refSeqIter != referenceSequenceInfo.end()) {
+    refSeqIter->second.contiguous = false;
+  } else if (v.success && recordsInMemory != 0) {
+    refSeqIter = referenceSequenceInfo.insert(make_pair(v.variantRecord.referenceSequence, refSeqInfo())).first;
+    refSeqIter->second.numberRecords    = 0;
+    refSeqIter->second.usedInComparison = false;
+    refSeqIter->second.contiguous       = true;
   }
-  while (v.success && count < recordsInMemory && v.variantRecord.referenceSequence == tempReferenceSequence) {
+  while (v.success && count < recordsInMemory && v.variantRecord.referenceSequenceID == referenceSequenceID) {
 
     // Update the information about observed reference sequences.
-    if (referenceSequenceInfo.count(tempReferenceSequence) == 0) {
-      referenceSequenceInfo[tempReferenceSequence].numberRecords    = 1;
-      referenceSequenceInfo[tempReferenceSequence].usedInComparison = false;
-      referenceSequenceInfo[tempReferenceSequence].contiguous       = true;
-    } else {
-      referenceSequenceInfo[tempReferenceSequence].numberRecords++;
-    }
+    refSeqIter->second.numberRecords++;
 
     // Add the variant into the structure.
     addVariantToStructure(v.position, v.variantRecord);
@@ -116,35 +119,45 @@ void variant::addVariantToStructure(int position, variantDescription& variant) {
   variantType type;
   reducedVariants rVar;
 
-  // Since there can be multiple records for the same locus, define an
-  // originalVariants structure and populate it with information about
-  // the current record.  When complete, push this into the vector of
-  // records at this locus.
-  originalVariants ov;
+  // Since there can be multiple records for the same locus, add an
+  // originalVariants structure to the records at this locus and populate
+  // it with information about the current record.  The structure may be
+  // one left over from an erased locus, so every field is set.
+  recycledVector<originalVariants>& records = originalVariantsMap[position];
+  unsigned int recordsAtLocus = records.size();
+  originalVariants& ov = records.push_back();
+  ov.clearAlleles();
 
   // First, update all vectors whose size is the number of records at this locus.
-  ov.referenceSequence = variant.referenceSequence;
+  ov.referenceSequence   = variant.referenceSequence;
+  ov.referenceSequenceID = variant.referenceSequenceID;
   ov.position          = position;
   ov.numberAlts        = alts.size();
   ov.rsid              = variant.rsid;
   ov.ref               = variant.ref;
   ov.altString         = variant.altString;
   ov.quality           = variant.quality;
+  ov.qualityString     = variant.qualityString;
   ov.filters           = variant.filters;
-  ov.info              = variant.info;
   ov.hasGenotypes      = variant.hasGenotypes;
   ov.genotypeFormat    = variant.genotypeFormatString;
-  ov.genotypes         = variant.genotypeString;
+
+  // The info and genotype strings can be long and are not needed in the
+  // variant description once the record is stored, so take them rather
+  // than copying them.
+  ov.info.swap(variant.info);
+  ov.genotypes.swap(variant.genotypeString);
   ov.maxPosition       = position;
+  ov.sources           = 0;
 
   // Now update information based on whether this is the first record at this
   // locus.
-  if (originalVariantsMap[position].size() == 0) {
+  if (recordsAtLocus == 0) {
     ov.hasMultipleRecords     = false;
     ov.numberOfRecordsAtLocus = 1;
   } else {
     ov.hasMultipleRecords     = true;
-    ov.numberOfRecordsAtLocus = originalVariantsMap[position].size() + 1;
+    ov.numberOfRecordsAtLocus = recordsAtLocus + 1;
   }
 
   // If the individual alternate alleles need to be examined to 
@@ -175,7 +188,7 @@ void variant::addVariantToStructure(int position, variantDescription& variant) {
 
       // Add both alleles separately to the originalVariantsMap reduced alleles structure.
       for (altIter = alts.begin(); altIter != alts.end(); altIter++) {
-        updateVariantMaps(*altIter, type, variant.ref, *altIter, position, variant.referenceSequence, ov);
+        updateVariantMaps(*altIter, type, variant.ref, *altIter, position, ov);
 
         // Now store the reduced description in the secondary structure if required.
         if (storeReducedAlts) {
@@ -196,7 +209,7 @@ void variant::addVariantToStructure(int position, variantDescription& variant) {
 
       // Add all alleles separately to the originalVariantsMap reduced alleles structure.
       for (altIter = alts.begin(); altIter != alts.end(); altIter++) {
-        updateVariantMaps(*altIter, type, variant.ref, *altIter, position, variant.referenceSequence, ov);
+        updateVariantMaps(*altIter, type, variant.ref, *altIter, position, ov);
         if (storeReducedAlts) {
           rVar.recordNumber     = ov.numberOfRecordsAtLocus;
           rVar.originalPosition = position;
@@ -248,9 +261,6 @@ void variant::addVariantToStructure(int position, variantDescription& variant) {
     }
   }
 
-  // Update the originalVariantsMap.
-  originalVariantsMap[position].push_back(ov);
-
   //if (position == 137939) {exit(0);}
 
   // The maxPosition value is used by the intersection routine to determine
@@ -284,7 +294,7 @@ void variant::clearType(variantType& type) {
 
 // Determine the variant class from the ref and alt alleles.
 //void variant::determineVariantType(int position, string ref, string alt, variantDescription& variant, bool isDbsnp) {
-void variant::determineVariantType(string refSeq, int position, string ref, string alt, variantType& type, int ID, originalVariants& ov) {
+void variant::determineVariantType(string& refSeq, int position, const string& ref, const string& alt, variantType& type, int ID, originalVariants& ov) {
   reducedVariants rVar;
   size_t containsAngleBracket   = alt.find('<');
   size_t containsSquareBracketL = alt.find('[');
@@ -293,7 +303,7 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
   // SNP.
   if (ref.size() == 1 && (ref.size() - alt.size()) == 0) {
     type.isBiallelicSnp = true;
-    updateVariantMaps(alt, type, ref, alt, position, refSeq, ov);
+    updateVariantMaps(alt, type, ref, alt, position, ov);
 
     if (storeReducedAlts) {
       rVar.recordNumber     = ov.numberOfRecordsAtLocus;
@@ -307,7 +317,7 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
   // Structural variants.
   } else if (containsAngleBracket != string::npos) {
     type.isSv = true;
-    updateVariantMaps(alt, type, ref, alt, position, refSeq, ov);
+    updateVariantMaps(alt, type, ref, alt, position, ov);
 
     if (storeReducedAlts) {
       rVar.recordNumber     = ov.numberOfRecordsAtLocus;
@@ -321,7 +331,7 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
   // Complex rearrangments.
   } else if (containsSquareBracketL != string::npos || containsSquareBracketR != string::npos) {
     type.isRearrangement = true;
-    updateVariantMaps(alt, type, ref, alt, position, refSeq, ov);
+    updateVariantMaps(alt, type, ref, alt, position, ov);
 
     if (storeReducedAlts) {
       rVar.recordNumber     = ov.numberOfRecordsAtLocus;
@@ -341,21 +351,17 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
     // between the ref and alt, or just trimming the ref and alt until
     // just matching sequence is left.
     modifyAlleles mod(refSeq, position, ref, alt);
-
-    // TO MODIFY
-    // Define the reference fasta file.  ***A COMMAND LINE
-    // PATH SHOULD BE ALLOWED FOR THIS***
-    mod.fasta = "/d2/data/references/build_37/human_reference_v37.fa";
+    mod.fasta = fasta;
 
     mod.trim();
     if (mod.modifiedPosition != mod.originalPosition) {
-      cerr << "WARNING: Modified variant position from " << refSeq;
-      cerr << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
+      *errorStream << "WARNING: Modified variant position from " << refSeq;
+      *errorStream << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
     }
 
     // Populate the structure rVar with the modified variant.
     rVar.recordNumber     = ov.numberOfRecordsAtLocus;
-    rVar.originalPosition = mod.modifiedPosition;
+    rVar.originalPosition = position;
     rVar.ref              = mod.modifiedRef;
     rVar.alt              = mod.modifiedAlt;
     rVar.altID            = ID;
@@ -381,13 +387,13 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
       }
 
       // Update the structures.
-      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, refSeq, ov);
+      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, ov);
       if (storeReducedAlts) {variantMap[position].snps.push_back(rVar);}
 
     // MNP.
     } else if (mod.modifiedRef.size() != 1 && (mod.modifiedRef.size() - mod.modifiedAlt.size()) == 0) {
       type.isMnp = true;
-      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, refSeq, ov);
+      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, ov);
       if (storeReducedAlts) {variantMap[position].mnps.push_back(rVar);}
 
     // Indels are checked to ensure that they are left aligned.  A variant
@@ -400,10 +406,10 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
       type.isInsertion = true;
       mod.type = type;
       mod.stepAlleles();
-      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, refSeq, ov);
+      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, ov);
       if (mod.originalPosition != mod.modifiedPosition) {
-        cerr << "WARNING: Modified insertion locus from " << refSeq;
-        cerr << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
+        *errorStream << "WARNING: Modified insertion locus from " << refSeq;
+        *errorStream << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
       }
       if (storeReducedAlts) {variantMap[mod.modifiedPosition].insertions.push_back(rVar);}
 
@@ -413,11 +419,11 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
       mod.type = type;
       mod.stepAlleles();
       if (mod.originalPosition != mod.modifiedPosition) {
-        cerr << "WARNING: Modified deletion locus from " << refSeq;
-        cerr << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
+        *errorStream << "WARNING: Modified deletion locus from " << refSeq;
+        *errorStream << ":" << mod.originalPosition << " to " << refSeq << ":" << mod.modifiedPosition << endl;
       }
 
-      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, refSeq, ov);
+      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, ov);
       if (storeReducedAlts) {variantMap[mod.modifiedPosition].deletions.push_back(rVar);}
 
     // Remaining variants are in the complex class.
@@ -426,7 +432,7 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
       mod.type = type;
       //mod.extendAlleles();
       //mod.alignAlleles();
-      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, refSeq, ov);
+      updateVariantMaps(alt, type, mod.modifiedRef, mod.modifiedAlt, mod.modifiedPosition, ov);
       if (storeReducedAlts) {variantMap[mod.modifiedPosition].complexVariants.push_back(rVar);}
     }
   }
@@ -434,7 +440,7 @@ void variant::determineVariantType(string refSeq, int position, string ref, stri
 
 // Update the variant maps with the information about individual
 // alternate alleles.
-void variant::updateVariantMaps(string alt, variantType type, string alRef, string alAlt, int position, string refSeq, originalVariants& ov) {
+void variant::updateVariantMaps(const string& alt, variantType& type, const string& alRef, const string& alAlt, int position, originalVariants& ov) {
   ov.alts.push_back(alt);
   ov.filtered.push_back(false);
   ov.type.push_back(type);
@@ -443,7 +449,7 @@ void variant::updateVariantMaps(string alt, variantType type, string alRef, stri
   ov.reducedPosition.push_back(position);
 
   if (position > ov.maxPosition) {ov.maxPosition = position;}
-  if (storeReducedAlts) {variantMap[position].referenceSequence = refSeq;}
+  if (storeReducedAlts) {variantMap[position].referenceSequenceID = ov.referenceSequenceID;}
 }
 
 // Loop over all variants contained in the originalVariantsMap and send them to
@@ -466,7 +472,7 @@ void variant::clearOriginalVariants(vcfHeader& header, intFlags& flags, output&
 //
 // Only the originalVariantsMap is used for building output records,
 // so the variantMap can be kept clear at all times.
-void variant::clearReferenceSequence(vcfHeader& header, vcf& v, intFlags flags, string cRef, output& ofile, bool write) {
+void variant::clearReferenceSequence(vcfHeader& header, vcf& v, intFlags flags, unsigned int cRef, output& ofile, bool write) {
   while (originalVariantsMap.size() != 0) {
 
     // Since the vcf file to compare with has been exhausted, all of
@@ -489,7 +495,7 @@ void variant::clearReferenceSequence(vcfHeader& header, vcf& v, intFlags flags,
     if (variantMap.size() != 0) {variantMap.erase(vmIter);}
 
     // Update the originalVariants structure.
-    if (v.variantRecord.referenceSequence == cRef && v.success) {
+    if (v.variantRecord.referenceSequenceID == cRef && v.success) {
       addVariantToStructure(v.position, v.variantRecord);
       v.success = v.getRecord();
     }
@@ -501,7 +507,7 @@ void variant::clearReferenceSequence(vcfHeader& header, vcf& v, intFlags flags,
 // If a vcf file is being intersected with a bed file and all of the
 // bed intervals have been processed, flush out the remaining variants
 // in the data structure for this reference sequence.
-void variant::clearReferenceSequenceBed(vcfHeader& header, vcf& v, intFlags flags, string cRef, output& ofile) {
+void variant::clearReferenceSequenceBed(vcfHeader& header, vcf& v, intFlags flags, unsigned int cRef, output& ofile) {
   while (originalVariantsMap.size() != 0) {
     if (flags.annotate) {}
 
@@ -523,7 +529,7 @@ void variant::clearReferenceSequenceBed(vcfHeader& header, vcf& v, intFlags flag
     if (variantMap.size() != 0) {variantMap.erase(vmIter);}
     
     // Update the originalVariants structure.
-    if (v.variantRecord.referenceSequence == cRef && v.success) {
+    if (v.variantRecord.referenceSequenceID == cRef && v.success) {
       addVariantToStructure(v.position, v.variantRecord);
       v.success = v.getRecord();
     }
@@ -532,39 +538,19 @@ void variant::clearReferenceSequenceBed(vcfHeader& header, vcf& v, intFlags flag
   }
 }
 
-// Annotate the variants at this locus with the contents of the bed file.
-void variant::annotateRecordBed(bedRecord& b) {
-//  // SNPs.
-//  if (processSnps) {
-//    for (variantIter = vmIter->second.biSnps.begin(); variantIter != vmIter->second.biSnps.end(); variantIter++) {
-//      if (variantIter->info != "" && variantIter->info != ".") {variantIter->info += ";" + b.info;}
-//      else {variantIter->info = b.info;}
-//      buildRecord(vmIter->first, *variantIter); // tools.cpp
-//    }
-//    for (variantIter = vmIter->second.multiSnps.begin(); variantIter != vmIter->second.multiSnps.end(); variantIter++) {
-//      if (variantIter->info != "" && variantIter->info != ".") {variantIter->info += ";" + b.info;}
-//      else {variantIter->info = b.info;}
-//      buildRecord(vmIter->first, *variantIter); // tools.cpp
-//    }
-//  }
-// 
-//  // MNPs.
-//  if (processMnps) {
-//    for (variantIter = vmIter->second.mnps.begin(); variantIter != vmIter->second.mnps.end(); variantIter++) {
-//      if (variantIter->info != "" && variantIter->info != ".") {variantIter->info += ";" + b.info;}
-//      else {variantIter->info = b.info;}
-//      buildRecord(vmIter->first, *variantIter); // tools.cpp
-//    }
-//  }
-// 
-//  // Indels.
-//  if (processIndels) {
-//    for (variantIter = vmIter->second.indels.begin(); variantIter != vmIter->second.indels.end(); variantIter++) {
-//      if (variantIter->info != "" && variantIter->info != ".") {variantIter->info += ";" + b.info;}
-//      else {variantIter->info = b.info;}
-//      buildRecord(vmIter->first, *variantIter); // tools.cpp
-//    }
-//  }
+// Annotate a record with the contents of a bed interval that it overlaps.
+// The bed info is a semi-colon separated list of annotations, each of which
+// is added to the info field unless the record already has it.
+void variant::annotateRecordBed(originalVariants& ov, bedRecord& b) {
+  if (b.info == "") {return;}
+
+  vector<string> annotations = split(b.info, ";");
+  vector<string> existing    = split(ov.info, ";");
+  for (vector<string>::iterator iter = annotations.begin(); iter != annotations.end(); iter++) {
+    if (find(existing.begin(), existing.end(), *iter) != existing.end()) {continue;}
+    ov.info = (ov.info == "" || ov.info == ".") ? *iter : ov.info + ";" + *iter;
+    existing.push_back(*iter);
+  }
 }
 
 // From the intersection routine, two variants are found at the same position.
@@ -576,7 +562,7 @@ void variant::annotateRecordBed(bedRecord& b) {
 //
 // If the variants compared are at the same position.
 void variant::compareVariantsSameLocus(variant& var, intFlags flags) {
-  vector<reducedVariants>::iterator iter;
+  recycledVector<reducedVariants>::iterator iter;
   
   // Compare variant types individually.
   compareAlleles(vmIter->second.snps, var.vmIter->second.snps, flags, var);
@@ -598,59 +584,31 @@ void variant::compareVariantsSameLocus(variant& var, intFlags flags) {
 }
 
 // Compare two arrays of variant alleles of the same type (e.g. all SNPs).
-void variant::compareAlleles(vector<reducedVariants>& alleles1, vector<reducedVariants>& alleles2, intFlags flags, variant& var) {
+void variant::compareAlleles(recycledVector<reducedVariants>& alleles1, recycledVector<reducedVariants>& alleles2, intFlags flags, variant& var) {
   bool write;
   string infoAdd;
   string rsid;
   vector<bool> commonA (alleles1.size(), false);
-  vector<bool> commonB (alleles2.size(), false);
+  vector<bool> commonB;
   vector<bool>::iterator aIter;
   vector<bool>::iterator bIter;
-  vector<reducedVariants>::iterator iter;
-  vector<reducedVariants>::iterator compIter;
-
-  // If it is only necessary for the alleles to share the same starting location,
-  // there is no need to loop over the alleles.  All alleles at this location
-  // are for the same variant class and so shouldn't be filtered out.  If only
-  // one of the files has variants of this type at this location, filter out
-  // all the alleles.
-  if (flags.sitesOnly) {
-    if (alleles1.size() != 0 && alleles2.size() != 0) {
-      aIter = commonA.begin();
-      bIter = commonB.begin();
-      for (; aIter != commonA.end(); aIter++) {*aIter = true;}
-      for (; bIter != commonB.end(); bIter++) {*bIter = true;}
-    }
-  } else {
-    if (alleles1.size() != 0) {
-      iter  = alleles1.begin();
-      aIter = commonA.begin();
-      for (; iter != alleles1.end(); iter++) {
-        if (alleles2.size() != 0) {
-          compIter = alleles2.begin();
-          bIter    = commonB.begin();
-          for (; compIter != alleles2.end(); compIter++) {
-  
-            // If the two files share the alleles, keep them only if the common
-            // alleles (or union) is required.
-            if (iter->alt == compIter->alt && iter->ref == compIter->ref) {
-              if (flags.annotate) {
-                if (var.isDbsnp) {
-                  rsid = var.originalVariantsMap[compIter->originalPosition][compIter->recordNumber - 1].rsid;
-                  infoAdd = "dbSNP";
-                }
-                else {
-                  infoAdd = var.originalVariantsMap[compIter->originalPosition][compIter->recordNumber - 1].filters;
-                }
-              }
-              *aIter = true;
-              *bIter = true;
-              break;
-            }
-            bIter++;
-          }
-        }
-        aIter++;
+  vector<int> matches;
+  recycledVector<reducedVariants>::iterator iter;
+
+  // Find the alleles common to both files.  When annotating, the annotation
+  // is taken from the last matching allele in the second file.
+  matchAlleles(alleles1, alleles2, flags.sitesOnly, matches, commonB);
+  for (unsigned int allele = 0; allele < matches.size(); allele++) {
+    if (matches[allele] == -1) {continue;}
+    commonA[allele] = true;
+    if (flags.annotate && !flags.sitesOnly) {
+      reducedVariants& match = alleles2[matches[allele]];
+      if (var.isDbsnp) {
+        rsid = var.originalVariantsMap[match.originalPosition][match.recordNumber - 1].rsid;
+        infoAdd = "dbSNP";
+      }
+      else {
+        infoAdd = var.originalVariantsMap[match.originalPosition][match.recordNumber - 1].filters;
       }
     }
   }
@@ -713,6 +671,36 @@ void variant::compareAlleles(vector<reducedVariants>& alleles1, vector<reducedVa
   }
 }
 
+// Find the alleles of the first array that also appear in the second.  The
+// index of the first matching allele in the second array is recorded for each
+// allele in the first (-1 if there is no match), and commonB records which of
+// the alleles in the second array were matched.
+//
+// If it is only necessary for the alleles to share the same starting location,
+// there is no need to loop over the alleles.  All alleles at this location
+// are for the same variant class and so are all common if both arrays have
+// alleles.
+void variant::matchAlleles(recycledVector<reducedVariants>& alleles1, recycledVector<reducedVariants>& alleles2, bool sitesOnly, vector<int>& matches, vector<bool>& commonB) {
+  matches.assign(alleles1.size(), -1);
+  commonB.assign(alleles2.size(), false);
+  if (alleles1.size() == 0 || alleles2.size() == 0) {return;}
+
+  if (sitesOnly) {
+    matches.assign(alleles1.size(), 0);
+    commonB.assign(alleles2.size(), true);
+  } else {
+    for (unsigned int a = 0; a < alleles1.size(); a++) {
+      for (unsigned int b = 0; b < alleles2.size(); b++) {
+        if (alleles1[a].alt == alleles2[b].alt && alleles1[a].ref == alleles2[b].ref) {
+          matches[a] = b;
+          commonB[b] = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
 // Annotate the variants at this locus with the contents of the vcf file.
 void variant::annotateRecordVcf(variant& var, int position, unsigned int record, string& rsid, string& infoAdd) {
   string oString;
@@ -735,7 +723,7 @@ void variant::annotateRecordVcf(variant& var, int position, unsigned int record,
 // performing a comparison, set all of the variants to filtered.  This
 // is only called if common alleles are requested.
 void variant::filterUnique() {
-  vector<reducedVariants>::iterator iter;
+  recycledVector<reducedVariants>::iterator iter;
 
   // SNPs.
   iter = vmIter->second.snps.begin();
@@ -916,7 +904,7 @@ void variant::buildOutputRecord(output& ofile, vcfHeader& header) {
       }
 
       // Flush the output record to the output buffer.
-      ofile.flushToBuffer(ovmIter->first, ovIter->referenceSequence);
+      ofile.flushToBuffer(ovmIter->first, ovIter->referenceSequenceID);
     }
   }
 }
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <map>
 #include <vector>
+#include <stdint.h>
 
 #include "bed.h"
 #include "bedStructure.h"
@@ -28,12 +29,17 @@
 #include "info.h"
 #include "modify_alleles.h"
 #include "output.h"
+#include "position_buffer.h"
+#include "recycled_vector.h"
 #include "structures.h"
 #include "tools.h"
 #include "vcf.h"
 
 using namespace std;
 
+// The reference used to left align indels unless another is given.
+#define DEFAULT_REFERENCE_FASTA "/d2/data/references/build_37/human_reference_v37.fa"
+
 namespace vcfCTools {
 
 // Define a structure that contains information about a
@@ -51,9 +57,11 @@ struct originalVariants {
   int position;
   int maxPosition;
   double quality;
+  string qualityString;
   string info;
   string filters;
   string referenceSequence;
+  unsigned int referenceSequenceID;
   vector<int> reducedPosition;
  
   // Ref and alt allele information.
@@ -67,10 +75,25 @@ struct originalVariants {
   vector<string> reducedAlts;
   vector<variantType> type;
 
+  // When intersecting many files, the files (one bit per file) sharing the
+  // alleles that are kept.
+  uint64_t sources;
+
   // Genotype information.
   bool hasGenotypes;
   string genotypeFormat;
   string genotypes;
+
+  // Empty the allele vectors before the structure is reused.  The fields
+  // that are not vectors are always set when a record is stored.
+  void clearAlleles() {
+    reducedPosition.clear();
+    filtered.clear();
+    reducedRef.clear();
+    alts.clear();
+    reducedAlts.clear();
+    type.clear();
+  }
 };
 
 // Define a structure that stores the information about the
@@ -94,14 +117,40 @@ struct reducedVariants {
 // variantsAtLocus structure holds all of the variants
 // present at this locus.
 struct variantsAtLocus {
-  string referenceSequence;
-  vector<reducedVariants> complexVariants;
-  vector<reducedVariants> deletions;
-  vector<reducedVariants> insertions;
-  vector<reducedVariants> mnps;
-  vector<reducedVariants> snps;
-  vector<reducedVariants> svs;
-  vector<reducedVariants> rearrangements;
+  variantsAtLocus(void) : referenceSequenceID(NO_CONTIG) {}
+
+  unsigned int referenceSequenceID;
+  recycledVector<reducedVariants> complexVariants;
+  recycledVector<reducedVariants> deletions;
+  recycledVector<reducedVariants> insertions;
+  recycledVector<reducedVariants> mnps;
+  recycledVector<reducedVariants> snps;
+  recycledVector<reducedVariants> svs;
+  recycledVector<reducedVariants> rearrangements;
+
+  // Empty the structure, keeping the variants for reuse.
+  void clear() {
+    referenceSequenceID = NO_CONTIG;
+    complexVariants.clear();
+    deletions.clear();
+    insertions.clear();
+    mnps.clear();
+    snps.clear();
+    svs.clear();
+    rearrangements.clear();
+  }
+
+  // Exchange the contents with another structure.
+  void swap(variantsAtLocus& other) {
+    std::swap(referenceSequenceID, other.referenceSequenceID);
+    complexVariants.swap(other.complexVariants);
+    deletions.swap(other.deletions);
+    insertions.swap(other.insertions);
+    mnps.swap(other.mnps);
+    snps.swap(other.snps);
+    svs.swap(other.svs);
+    rearrangements.swap(other.rearrangements);
+  }
 };
 
 // Define a structure that contains information about the different reference
@@ -120,39 +169,44 @@ class variant {
     variant(void);
     ~variant(void);
     void addVariantToStructure(int, variantDescription&);
-    void annotateRecordBed(bedRecord&);
+    void annotateRecordBed(originalVariants&, bedRecord&);
     void annotateRecordVcf(variant&, int, unsigned int, string&, string&);
     void buildOutputRecord(output&, vcfHeader&);
     bool buildVariantStructure(vcf&);
     void clearOriginalVariants(vcfHeader&, intFlags&, output&, bool);
-    void clearReferenceSequence(vcfHeader&, vcf&, intFlags, string, output&, bool);
-    void clearReferenceSequenceBed(vcfHeader&, vcf&, intFlags, string, output&);
+    void clearReferenceSequence(vcfHeader&, vcf&, intFlags, unsigned int, output&, bool);
+    void clearReferenceSequenceBed(vcfHeader&, vcf&, intFlags, unsigned int, output&);
     void clearType(variantType&);
     void compareVariantsSameLocus(variant&, intFlags);
-    void compareAlleles(vector<reducedVariants>&, vector<reducedVariants>&, intFlags, variant&);
+    void compareAlleles(recycledVector<reducedVariants>&, recycledVector<reducedVariants>&, intFlags, variant&);
     void determineVariantsToProcess(bool, bool, bool, bool, bool, bool, bool, bool, bool);
-    void determineVariantType(string, int, string, string, variantType&, int, originalVariants&);
+    void determineVariantType(string&, int, const string&, const string&, variantType&, int, originalVariants&);
     void filterUnique();
-    void updateVariantMaps(string, variantType, string, string, int, string, originalVariants&);
+    void matchAlleles(recycledVector<reducedVariants>&, recycledVector<reducedVariants>&, bool, vector<int>&, vector<bool>&);
+    void updateVariantMaps(const string&, variantType&, const string&, const string&, int, originalVariants&);
 
   public:
     unsigned int recordsInMemory;
     string referenceSequence;
-    //string fasta;
+
+    // The reference fasta file used to left align indels.
+    string fasta;
 
     // Structure containing variant information at a particular locus
     // after the variants have been deconstructed.  For example a variant
     // included in the vcf file as CC -> TT,CG at position x, is broken
     // into CC -> TT at position x and C -> G at x+1.  The original alleles
-    // and positions are stored in the originalVariantsMap.
-    map<int, variantsAtLocus> variantMap;
-    map<int, variantsAtLocus>::iterator vmIter;
+    // and positions are stored in the originalVariantsMap.  Both structures
+    // are position ordered ring buffers holding a window of the sorted file.
+    positionBuffer<variantsAtLocus> variantMap;
+    positionBuffer<variantsAtLocus>::iterator vmIter;
 
     // Structure containing variant information in the order that it
-    // appeared in the vcf file.
-    map<int, vector<originalVariants> > originalVariantsMap;
-    map<int, vector<originalVariants> >::iterator ovmIter;
-    vector<originalVariants>::iterator ovIter;
+    // appeared in the vcf file.  The records of erased loci are kept and
+    // reused for later records.
+    positionBuffer<recycledVector<originalVariants> > originalVariantsMap;
+    positionBuffer<recycledVector<originalVariants> >::iterator ovmIter;
+    recycledVector<originalVariants>::iterator ovIter;
 
     // Samples information.
     vector<string> samples;
@@ -161,6 +215,10 @@ class variant {
     map<string, refSeqInfo> referenceSequenceInfo;
     map<string, refSeqInfo>::iterator refSeqIter;
 
+    // Warnings about modified variants are written to this stream (cerr by
+    // default).
+    ostream* errorStream;
+
     // Variables for handling realigning with the Smith Waterman algorithm.
     string originalRef;
     string originalAlt;
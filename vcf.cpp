@@ -10,11 +10,13 @@
 
 #include "vcf.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <cstdlib>
 #include <ctype.h>
+#include <limits.h>
 #include <vector>
 
 using namespace std;
@@ -22,19 +24,43 @@ using namespace vcfCTools;
 
 // Constructor.
 vcf::vcf(void) {
-  hasGenotypes     = true;
-  processGenotypes = false;
-  success          = true;
+  compressedInput      = NULL;
+  currentChunk         = 0;
+  input                = NULL;
+  minimumStart         = 0;
+  decompressionThreads = threadPool::availableCores() - 1;
+  errorStream          = &cerr;
+  hasGenotypes         = true;
+  hasRegions           = false;
+  newReferenceSequence = true;
+  numberFields         = 0;
+  processGenotypes     = false;
+  regionIndex          = NULL;
+  success              = true;
+  useIndex             = false;
+
+  variantRecord.referenceSequenceID = NO_CONTIG;
 }
 
 // Destructor.
-vcf::~vcf(void)
-{}
+vcf::~vcf(void) {
+  if (compressedInput != NULL) {delete compressedInput;}
+}
 
-// Open a vcf file.
+// Open a vcf file.  Compressed files (BGZF or gzip) are recognised from
+// their contents and read through the decompressing stream buffer.
 bool vcf::openVcf(string filename) {
   vcfFilename = filename;
-  if (vcfFilename != "-") {
+  if (vcfFilename != "-" && bgzfInputBuffer::isCompressed(vcfFilename)) {
+    if (!compressedBuffer.open(vcfFilename, decompressionThreads)) {
+      cerr << "Failed to open file: " << vcfFilename << endl;
+      exit(1);
+    }
+    if (compressedInput == NULL) {compressedInput = new istream(&compressedBuffer);}
+    compressedInput->clear();
+    input = compressedInput;
+  }
+  else if (vcfFilename != "-") {
     file.open(vcfFilename.c_str(), ifstream::in);
     input = &file;
     if (!file.is_open()) {
@@ -43,11 +69,15 @@ bool vcf::openVcf(string filename) {
     }
   }
   else {input = &cin;}
+
+  return true;
 }
 
 // Close the vcf file.
 void vcf::closeVcf() {
-  if (vcfFilename != "-") {
+  reader.stop();
+  if (input == compressedInput) {compressedBuffer.close();}
+  else if (vcfFilename != "-") {
     file.close();
     if (file.is_open()) {
       cerr << "Failed to close file: " << vcfFilename << endl;
@@ -55,63 +85,253 @@ void vcf::closeVcf() {
   }
 }
 
-// Get the next record from the vcf file.
+// Read the next line from the file.  If an index is being used, move to
+// the next chunk of the file containing records in the requested regions
+// first.
+bool vcf::readLine(string& line) {
+  if (useIndex && !nextChunk()) {return false;}
+
+  return getline(*input, line);
+}
+
+// Read the remainder of the file on a separate thread.  This must be
+// called after the header has been read and any regions have been set.
+void vcf::startReader() {
+  reader.start(this);
+}
+
+// Get the next record from the vcf file.  If regions have been set, records
+// outside of the regions are skipped.
 bool vcf::getRecord() {
+  do {
 
-// Read in the vcf record.
-  //success = true;
-  //if (fromHeader) {fromHeader = false;}
-  //else {success = getline(*input, record);}
-  success = getline(*input, record);
-
-// Return false if no more records remain.
-  if (!success) {return false;}
-
-// Break the record up into its individual parts.  Leave the genotype fields
-// as a string for now.  If the genotypes require parsing, this can be broken
-// up when it is needed.
-  vector<string> recordFields = split(record, '\t', 10);
-
-// Resolve the information for this variant and add to a temporary structure.
-// This will be added to the map of variants when all information has been
-// collated.
-  variantRecord.referenceSequence = recordFields[0];
-  position                        = atoi(recordFields[1].c_str());
-  variantRecord.rsid              = recordFields[2];
-  variantRecord.ref               = recordFields[3];
-  variantRecord.altString         = recordFields[4];
-  variantRecord.quality           = atof(recordFields[5].c_str());
-  variantRecord.filters           = recordFields[6];
-  variantRecord.info              = recordFields[7];
-
-  // Check that genotypes exist.
-  if (recordFields.size() < 9) {
-    hasGenotypes = false;
-    variantRecord.hasGenotypes = false;
-  } else {
-    hasGenotypes = true;
-    variantRecord.hasGenotypes = true;
-    variantRecord.genotypeFormatString = recordFields[8];
-    variantRecord.genotypeString = recordFields[9];
-  }
+  // Read in the vcf record, either from the reader thread or from the file.
+    //success = true;
+    //if (fromHeader) {fromHeader = false;}
+    //else {success = getline(*input, record);}
+    success = reader.running ? reader.getLine(record) : readLine(record);
+
+  // Return false if no more records remain.
+    if (!success) {return false;}
 
-  // If the position is not an integer, the conversion to an integer will have
-  // failed and position = 0.  In this case, terminate with an error.
+  // Break the record up into its individual parts.  The fields are recorded as
+  // spans of the record string and are only copied into the variant description
+  // if they are used.  The genotype fields are left as a single span for now.  If
+  // the genotypes require parsing, this can be broken up when it is needed.
+    numberFields = splitSpans(record, '\t', recordFields, 10);
+    if (numberFields < 8) {
+      cerr << "ERROR: vcf record has fewer than eight fields:" << endl;
+      cerr << record << endl;
+      exit(1);
+    }
+
+  // Resolve the information for this variant and add to a temporary structure.
+  // This will be added to the map of variants when all information has been
+  // collated.  The reference sequence is only copied (and its ID looked up)
+  // if it has changed since the last record.
+    const char* recordStart = record.c_str();
+    if (record.compare(recordFields[0].start, recordFields[0].length, variantRecord.referenceSequence) != 0) {
+      assignField(0, variantRecord.referenceSequence);
+      variantRecord.referenceSequenceID = sharedContigs().getID(variantRecord.referenceSequence);
+      newReferenceSequence = true;
+    } else {
+      newReferenceSequence = false;
+    }
+    position              = atoi(recordStart + recordFields[1].start);
+    variantRecord.quality = atof(recordStart + recordFields[5].start);
+    assignField(5, variantRecord.qualityString);
+    assignField(2, variantRecord.rsid);
+    assignField(3, variantRecord.ref);
+    assignField(4, variantRecord.altString);
+    assignField(6, variantRecord.filters);
+    assignField(7, variantRecord.info);
+
+    // Check that genotypes exist.
+    if (numberFields < 10) {
+      hasGenotypes = false;
+      variantRecord.hasGenotypes = false;
+    } else {
+      hasGenotypes = true;
+      variantRecord.hasGenotypes = true;
+      assignField(8, variantRecord.genotypeFormatString);
+      assignField(9, variantRecord.genotypeString);
+    }
+  } while (hasRegions && !inRegion());
+
+// If the position is not an integer, the conversion to an integer will have
+// failed and position = 0.  The checks are made once the record is known to
+// be kept, so that records skipped by the regions are not reported.
   if (position == 0 || variantRecord.quality == 0) {
-    if (position == 0) {cerr << "ERROR: Unable to process variant position (not an integer)." << endl;}
-    if (variantRecord.quality == 0 && recordFields[5] != "0" && recordFields[5] != ".") {
-      cerr << "ERROR: Variant quality is not an integer or a floating point number." << endl;
+    if (position == 0) {*errorStream << "ERROR: Unable to process variant position (not an integer)." << endl;}
+    if (variantRecord.quality == 0 && record.compare(recordFields[5].start, recordFields[5].length, "0") != 0 &&
+        record.compare(recordFields[5].start, recordFields[5].length, ".") != 0) {
+      *errorStream << "ERROR: Variant quality is not an integer or a floating point number." << endl;
     }
   }
 
 // Add the reference sequence to the map.  If it didn't previously
 // exist append the reference sequence to the end of the list as well. 
 // This ensures that the order in which the reference sequences appeared
-// in the header can be preserved.
-  if (referenceSequences.count(variantRecord.referenceSequence) == 0) {
+// in the header can be preserved.  If records are being skipped, the
+// previous record read may not have been kept, so always check.
+  if ((newReferenceSequence || hasRegions) && referenceSequences.count(variantRecord.referenceSequence) == 0) {
     referenceSequences[variantRecord.referenceSequence] = true;
     referenceSequenceVector.push_back(variantRecord.referenceSequence);
   }
 
   return success;
 }
+
+// Copy a field from the tokenised record into a string.  The string is
+// assigned in place, so its existing storage is reused where possible.
+void vcf::assignField(unsigned int field, string& value) {
+  value.assign(record, recordFields[field].start, recordFields[field].length);
+}
+
+// Order regions by their end coordinate.
+static bool regionEndsBefore(const genomicRegion& region, int position) {
+  return region.end < position;
+}
+
+// Order regions by their start coordinate.
+static bool compareRegions(const genomicRegion& a, const genomicRegion& b) {
+  return a.start < b.start;
+}
+
+// Parse a region of the form chr, chr:start or chr:start-end.  Coordinates
+// are 1-based and inclusive.
+bool vcf::parseRegion(string& regionString, genomicRegion& region) {
+  region.referenceSequence = regionString;
+  region.start             = 1;
+  region.end               = INT_MAX;
+
+  size_t found = regionString.rfind(":");
+  if (found == string::npos) {return regionString != "";}
+
+  string coordinates       = regionString.substr(found + 1);
+  region.referenceSequence = regionString.substr(0, found);
+  size_t dash              = coordinates.find("-");
+  string start             = coordinates.substr(0, dash);
+  string end               = (dash == string::npos) ? "" : coordinates.substr(dash + 1);
+
+  if (region.referenceSequence == "" || start == "" || start.find_first_not_of("0123456789") != string::npos) {return false;}
+  if (end.find_first_not_of("0123456789") != string::npos) {return false;}
+  region.start = atoi(start.c_str());
+  if (end != "") {region.end = atoi(end.c_str());}
+
+  return region.start > 0 && region.end >= region.start;
+}
+
+// Parse a comma separated list of regions.
+void vcf::parseRegions(string& regionString, vector<genomicRegion>& regionList) {
+  vector<string> regionStrings = split(regionString, ",");
+
+  regionList.clear();
+  for (vector<string>::iterator iter = regionStrings.begin(); iter != regionStrings.end(); iter++) {
+    genomicRegion region;
+    if (!parseRegion(*iter, region)) {
+      cerr << "ERROR: Unable to parse region: " << *iter << endl;
+      cerr << "Regions should be of the form chr, chr:start or chr:start-end." << endl;
+      exit(1);
+    }
+    regionList.push_back(region);
+  }
+}
+
+// Sort and merge a list of regions on the same reference sequence, so
+// that the overlapping region for a record can be found with a binary
+// search.
+void vcf::mergeRegions(vector<genomicRegion>& regionList) {
+  if (regionList.size() < 2) {return;}
+
+  sort(regionList.begin(), regionList.end(), compareRegions);
+  vector<genomicRegion>::iterator last = regionList.begin();
+  for (vector<genomicRegion>::iterator iter = regionList.begin() + 1; iter != regionList.end(); iter++) {
+    if (iter->start <= last->end) {last->end = max(last->end, iter->end);}
+    else {*(++last) = *iter;}
+  }
+  regionList.erase(last + 1, regionList.end());
+}
+
+// Restrict reading to a comma separated list of regions.  This must be
+// called after the header has been read.
+void vcf::setRegions(string& regionString) {
+  vector<genomicRegion> regionList;
+
+  parseRegions(regionString, regionList);
+  setRegions(regionList);
+}
+
+// Restrict reading to a list of regions.  If an index exists, it is used
+// to find the chunks of the file containing the regions.  An index that
+// has already been read can be supplied, so that files opened for each
+// of a number of regions in parallel share a single copy of the index.
+void vcf::setRegions(vector<genomicRegion>& regionList, tabixIndex* sharedIndex) {
+  regions.clear();
+  regionChunks.clear();
+  for (vector<genomicRegion>::iterator iter = regionList.begin(); iter != regionList.end(); iter++) {
+    regions[iter->referenceSequence].push_back(*iter);
+  }
+  for (map<string, vector<genomicRegion> >::iterator iter = regions.begin(); iter != regions.end(); iter++) {
+    mergeRegions(iter->second);
+  }
+  hasRegions = true;
+
+  // Find the chunks of the file to read.
+  useIndex    = false;
+  regionIndex = NULL;
+  if (input == compressedInput && compressedBuffer.isBgzf) {
+    if (sharedIndex != NULL) {regionIndex = sharedIndex;}
+    else if (index.openIndex(vcfFilename)) {regionIndex = &index;}
+  }
+  if (regionIndex != NULL) {
+    vector<indexChunk> chunks;
+    for (map<string, vector<genomicRegion> >::iterator iter = regions.begin(); iter != regions.end(); iter++) {
+      for (vector<genomicRegion>::iterator rIter = iter->second.begin(); rIter != iter->second.end(); rIter++) {
+        regionIndex->query(*rIter, chunks);
+        regionChunks.insert(regionChunks.end(), chunks.begin(), chunks.end());
+      }
+    }
+    tabixIndex::mergeChunks(regionChunks);
+    currentChunk = 0;
+    useIndex     = true;
+  } else {
+    cerr << "WARNING: No index found for " << vcfFilename << ".  The whole file will be read to find the requested regions." << endl;
+  }
+}
+
+// Make sure that the next record is read from a chunk containing records
+// in the requested regions, seeking forward to the next chunk if necessary.
+// Returns false when all chunks have been read.
+bool vcf::nextChunk() {
+  while (currentChunk < regionChunks.size()) {
+    indexChunk& chunk = regionChunks[currentChunk];
+    uint64_t offset   = compressedBuffer.tell();
+
+    if (offset < chunk.start) {
+      if (!compressedBuffer.seek(chunk.start)) {
+        cerr << "ERROR: Unable to seek to the indexed position in file: " << vcfFilename << endl;
+        cerr << "The index (" << regionIndex->indexFilename << ") may be out of date." << endl;
+        exit(1);
+      }
+      input->clear();
+      return true;
+    }
+    if (offset < chunk.end) {return true;}
+    currentChunk++;
+  }
+
+  return false;
+}
+
+// Determine if the current record overlaps any of the requested regions.
+// The record spans the bases of the reference allele.
+bool vcf::inRegion() {
+  map<string, vector<genomicRegion> >::iterator iter = regions.find(variantRecord.referenceSequence);
+  if (iter == regions.end()) {return false;}
+
+  int end = position + (int) variantRecord.ref.size() - 1;
+  vector<genomicRegion>::iterator rIter = lower_bound(iter->second.begin(), iter->second.end(), position, regionEndsBefore);
+
+  return rIter != iter->second.end() && rIter->start <= end && position >= minimumStart;
+}
@@ -11,7 +11,11 @@
 #ifndef VCF_H
 #define VCF_H
 
+#include "bgzf.h"
+#include "contig_dictionary.h"
+#include "pipeline.h"
 #include "split.h"
+#include "tabix.h"
 #include "vcf_aux.h"
 
 #include <cstdlib>
@@ -21,6 +25,7 @@
 #include <string>
 #include <stdlib.h>
 #include <map>
+#include <vector>
 
 using namespace std;
 
@@ -36,10 +41,12 @@ struct variantDescription {
   // Variant descriptions.
   string record;
   string referenceSequence;
+  unsigned int referenceSequenceID;
   string rsid;
   string ref;
   string altString;
   double quality;
+  string qualityString;
   string filters;
   string info;
   bool hasGenotypes;
@@ -71,20 +78,63 @@ class vcf {
 
     // Variant reading and structures.
     bool getRecord();
+    bool readLine(string&);
+    void startReader();
+    void assignField(unsigned int, string&);
+
+    // Region restricted reading.
+    void setRegions(string&);
+    void setRegions(vector<genomicRegion>&, tabixIndex* sharedIndex = NULL);
+    static bool parseRegion(string&, genomicRegion&);
+    static void parseRegions(string&, vector<genomicRegion>&);
+    static void mergeRegions(vector<genomicRegion>&);
+    bool nextChunk();
+    bool inRegion();
 
   public:
     istream* input;
     ifstream file;
     string vcfFilename;
+
+// Compressed (BGZF or gzip) input.  BGZF blocks are inflated on a pool
+// of decompressionThreads worker threads.
+    bgzfInputBuffer compressedBuffer;
+    istream* compressedInput;
+    unsigned int decompressionThreads;
+
+// Lines can be read ahead on a separate thread while the records are
+// processed.
+    lineReader reader;
+
+// Regions to read (sorted and merged for each reference sequence).  If
+// the file is BGZF compressed and has a tabix or CSI index, only the
+// chunks of the file overlapping the regions are read, otherwise the
+// whole file is read and records outside of the regions are skipped.
+// Records starting before minimumStart are also skipped, so that files
+// split into regions for parallel processing read each record once.
+    bool hasRegions;
+    int minimumStart;
+    bool useIndex;
+    tabixIndex index;
+    tabixIndex* regionIndex;
+    map<string, vector<genomicRegion> > regions;
+    vector<indexChunk> regionChunks;
+    unsigned int currentChunk;
     
-// Keep track of when a record is read successfully.
+// Keep track of when a record is read successfully.  Errors in the records
+// read are written to errorStream.
     bool success;
+    ostream* errorStream;
     bool update;
 
-// variant information.
+// variant information.  The record is tokenised into spans (offset and length)
+// of the record string, so fields are only copied when they are needed.
     string record;
+    vector<stringSpan> recordFields;
+    unsigned int numberFields;
     variantDescription variantRecord;
     string referenceSequence;
+    bool newReferenceSequence;
     vector<string> referenceSequenceVector;
     map<string, bool> referenceSequences;
     int position;
@@ -14,8 +14,11 @@
 #include "tool_filter.h"
 #include "tool_intersect.h"
 #include "tool_merge.h"
+#include "tool_normalize.h"
+#include "tool_sort.h"
 #include "tool_stats.h"
 #include "tool_validate.h"
+#include "tool_view.h"
 #include "vcfCTools_version.h"
 
 #include <cstdio>
@@ -32,8 +35,11 @@ static const string ANNOTATE      = "annotate";
 static const string FILTER        = "filter";
 static const string INTERSECT     = "intersect";
 static const string MERGE         = "merge";
+static const string NORMALIZE     = "normalize";
+static const string SORT          = "sort";
 static const string STATS         = "stats";
 static const string VALIDATE      = "validate";
+static const string VIEW          = "view";
 
 // help and version
 static const string HELP          = "help";
@@ -60,8 +66,11 @@ AbstractTool* CreateTool(const string& arg) {
   if (arg == FILTER        ) return new filterTool;
   if (arg == INTERSECT     ) return new intersectTool;
   if (arg == MERGE         ) return new mergeTool;
+  if (arg == NORMALIZE     ) return new normalizeTool;
+  if (arg == SORT          ) return new sortTool;
   if (arg == STATS         ) return new statsTool;
   if (arg == VALIDATE      ) return new validateTool;
+  if (arg == VIEW          ) return new viewTool;
 
   return 0;
 }
@@ -83,8 +92,11 @@ int Help(int argc, char* argv[]) {
   cout << "  filter:\n\tFilter the vcf file on specified criteria and populate the filter field." << endl;
   cout << "  intersect:\n\tCalculate the intersection of two vcf files (or a vcf and a bed file)." << endl;
   cout << "  merge:\n\tMerge a list of vcf files." << endl;
+  cout << "  normalize:\n\tTrim and left align the alleles of a vcf file." << endl;
+  cout << "  sort:\n\tSort a vcf file by reference sequence and position." << endl;
   cout << "  stats:\n\tGenerate statistics on a vcf file." << endl;
   cout << "  validate:\n\tValidate a vcf file." << endl;
+  cout << "  view:\n\tWrite out a vcf file with the genotypes of a subset of the samples." << endl;
   cout << endl;
   cout << "vcfCTools help tool for help on a specific tool." << endl << endl;
   return 0;
@@ -13,6 +13,10 @@
 
 using namespace std;
 
+// The number of diagonals either side of the alleles searched by the
+// banded alignment (as used in modify_alleles.cpp).
+#define ALIGNMENT_BAND_MARGIN 8
+
 // Align the alt to the ref allele using a Smith-Waterman algorithm
 // and find the start position of the reference
 unsigned int alignAlternate(string referenceSequence, int position, string& ref, string& alt, string& alRef, string& alAlt, string refFa) {
@@ -32,7 +36,7 @@ unsigned int alignAlternate(string referenceSequence, int position, string& ref,
     getFlankingReference(referenceSequence, position, ref, alt, flankLength, flankFront, flankEnd, refFa);
     swRef = flankFront + ref + flankEnd;
     swAlt = flankFront + alt + flankEnd;
-    smithWaterman(referenceSequence, position, swRef, swAlt, alRef, alAlt);
+    smithWaterman(referenceSequence, position, swRef, swAlt, max(ref.length(), alt.length()) + ALIGNMENT_BAND_MARGIN, alRef, alAlt);
     flankLength = flankFront.length();
 
     //if ( alRef.substr(0, flankLength) != alAlt.substr(0,flankLength) ||
@@ -109,15 +113,16 @@ void getFlankingReference(string referenceSequence, int position, string ref, st
     if (frontPos <= 0) {frontPos = 1;}
   }
 
-  FastaReference* fr = new FastaReference(refFa);
-  string flank = fr->getSubSequence(referenceSequence, frontPos, length);
+  string flank = vcfCTools::sharedFasta(refFa).getSubSequence(referenceSequence, frontPos, length);
 
   flankFront = flank.substr(0, flankLength);
   flankEnd   = flank.substr(flankLength + ref.length(), flankLength);
 }
 
-// Align two sequences using a Smith-Waterman alignment.
-void smithWaterman(string referenceSequence, int position, string ref, string alt, string& alRef, string& alAlt) {
+// Align two sequences using a Smith-Waterman alignment.  The sequences share
+// their flanks, so only the band of diagonals within bandWidth of the
+// corners is filled.
+void smithWaterman(string referenceSequence, int position, string ref, string alt, unsigned int bandWidth, string& alRef, string& alAlt) {
 
 // Initialise Smith-Waterman parameters.
   unsigned int referencePos;
@@ -139,5 +144,5 @@ void smithWaterman(string referenceSequence, int position, string ref, string al
   const unsigned int queryLen     = strlen(query);
   alRef = "", alAlt = "";
   CSmithWatermanGotoh sw(matchScore, mismatchScore, gapOpenPenalty, gapExtendPenalty);
-  sw.Align(referencePos, alRef, alAlt, reference, referenceLen, query, queryLen);
+  sw.BandedAlign(referencePos, alRef, alAlt, reference, referenceLen, query, queryLen, bandWidth);
 }
@@ -23,6 +23,7 @@
 #include <algorithm>
 
 #include "Fasta.h"
+#include "mapped_fasta.h"
 #include "SmithWatermanGotoh.h"
 #include "split.h"
 
@@ -30,6 +31,6 @@ using namespace std;
 
 unsigned int alignAlternate(string, int, string&, string&, string&, string&, string);
 void getFlankingReference(string, int, string, string, unsigned int, string&, string&, string);
-void smithWaterman(string, int, string, string, string&, string&);
+void smithWaterman(string, int, string, string, unsigned int, string&, string&);
 
 #endif